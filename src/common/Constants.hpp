@@ -11,6 +11,10 @@ namespace bb {
     inline constexpr int         IPC_READ_TIMEOUT_MS    = 1000;
     inline constexpr int         IPC_WRITE_TIMEOUT_MS   = 1000;
 
+    // Daemon output backpressure per client
+    inline constexpr std::size_t IPC_WRITE_LOW_WATERMARK  = 256 * 1024;  // resume writing below this
+    inline constexpr std::size_t IPC_WRITE_HIGH_WATERMARK = 1024 * 1024; // apply overflow policy above this
+
     // Pinentry timeouts
     inline constexpr int PINENTRY_REQUEST_TIMEOUT_MS = 5 * 60 * 1000; // 5 minutes
     inline constexpr int PINENTRY_RESULT_TIMEOUT_MS  = 10 * 1000;     // wait for terminal result after submit
@@ -18,6 +22,10 @@ namespace bb {
     // Authentication
     inline constexpr int MAX_AUTH_RETRIES = 3;
 
+    // A launched provider's pre-connected, pre-registered daemon connection
+    inline constexpr int         PROVIDER_HANDOFF_FD  = 3;
+    inline constexpr const char* PROVIDER_HANDOFF_ENV = "BB_AUTH_PROVIDER_FD";
+
     namespace json {
         // Keys
         inline constexpr const char* KEY_TYPE         = "type";
@@ -31,6 +39,11 @@ namespace bb {
         inline constexpr const char* KEY_PRIORITY     = "priority";
         inline constexpr const char* KEY_ACTIVE       = "active";
         inline constexpr const char* KEY_MESSAGE      = "message";
+        inline constexpr const char* KEY_ENCODING     = "encoding";
+        inline constexpr const char* KEY_ENCODINGS    = "encodings";
+        inline constexpr const char* KEY_REQUEST_ID   = "requestId";
+        inline constexpr const char* KEY_REASON       = "reason";
+        inline constexpr const char* KEY_QUIESCENT    = "quiescent";
 
         // Values
         inline constexpr const char* VAL_PING          = "ping";
@@ -38,6 +51,8 @@ namespace bb {
         inline constexpr const char* VAL_ERROR         = "error";
         inline constexpr const char* VAL_UI_ACTIVE     = "ui.active";
         inline constexpr const char* VAL_UI_REGISTERED = "ui.registered";
+        inline constexpr const char* VAL_UI_SHUTDOWN   = "ui.shutdown";
+        inline constexpr const char* VAL_UI_PING       = "ui.ping"; // answered with ui.heartbeat
         inline constexpr const char* VAL_SUBSCRIBED    = "subscribed";
         inline constexpr const char* VAL_PONG          = "pong";
         inline constexpr const char* VAL_POLKIT        = "polkit";
@@ -45,6 +60,9 @@ namespace bb {
         inline constexpr const char* VAL_PINENTRY      = "pinentry";
         inline constexpr const char* VAL_FINGERPRINT   = "fingerprint";
         inline constexpr const char* VAL_FIDO2         = "fido2";
+        inline constexpr const char* VAL_JSON          = "json";
+        inline constexpr const char* VAL_CBOR          = "cbor";
+        inline constexpr const char* VAL_QUIESCENT     = "quiescent"; // no heartbeats; probed with ui.ping before a prompt
     }
 
 } // namespace bb
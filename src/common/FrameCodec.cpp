@@ -0,0 +1,58 @@
+#include "FrameCodec.hpp"
+#include "Constants.hpp"
+
+#include <QCborMap>
+#include <QCborStreamWriter>
+#include <QCborValue>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QtEndian>
+
+namespace bb {
+
+    QByteArray encodeFrame(const QJsonObject& message, FrameEncoding encoding) {
+        if (encoding == FrameEncoding::Cbor) {
+            // Reserve the prefix and stream the map straight behind it
+            QByteArray frame(CBOR_FRAME_HEADER_SIZE, '\0');
+            {
+                QCborStreamWriter writer(&frame);
+                QCborMap::fromJsonObject(message).toCborValue().toCbor(writer);
+            }
+            qToBigEndian<quint32>(static_cast<quint32>(frame.size() - CBOR_FRAME_HEADER_SIZE), frame.data());
+            return frame;
+        }
+
+        QByteArray frame = QJsonDocument(message).toJson(QJsonDocument::Compact);
+        frame.append('\n');
+        return frame;
+    }
+
+    std::optional<QJsonObject> decodeFrame(QByteArrayView payload, FrameEncoding encoding) {
+        if (encoding == FrameEncoding::Cbor) {
+            QCborParserError parseError;
+            const QCborValue value = QCborValue::fromCbor(payload.data(), payload.size(), &parseError);
+            if (parseError.error != QCborError::NoError || !value.isMap()) {
+                return std::nullopt;
+            }
+            return value.toMap().toJsonObject();
+        }
+
+        QJsonParseError parseError;
+        const auto      doc = QJsonDocument::fromJson(QByteArray::fromRawData(payload.data(), payload.size()), &parseError);
+        if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+            return std::nullopt;
+        }
+        return doc.object();
+    }
+
+    FrameEncoding requestedEncoding(const QJsonObject& message) {
+        const QJsonArray capabilities = message.value(json::KEY_CAPABILITIES).toArray();
+        return capabilities.contains(QLatin1String(json::VAL_CBOR)) ? FrameEncoding::Cbor : FrameEncoding::Json;
+    }
+
+    QString encodingName(FrameEncoding encoding) {
+        return encoding == FrameEncoding::Cbor ? QString::fromLatin1(json::VAL_CBOR) : QString::fromLatin1(json::VAL_JSON);
+    }
+
+} // namespace bb
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QJsonObject>
+#include <QString>
+
+#include <optional>
+
+namespace bb {
+
+    // Wire encoding of a single IPC frame
+    // Json: one compact object terminated by '\n' (default)
+    // Cbor: 4-byte big-endian payload length followed by a CBOR map
+    enum class FrameEncoding {
+        Json,
+        Cbor
+    };
+
+    // A length prefix always starts with 0x00 for frames within MAX_MESSAGE_SIZE,
+    // which never begins a JSON line, so receivers can auto-detect each frame.
+    inline constexpr qsizetype CBOR_FRAME_HEADER_SIZE = 4;
+
+    // Encode one message as a complete frame, terminator or length prefix included
+    QByteArray                 encodeFrame(const QJsonObject& message, FrameEncoding encoding);
+
+    // Decode a frame payload; std::nullopt unless it holds a single object
+    std::optional<QJsonObject> decodeFrame(QByteArrayView payload, FrameEncoding encoding);
+
+    // Encoding a peer opted into through its "capabilities" array
+    FrameEncoding              requestedEncoding(const QJsonObject& message);
+
+    QString                    encodingName(FrameEncoding encoding);
+
+} // namespace bb
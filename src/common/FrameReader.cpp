@@ -0,0 +1,140 @@
+#include "FrameReader.hpp"
+
+#include <QIODevice>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+namespace bb {
+
+    namespace {
+
+        inline constexpr qsizetype MIN_BUFFER_SIZE = 4096;
+
+    } // namespace
+
+    FrameReader::FrameReader(qsizetype maxFrameSize) : m_maxFrameSize(maxFrameSize) {}
+
+    qint64 FrameReader::readFrom(QIODevice& device) {
+        const qint64 available = device.bytesAvailable();
+        if (available <= 0) {
+            return 0;
+        }
+
+        const qsizetype chunk = static_cast<qsizetype>(std::min<qint64>(available, m_maxFrameSize));
+        char*           tail  = reserveTail(chunk);
+        const qint64    got   = device.read(tail, chunk);
+        if (got > 0) {
+            m_endPos += static_cast<qsizetype>(got);
+        }
+        return got;
+    }
+
+    void FrameReader::append(QByteArrayView data) {
+        if (data.isEmpty()) {
+            return;
+        }
+
+        char* tail = reserveTail(data.size());
+        std::memcpy(tail, data.data(), static_cast<std::size_t>(data.size()));
+        m_endPos += data.size();
+    }
+
+    std::optional<Frame> FrameReader::nextFrame() {
+        while (!m_overflowed && m_readPos < m_endPos) {
+            const char* base = m_buffer.constData();
+            if (base[m_readPos] == '\0') {
+                return nextCborFrame();
+            }
+
+            const void* hit = std::memchr(base + m_scanPos, '\n', static_cast<std::size_t>(m_endPos - m_scanPos));
+            if (!hit) {
+                m_scanPos = m_endPos;
+                if ((m_endPos - m_readPos) > m_maxFrameSize) {
+                    m_overflowed = true;
+                }
+                return std::nullopt;
+            }
+
+            const qsizetype newline = static_cast<const char*>(hit) - base;
+            const qsizetype start   = m_readPos;
+            m_readPos               = newline + 1;
+            m_scanPos               = m_readPos;
+
+            if ((newline - start) > m_maxFrameSize) {
+                m_overflowed = true;
+                return std::nullopt;
+            }
+
+            const QByteArrayView line = QByteArrayView(base + start, newline - start).trimmed();
+            if (!line.isEmpty()) {
+                return Frame{line, FrameEncoding::Json};
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<Frame> FrameReader::nextCborFrame() {
+        const qsizetype pending = m_endPos - m_readPos;
+        if (pending < CBOR_FRAME_HEADER_SIZE) {
+            return std::nullopt;
+        }
+
+        const char*   base   = m_buffer.constData();
+        const quint32 length = qFromBigEndian<quint32>(base + m_readPos);
+        if (static_cast<qint64>(length) > m_maxFrameSize) {
+            m_overflowed = true;
+            return std::nullopt;
+        }
+
+        if ((pending - CBOR_FRAME_HEADER_SIZE) < static_cast<qsizetype>(length)) {
+            return std::nullopt;
+        }
+
+        const qsizetype start = m_readPos + CBOR_FRAME_HEADER_SIZE;
+        m_readPos             = start + static_cast<qsizetype>(length);
+        m_scanPos             = m_readPos;
+        return Frame{QByteArrayView(base + start, static_cast<qsizetype>(length)), FrameEncoding::Cbor};
+    }
+
+    bool FrameReader::overflowed() const {
+        return m_overflowed;
+    }
+
+    qsizetype FrameReader::bufferedBytes() const {
+        return m_endPos - m_readPos;
+    }
+
+    void FrameReader::clear() {
+        m_readPos    = 0;
+        m_scanPos    = 0;
+        m_endPos     = 0;
+        m_overflowed = false;
+    }
+
+    char* FrameReader::reserveTail(qsizetype size) {
+        // Everything handed out has been consumed: rewind without moving bytes.
+        if (m_readPos == m_endPos) {
+            m_readPos = 0;
+            m_scanPos = 0;
+            m_endPos  = 0;
+        }
+
+        if ((m_buffer.size() - m_endPos) < size && m_readPos > 0) {
+            const qsizetype pending = m_endPos - m_readPos;
+            std::memmove(m_buffer.data(), m_buffer.constData() + m_readPos, static_cast<std::size_t>(pending));
+            m_scanPos -= m_readPos;
+            m_endPos  = pending;
+            m_readPos = 0;
+        }
+
+        if ((m_buffer.size() - m_endPos) < size) {
+            m_buffer.resize(std::max({m_endPos + size, m_buffer.size() * 2, MIN_BUFFER_SIZE}));
+        }
+
+        return m_buffer.data() + m_endPos;
+    }
+
+} // namespace bb
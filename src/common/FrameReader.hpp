@@ -0,0 +1,59 @@
+#pragma once
+
+#include "FrameCodec.hpp"
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+#include <optional>
+
+class QIODevice;
+
+namespace bb {
+
+    // One decoded frame boundary; the payload excludes terminator and prefix
+    struct Frame {
+        QByteArrayView payload;
+        FrameEncoding  encoding = FrameEncoding::Json;
+    };
+
+    // Incremental framing over a single reusable buffer.
+    // Consumed bytes are tracked with a read offset and only compacted away
+    // when the buffer needs room, so a burst of pipelined frames costs one
+    // pass over the data instead of one memmove per frame.
+    // JSON lines and length-prefixed CBOR frames may be mixed on one stream.
+    class FrameReader {
+      public:
+        explicit FrameReader(qsizetype maxFrameSize);
+
+        // Read at most maxFrameSize bytes of what the device has buffered
+        // Returns the number of bytes consumed, 0 or -1 when nothing was read
+        qint64 readFrom(QIODevice& device);
+
+        // Append raw bytes (tests and non-QIODevice callers)
+        void append(QByteArrayView data);
+
+        // Next complete frame; JSON lines are whitespace-trimmed and blank lines skipped
+        // The payload points into the internal buffer and stays valid until the
+        // next readFrom()/append()/clear() call
+        std::optional<Frame> nextFrame();
+
+        // True once a single frame grew past maxFrameSize; sticky until clear()
+        bool      overflowed() const;
+
+        qsizetype bufferedBytes() const;
+        void      clear();
+
+      private:
+        char*                reserveTail(qsizetype size);
+        std::optional<Frame> nextCborFrame();
+
+        QByteArray m_buffer;
+        qsizetype  m_maxFrameSize;
+        qsizetype  m_readPos    = 0; // first unconsumed byte
+        qsizetype  m_scanPos    = 0; // newline search resumes here
+        qsizetype  m_endPos     = 0; // end of valid data in m_buffer
+        bool       m_overflowed = false;
+    };
+
+} // namespace bb
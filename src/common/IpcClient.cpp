@@ -1,51 +1,258 @@
 #include "IpcClient.hpp"
 #include "Constants.hpp"
 
-#include <QJsonDocument>
+#include <QJsonArray>
 #include <QLocalSocket>
 
-namespace bb {
+#include <utility>
 
-    IpcClient::IpcClient(const QString& socketPath) : m_socketPath(socketPath) {}
+namespace bb {
 
-    std::optional<QJsonObject> IpcClient::sendRequest(const QJsonObject& request, int timeoutMs) {
-        QLocalSocket socket;
-        socket.connectToServer(m_socketPath);
+    IpcClient::IpcClient(const QString& socketPath, FrameEncoding encoding, QObject* parent) :
+        QObject(parent), m_socketPath(socketPath), m_encoding(encoding), m_reader(static_cast<qsizetype>(MAX_MESSAGE_SIZE)) {
+        m_deadlineTimer.setSingleShot(true);
+        connect(&m_deadlineTimer, &QTimer::timeout, this, &IpcClient::onDeadline);
+    }
 
-        if (!socket.waitForConnected(IPC_CONNECT_TIMEOUT_MS))
-            return std::nullopt;
+    IpcClient::~IpcClient() {
+        // Handlers may capture objects that are already gone; don't call them from here
+        m_inFlight.clear();
+        dropConnection();
+    }
 
-        QByteArray data = QJsonDocument(request).toJson(QJsonDocument::Compact);
-        data.append('\n');
+    qint64 IpcClient::sendRequestAsync(const QJsonObject& request, int timeoutMs, ReplyHandler handler) {
+        if (!ensureConnected()) {
+            if (handler) {
+                handler(std::nullopt);
+            }
+            return 0;
+        }
 
-        if (socket.write(data) == -1 || !socket.waitForBytesWritten(IPC_WRITE_TIMEOUT_MS))
-            return std::nullopt;
+        const qint64 requestId = m_nextRequestId++;
+        QJsonObject  tagged    = request;
+        tagged.insert(json::KEY_REQUEST_ID, requestId);
+        const QByteArray frame = encodeFrame(tagged, m_encoding);
 
-        if (!socket.waitForReadyRead(timeoutMs))
-            return std::nullopt;
+        const auto       deadline = timeoutMs < 0 ? QDeadlineTimer(QDeadlineTimer::Forever) : QDeadlineTimer(timeoutMs);
+        m_inFlight.append(PendingRequest{requestId, std::move(handler), deadline});
+        armDeadline();
 
-        // Read until we get a complete line
-        while (!socket.canReadLine()) {
-            if (!socket.waitForReadyRead(timeoutMs))
-                return std::nullopt;
+        if (m_socket->state() != QLocalSocket::ConnectedState) {
+            m_unsent.append(frame);
+        } else if (m_socket->write(frame) == -1) {
+            dropConnection();
+            failAll();
+            return 0;
+        } else {
+            m_socket->flush();
         }
 
-        const QByteArray replyLine = socket.readLine().trimmed();
-        if (replyLine.isEmpty())
-            return std::nullopt;
+        return requestId;
+    }
+
+    void IpcClient::cancel(qint64 requestId) {
+        complete(requestId, std::nullopt);
+    }
+
+    std::optional<QJsonObject> IpcClient::sendRequest(const QJsonObject& request, int timeoutMs) {
+        std::optional<QJsonObject> result;
+        bool                       done      = false;
+        const qint64               requestId = sendRequestAsync(request, -1, [&](std::optional<QJsonObject> reply) {
+            result = std::move(reply);
+            done   = true;
+        });
 
-        QJsonParseError parseError;
-        const auto      doc = QJsonDocument::fromJson(replyLine, &parseError);
+        // Drive the socket directly; waitFor* emit its signals synchronously, which completes the handler
+        const QDeadlineTimer deadline(timeoutMs);
+        while (!done && m_socket) {
+            const int remaining = static_cast<int>(deadline.remainingTime());
+            if (m_socket->state() == QLocalSocket::ConnectingState) {
+                if (!m_socket->waitForConnected(remaining < 0 ? IPC_CONNECT_TIMEOUT_MS : qMin(remaining, IPC_CONNECT_TIMEOUT_MS)))
+                    break;
+                continue;
+            }
 
-        if (parseError.error != QJsonParseError::NoError || !doc.isObject())
-            return std::nullopt;
+            if (!m_socket->waitForReadyRead(remaining))
+                break;
+        }
 
-        return doc.object();
+        if (!done) {
+            cancel(requestId);
+        }
+        return result;
     }
 
     bool IpcClient::ping() {
-        auto response = sendRequest(QJsonObject{{"type", "ping"}}, IPC_READ_TIMEOUT_MS);
+        QJsonObject request{{"type", "ping"}};
+        if (m_encoding == FrameEncoding::Cbor) {
+            request[json::KEY_CAPABILITIES] = QJsonArray{json::VAL_CBOR};
+        }
+
+        auto response = sendRequest(request, IPC_READ_TIMEOUT_MS);
         return response && response->value("type").toString() == "pong";
     }
 
+    bool IpcClient::isConnected() const {
+        return m_socket && m_socket->state() == QLocalSocket::ConnectedState;
+    }
+
+    void IpcClient::disconnectFromServer() {
+        if (isConnected()) {
+            m_socket->flush();
+        }
+        dropConnection();
+        failAll();
+    }
+
+    void IpcClient::onConnected() {
+        if (m_unsent.isEmpty())
+            return;
+
+        m_socket->write(m_unsent);
+        m_socket->flush();
+        m_unsent.clear();
+    }
+
+    void IpcClient::onReadyRead() {
+        if (!readFrames()) {
+            dropConnection();
+            failAll();
+        }
+    }
+
+    void IpcClient::onConnectionLost() {
+        // Errors on a live connection are followed by disconnected()
+        if (!m_socket || m_socket->state() == QLocalSocket::ConnectedState)
+            return;
+
+        dropConnection();
+        failAll();
+    }
+
+    void IpcClient::onDeadline() {
+        QList<qint64> expired;
+        for (const auto& pending : m_inFlight) {
+            if (pending.deadline.hasExpired()) {
+                expired.append(pending.id);
+            }
+        }
+
+        for (const qint64 requestId : expired) {
+            complete(requestId, std::nullopt);
+        }
+        armDeadline();
+    }
+
+    bool IpcClient::ensureConnected() {
+        if (m_socket) {
+            // Pick up a hangup that arrived while no event loop was running
+            if (m_socket->state() == QLocalSocket::ConnectedState) {
+                m_socket->waitForReadyRead(0);
+            }
+            if (m_socket && m_socket->state() != QLocalSocket::UnconnectedState)
+                return true;
+
+            dropConnection();
+        }
+
+        m_socket = new QLocalSocket(this);
+        connect(m_socket, &QLocalSocket::connected, this, &IpcClient::onConnected);
+        connect(m_socket, &QLocalSocket::readyRead, this, &IpcClient::onReadyRead);
+        connect(m_socket, &QLocalSocket::disconnected, this, &IpcClient::onConnectionLost);
+        connect(m_socket, &QLocalSocket::errorOccurred, this, &IpcClient::onConnectionLost);
+        m_socket->connectToServer(m_socketPath);
+
+        // A missing daemon fails inside connectToServer and has already dropped the socket
+        return m_socket && m_socket->state() != QLocalSocket::UnconnectedState;
+    }
+
+    bool IpcClient::readFrames() {
+        // Decode everything first; handlers may send or wait on this client again
+        QList<QJsonObject> replies;
+        bool               ok = true;
+        while (ok && m_socket->bytesAvailable() > 0) {
+            if (m_reader.readFrom(*m_socket) <= 0) {
+                ok = false;
+                break;
+            }
+
+            while (const auto frame = m_reader.nextFrame()) {
+                auto decoded = decodeFrame(frame->payload, frame->encoding);
+                if (!decoded) {
+                    ok = false;
+                    break;
+                }
+                replies.append(std::move(*decoded));
+            }
+
+            ok = ok && !m_reader.overflowed();
+        }
+
+        for (auto& reply : replies) {
+            // Untagged frames (the event answering "next", or a daemon without requestId
+            // support) answer the oldest request, since the daemon handles a connection in order
+            const QJsonValue tag   = reply.value(json::KEY_REQUEST_ID);
+            const qint64     owner = tag.isUndefined() ? (m_inFlight.isEmpty() ? 0 : m_inFlight.first().id) : tag.toInteger(0);
+            reply.remove(json::KEY_REQUEST_ID);
+            complete(owner, std::move(reply));
+        }
+
+        return ok;
+    }
+
+    void IpcClient::complete(qint64 requestId, std::optional<QJsonObject> reply) {
+        for (qsizetype i = 0; i < m_inFlight.size(); ++i) {
+            if (m_inFlight[i].id != requestId)
+                continue;
+
+            // Unlink first so the handler can issue new requests
+            ReplyHandler handler = std::move(m_inFlight[i].handler);
+            m_inFlight.removeAt(i);
+            armDeadline();
+            if (handler) {
+                handler(std::move(reply));
+            }
+            return;
+        }
+    }
+
+    void IpcClient::failAll() {
+        // Requests on a lost connection are never answered
+        const QList<PendingRequest> failed = std::exchange(m_inFlight, {});
+        armDeadline();
+        for (const auto& pending : failed) {
+            if (pending.handler) {
+                pending.handler(std::nullopt);
+            }
+        }
+    }
+
+    void IpcClient::dropConnection() {
+        m_reader.clear();
+        m_unsent.clear();
+        if (!m_socket)
+            return;
+
+        // May run from the socket's own signal, so it is only deleted later
+        m_socket->disconnect(this);
+        m_socket->abort();
+        m_socket->deleteLater();
+        m_socket = nullptr;
+    }
+
+    void IpcClient::armDeadline() {
+        std::optional<QDeadlineTimer> earliest;
+        for (const auto& pending : m_inFlight) {
+            if (!pending.deadline.isForever() && (!earliest || pending.deadline < *earliest)) {
+                earliest = pending.deadline;
+            }
+        }
+
+        if (!earliest) {
+            m_deadlineTimer.stop();
+            return;
+        }
+        m_deadlineTimer.start(static_cast<int>(qMax<qint64>(0, earliest->remainingTime())));
+    }
+
 } // namespace bb
@@ -1,18 +1,46 @@
 #pragma once
 
+#include "FrameCodec.hpp"
+#include "FrameReader.hpp"
+
+#include <QByteArray>
+#include <QDeadlineTimer>
 #include <QJsonObject>
+#include <QList>
+#include <QObject>
 #include <QString>
+#include <QTimer>
 
+#include <functional>
 #include <optional>
 
+class QLocalSocket;
+
 namespace bb {
 
     // Unified IPC client for communicating with the daemon
-    class IpcClient {
+    // Keeps one connection open across requests and reconnects when the daemon went away.
+    // Each request carries a requestId the daemon echoes, so several can be in flight at once.
+    class IpcClient : public QObject {
+        Q_OBJECT
+
       public:
-        explicit IpcClient(const QString& socketPath);
+        // Receives the reply, or std::nullopt on connection failure, deadline or cancel
+        using ReplyHandler = std::function<void(std::optional<QJsonObject>)>;
+
+        // Requests are sent in the given encoding; replies of either encoding are accepted
+        explicit IpcClient(const QString& socketPath, FrameEncoding encoding = FrameEncoding::Json, QObject* parent = nullptr);
+        ~IpcClient() override;
+
+        // Send a request without blocking; the handler runs exactly once from the event loop
+        // A negative timeoutMs means no deadline
+        // Returns the request id, or 0 after running the handler at once when the daemon is unreachable
+        qint64 sendRequestAsync(const QJsonObject& request, int timeoutMs, ReplyHandler handler);
 
-        // Send a JSON request and wait for response
+        // Give up on a request; its handler runs now with std::nullopt and a late reply is discarded
+        void cancel(qint64 requestId);
+
+        // Blocking wrapper over sendRequestAsync; drives the socket itself, so no event loop is needed
         // Returns std::nullopt on connection/timeout/parse failure
         std::optional<QJsonObject> sendRequest(const QJsonObject& request,
                                                int                timeoutMs = 5 * 60 * 1000 // Default 5 minutes for pinentry
@@ -21,8 +49,37 @@ namespace bb {
         // Quick ping to check if daemon is reachable
         bool ping();
 
+        bool isConnected() const;
+        void disconnectFromServer();
+
+      private Q_SLOTS:
+        void onConnected();
+        void onReadyRead();
+        void onConnectionLost();
+        void onDeadline();
+
       private:
-        QString m_socketPath;
+        struct PendingRequest {
+            qint64         id = 0;
+            ReplyHandler   handler;
+            QDeadlineTimer deadline;
+        };
+
+        bool                  ensureConnected();
+        bool                  readFrames();
+        void                  complete(qint64 requestId, std::optional<QJsonObject> reply);
+        void                  failAll();
+        void                  dropConnection();
+        void                  armDeadline();
+
+        QString               m_socketPath;
+        FrameEncoding         m_encoding;
+        QLocalSocket*         m_socket = nullptr;
+        FrameReader           m_reader;
+        qint64                m_nextRequestId = 1;
+        QList<PendingRequest> m_inFlight; // oldest first
+        QByteArray            m_unsent;   // frames queued while the connection is being established
+        QTimer                m_deadlineTimer;
     };
 
 } // namespace bb
@@ -18,6 +18,7 @@
 #include <QFileInfo>
 #include <QLockFile>
 
+#include <algorithm>
 #include <memory>
 #include <pwd.h>
 #include <sys/socket.h>
@@ -33,6 +34,12 @@ namespace {
 
     inline constexpr int    PROVIDER_MAINTENANCE_INTERVAL_MS = 5000;
     inline constexpr qint64 FALLBACK_LAUNCH_COOLDOWN_MS      = 5000;
+    inline constexpr qint64 STANDBY_MEMORY_BUDGET_MB         = 128;
+
+    QString                 fallbackUiPath() {
+        const QString legacyOverride = QString::fromLocal8Bit(qgetenv("BB_AUTH_FALLBACK_PATH")).trimmed();
+        return legacyOverride.isEmpty() ? QCoreApplication::applicationDirPath() + "/bb-auth-fallback" : legacyOverride;
+    }
 
     QJsonObject             readBootstrapState() {
         QJsonObject   bootstrap;
@@ -81,16 +88,18 @@ namespace {
 
 } // namespace
 
-CAgent::CAgent(QObject* parent) : QObject(parent), m_listener(new CPolkitListener(this, nullptr)), m_eventRouter(m_providerRegistry, m_eventQueue) {
+CAgent::CAgent(QObject* parent) :
+    QObject(parent), m_listener(new CPolkitListener(this, nullptr)), m_eventRouter(m_providerRegistry, m_eventQueue), m_providerTimers(PROVIDER_MAINTENANCE_INTERVAL_MS) {
 #ifdef BB_AUTH_PROVIDER_SYSTEM_DIR
-    m_providerSearchDirs = bb::providers::ProviderDiscovery::defaultSearchDirs(QStringLiteral(BB_AUTH_PROVIDER_SYSTEM_DIR));
+    m_providerDiscovery.setSearchDirs(bb::providers::ProviderDiscovery::defaultSearchDirs(QStringLiteral(BB_AUTH_PROVIDER_SYSTEM_DIR)));
 #else
-    m_providerSearchDirs = bb::providers::ProviderDiscovery::defaultSearchDirs();
+    m_providerDiscovery.setSearchDirs(bb::providers::ProviderDiscovery::defaultSearchDirs());
 #endif
-    m_messageRouter.registerHandler(json::VAL_PING, [this](QLocalSocket* socket, const QJsonObject&) {
+    m_messageRouter.registerHandler(json::VAL_PING, [this](QLocalSocket* socket, const QJsonObject& msg) {
         QJsonObject       pong{{json::KEY_TYPE, json::VAL_PONG},
                                {json::KEY_VERSION, "2.0"},
-                               {json::KEY_CAPABILITIES, QJsonArray{json::VAL_POLKIT, json::VAL_KEYRING, json::VAL_PINENTRY, json::VAL_FINGERPRINT, json::VAL_FIDO2}}};
+                               {json::KEY_CAPABILITIES, QJsonArray{json::VAL_POLKIT, json::VAL_KEYRING, json::VAL_PINENTRY, json::VAL_FINGERPRINT, json::VAL_FIDO2}},
+                               {json::KEY_ENCODINGS, QJsonArray{json::VAL_JSON, json::VAL_CBOR}}};
 
         const QJsonObject bootstrap = readBootstrapState();
         if (!bootstrap.isEmpty()) {
@@ -104,7 +113,7 @@ CAgent::CAgent(QObject* parent) : QObject(parent), m_listener(new CPolkitListene
             }
         }
 
-        m_ipcServer.sendJson(socket, pong);
+        replyNegotiated(socket, msg, pong);
     });
 
     m_messageRouter.registerHandler("subscribe", [this](QLocalSocket* socket, const QJsonObject&) { handleSubscribe(socket); });
@@ -117,6 +126,14 @@ CAgent::CAgent(QObject* parent) : QObject(parent), m_listener(new CPolkitListene
     m_messageRouter.registerHandler("ui.unregister", [this](QLocalSocket* socket, const QJsonObject& msg) { handleUIUnregister(socket, msg); });
     m_messageRouter.registerHandler("session.respond", [this](QLocalSocket* socket, const QJsonObject& msg) { handleRespond(socket, msg); });
     m_messageRouter.registerHandler("session.cancel", [this](QLocalSocket* socket, const QJsonObject& msg) { handleCancel(socket, msg); });
+
+    connect(&m_requestorResolver, &bb::agent::RequestorResolver::resolved, this, &CAgent::onRequestorResolved);
+    m_providerLauncher.setExitHandler([this](const bb::providers::ProviderExit& exit) { onProviderExited(exit); });
+
+    m_providerTimers.setHandlers({.maintenance          = [this]() { runProviderMaintenance(); },
+                                  .standbyCheck         = [this]() { maintainFallbackStandby(); },
+                                  .expiry               = [this]() { pruneStaleProviders(); },
+                                  .registrationDeadline = [this]() { onRegistrationDeadline(); }});
 }
 
 CAgent::~CAgent() {}
@@ -144,22 +161,51 @@ bool CAgent::start(QCoreApplication& app, const QString& socketPath) {
         connect(m_listener.data(), &CPolkitListener::completed, this, &CAgent::onPolkitCompleted);
     }
 
+    // Warm the desktop index now, so the first prompt does not wait on a filesystem scan
+    RequestContextHelper::preloadDesktopIndex();
+    // Likewise for provider manifests, which are then kept current by inotify
+    m_providerDiscovery.result();
+
     // Setup IPC server
     m_ipcServer.setMessageHandler([this](QLocalSocket* socket, const QString& type, const QJsonObject& msg) { handleMessage(socket, type, msg); });
 
+    // Slow subscribers are throttled, but the active provider is never starved
+    m_ipcServer.setExemptionCheck([this](QLocalSocket* socket) { return socket == m_providerRegistry.activeProvider(); });
+    if (qEnvironmentVariable("BB_AUTH_IPC_OVERFLOW_POLICY") == "disconnect") {
+        m_ipcServer.setOverflowPolicy(bb::IpcServer::OverflowPolicy::Disconnect);
+    }
+
+    bool         deadlineOk = false;
+    const qint64 deadlineMs = qEnvironmentVariable("BB_AUTH_PROVIDER_REGISTER_TIMEOUT_MS").toLongLong(&deadlineOk);
+    if (deadlineOk && deadlineMs > 0) {
+        m_providerLauncher.setDefaultRegisterDeadline(deadlineMs);
+    }
+
+    // Opt-in: keep a hidden fallback registered, so the first prompt does not wait for it to start
+    bool         budgetOk       = false;
+    const qint64 budgetMb       = qEnvironmentVariable("BB_AUTH_FALLBACK_STANDBY_BUDGET_MB").toLongLong(&budgetOk);
+    const bool   standbyEnabled = qEnvironmentVariable("BB_AUTH_FALLBACK_STANDBY") == "1";
+    m_fallbackStandby.configure(standbyEnabled, (budgetOk ? budgetMb : STANDBY_MEMORY_BUDGET_MB) * 1024);
+
+    // Opt-in: start the built-in fallback alongside a preferred provider that is slow to register
+    bool         hedgeOk      = false;
+    const qint64 hedgeDelayMs = qEnvironmentVariable("BB_AUTH_PROVIDER_HEDGE_DELAY_MS").toLongLong(&hedgeOk);
+    if (hedgeOk && hedgeDelayMs > 0) {
+        m_providerLauncher.setHedgeDelay(hedgeDelayMs);
+    }
+
     QObject::connect(&m_ipcServer, &bb::IpcServer::clientDisconnected, [this](QLocalSocket* socket) { onClientDisconnected(socket); });
 
-    m_providerMaintenanceTimer.setInterval(PROVIDER_MAINTENANCE_INTERVAL_MS);
-    m_providerMaintenanceTimer.setSingleShot(false);
-    QObject::connect(&m_providerMaintenanceTimer, &QTimer::timeout, [this]() { pruneStaleProviders(); });
-    m_providerMaintenanceTimer.start();
+    // The standby's exit is reported through its pidfd, so replacing it needs no tick
+    m_fallbackStandby.setExitHandler([this]() { maintainFallbackStandby(); });
 
     if (!m_ipcServer.start(socketPath)) {
         std::print(stderr, "Failed to start IPC server on {}\n", socketPath.toStdString());
         return false;
     }
 
-    std::print("Agent started on {}\n", socketPath.toStdString());
+    std::print("Agent started on {}{}\n", socketPath.toStdString(), m_ipcServer.isSocketActivated() ? " (socket-activated)" : "");
+    maintainFallbackStandby();
     return app.exec() == 0;
 }
 
@@ -175,6 +221,7 @@ void CAgent::onClientDisconnected(QLocalSocket* socket) {
         }
     }
 
+    m_handoffSockets.remove(socket);
     m_eventQueue.removeWaiter(socket);
     m_keyringManager.cleanupForSocket(socket);
     m_pinentryManager.cleanupForSocket(socket);
@@ -185,6 +232,11 @@ void CAgent::onClientDisconnected(QLocalSocket* socket) {
 }
 
 void CAgent::handleMessage(QLocalSocket* socket, const QString& type, const QJsonObject& msg) {
+    // A handed-off provider was registered at spawn; its first message shows it came up
+    if (m_handoffSockets.remove(socket) && !creditProviderLaunch(socket)) {
+        return;
+    }
+
     if (!m_messageRouter.dispatch(socket, type, msg)) {
         m_ipcServer.sendJson(socket, QJsonObject{{json::KEY_TYPE, json::VAL_ERROR}, {json::KEY_MESSAGE, "Unknown type"}});
     }
@@ -196,10 +248,17 @@ void CAgent::handleNext(QLocalSocket* socket) {
         return;
     }
 
-    m_ipcServer.sendJson(socket, m_eventQueue.takeNext());
+    m_ipcServer.sendEvent(socket, m_eventQueue.takeNext());
 }
 
 void CAgent::handleSubscribe(QLocalSocket* socket) {
+    // A promoted standby subscribes again as it becomes active
+    if (socket == m_standbySocket) {
+        if (const auto latencyMs = m_fallbackStandby.promotionAcknowledged()) {
+            qInfo() << "Standby provider took over" << *latencyMs << "ms after promotion";
+        }
+    }
+
     if (!m_subscribers.contains(socket)) {
         m_subscribers.append(socket);
         qDebug() << "Subscriber added, total:" << m_subscribers.size();
@@ -209,13 +268,18 @@ void CAgent::handleSubscribe(QLocalSocket* socket) {
     const bool isActiveProvider            = isRegisteredProvider && (socket == m_providerRegistry.activeProvider());
     const bool canReceiveInteractiveEvents = !isRegisteredProvider || isActiveProvider;
 
+    // Replayed as events so they never carry the subscribe request's requestId
     if (canReceiveInteractiveEvents) {
         for (const auto& [cookie, session] : m_sessionStore.sessions()) {
-            m_ipcServer.sendJson(socket, session->toCreatedEvent());
-            m_ipcServer.sendJson(socket, session->toUpdatedEvent());
+            m_ipcServer.sendEvent(socket, bb::EncodedEvent(session->toCreatedEvent()));
+            m_ipcServer.sendEvent(socket, bb::EncodedEvent(session->toUpdatedEvent()));
         }
     }
 
+    if (isActiveProvider && !m_sessionStore.empty()) {
+        probeActiveProvider();
+    }
+
     QJsonObject subscribedMsg{{json::KEY_TYPE, json::VAL_SUBSCRIBED}, {"sessionCount", canReceiveInteractiveEvents ? static_cast<int>(m_sessionStore.size()) : 0}};
 
     if (isRegisteredProvider) {
@@ -225,34 +289,102 @@ void CAgent::handleSubscribe(QLocalSocket* socket) {
     m_ipcServer.sendJson(socket, subscribedMsg);
 }
 
+void CAgent::replyNegotiated(QLocalSocket* socket, const QJsonObject& msg, QJsonObject reply) {
+    // The reply still goes out in the old encoding; the switch applies to what follows
+    const bb::FrameEncoding encoding = bb::requestedEncoding(msg);
+    if (encoding != bb::FrameEncoding::Json) {
+        reply[json::KEY_ENCODING] = bb::encodingName(encoding);
+    }
+
+    m_ipcServer.sendJson(socket, reply);
+    m_ipcServer.setEncoding(socket, encoding);
+}
+
+void CAgent::sendJson(QLocalSocket* socket, const QJsonObject& json) {
+    m_ipcServer.sendJson(socket, json);
+}
+
 void CAgent::handleKeyringRequest(QLocalSocket* socket, const QJsonObject& msg) {
-    pid_t peerPid = bb::IpcServer::getPeerPid(socket);
-    m_keyringManager.handleRequest(msg, socket, peerPid);
+    m_keyringManager.handleRequest(msg, socket, m_ipcServer.peerCredentials(socket));
 }
 
 void CAgent::handlePinentryRequest(QLocalSocket* socket, const QJsonObject& msg) {
-    pid_t peerPid = bb::IpcServer::getPeerPid(socket);
-    m_pinentryManager.handleRequest(msg, socket, peerPid);
+    m_pinentryManager.handleRequest(msg, socket, m_ipcServer.peerCredentials(socket));
 }
 
 void CAgent::handlePinentryResult(QLocalSocket* socket, const QJsonObject& msg) {
-    pid_t       peerPid = bb::IpcServer::getPeerPid(socket);
-    QJsonObject result  = m_pinentryManager.handleResult(msg, peerPid);
+    const QJsonObject result = m_pinentryManager.handleResult(msg, m_ipcServer.peerCredentials(socket));
     m_ipcServer.sendJson(socket, result);
 }
 
 void CAgent::handleUIRegister(QLocalSocket* socket, const QJsonObject& msg) {
-    const auto provider              = m_providerRegistry.registerProvider(socket, msg);
+    const qint64 peerPid = m_ipcServer.peerCredentials(socket).pid;
+    const bool   standby = msg.value("standby").toBool();
+    if (standby) {
+        const auto admission = m_fallbackStandby.admit(peerPid);
+        if (!admission.accepted) {
+            qWarning() << "Declining standby provider: pid=" << peerPid << "memory" << admission.memoryKb << "KiB";
+            m_ipcServer.sendJson(socket, QJsonObject{{json::KEY_TYPE, json::VAL_UI_SHUTDOWN}, {json::KEY_REASON, "standby-declined"}});
+            return;
+        }
+        qInfo() << "Standby provider ready: pid=" << peerPid << "startup" << admission.startupMs << "ms, memory" << admission.memoryKb << "KiB";
+        m_standbySocket = socket;
+        armStandbyChecks();
+    } else if (!creditProviderLaunch(socket)) {
+        return;
+    }
+
+    registerUIProvider(socket, msg);
+
+    if (standby && !hasActiveProvider() && !m_sessionStore.empty()) {
+        ensureFallbackUiRunning("standby-ready");
+    }
+}
+
+void CAgent::registerUIProvider(QLocalSocket* socket, const QJsonObject& msg, bool awaitingLaunch) {
+    const auto provider              = m_providerRegistry.registerProvider(socket, msg, awaitingLaunch);
     const bool activeProviderChanged = m_providerRegistry.recomputeActiveProvider();
     const bool nowActive             = socket == m_providerRegistry.activeProvider();
 
-    m_ipcServer.sendJson(
-        socket, QJsonObject{{json::KEY_TYPE, json::VAL_UI_REGISTERED}, {json::KEY_ID, provider.id}, {json::KEY_ACTIVE, nowActive}, {json::KEY_PRIORITY, provider.priority}});
+    QJsonObject reply{{json::KEY_TYPE, json::VAL_UI_REGISTERED}, {json::KEY_ID, provider.id}, {json::KEY_ACTIVE, nowActive}, {json::KEY_PRIORITY, provider.priority}};
+    if (provider.quiescent) {
+        // Tells the provider its heartbeats can stop; without this it keeps sending them
+        reply[json::KEY_QUIESCENT] = true;
+    }
+    replyNegotiated(socket, msg, reply);
 
     if (activeProviderChanged || nowActive) {
         emitProviderStatus();
     }
+    armProviderExpiry();
 }
+
+bool CAgent::creditProviderLaunch(QLocalSocket* socket) {
+    const auto registration = m_providerLauncher.providerRegistered(m_ipcServer.peerCredentials(socket).pid);
+    armRegistrationDeadline();
+    if (registration.superseded) {
+        // Lost the hedged launch: the other provider already has the sessions
+        qInfo() << "Provider that lost the launch race registered; asking it to shut down";
+        m_ipcServer.sendJson(socket, QJsonObject{{json::KEY_TYPE, json::VAL_UI_SHUTDOWN}, {json::KEY_REASON, "superseded"}});
+        if (m_providerRegistry.unregisterProvider(socket) && m_providerRegistry.recomputeActiveProvider()) {
+            emitProviderStatus();
+        }
+        return false;
+    }
+    if (registration.latencyMs) {
+        qInfo() << "Launched provider registered:" << registration.providerId << "after" << *registration.latencyMs << "ms";
+    }
+
+    // The launch it beat may hold a pre-registered slot; nothing should wait for that one's deadline
+    if (registration.supersededPid > 0) {
+        dropProviderHandoff(registration.supersededPid);
+    }
+    if (m_providerRegistry.confirmLaunch(socket) && m_providerRegistry.recomputeActiveProvider()) {
+        emitProviderStatus();
+    }
+    return true;
+}
+
 void CAgent::handleUIHeartbeat(QLocalSocket* socket, const QJsonObject& msg) {
     Q_UNUSED(msg)
 
@@ -298,7 +430,7 @@ void CAgent::handleRespond(QLocalSocket* socket, const QJsonObject& msg) {
         QLocalSocket* origSocket = m_keyringManager.getSocketForRequest(cookie);
         QJsonObject   reply      = m_keyringManager.handleResponse(cookie, response);
         if (origSocket)
-            m_ipcServer.sendJson(origSocket, reply, true);
+            m_ipcServer.sendReply(origSocket, reply, true);
         m_ipcServer.sendJson(socket, QJsonObject{{json::KEY_TYPE, json::VAL_OK}});
         return;
     }
@@ -312,7 +444,7 @@ void CAgent::handleRespond(QLocalSocket* socket, const QJsonObject& msg) {
             return;
         }
 
-        m_ipcServer.sendJson(origSocket, result.socketResponse, true);
+        m_ipcServer.sendReply(origSocket, result.socketResponse, true);
         m_ipcServer.sendJson(socket, QJsonObject{{json::KEY_TYPE, json::VAL_OK}});
         return;
     }
@@ -349,7 +481,7 @@ void CAgent::handleCancel(QLocalSocket* socket, const QJsonObject& msg) {
         QLocalSocket* origSocket = m_keyringManager.getSocketForRequest(cookie);
         QJsonObject   reply      = m_keyringManager.handleCancel(cookie);
         if (origSocket)
-            m_ipcServer.sendJson(origSocket, reply);
+            m_ipcServer.sendReply(origSocket, reply);
         m_ipcServer.sendJson(socket, QJsonObject{{json::KEY_TYPE, json::VAL_OK}});
         return;
     }
@@ -363,7 +495,7 @@ void CAgent::handleCancel(QLocalSocket* socket, const QJsonObject& msg) {
         }
 
         if (origSocket) {
-            m_ipcServer.sendJson(origSocket, reply);
+            m_ipcServer.sendReply(origSocket, reply);
         }
         m_ipcServer.sendJson(socket, QJsonObject{{json::KEY_TYPE, json::VAL_OK}});
         return;
@@ -385,7 +517,8 @@ void CAgent::handleCancel(QLocalSocket* socket, const QJsonObject& msg) {
 }
 
 void CAgent::emitSessionEvent(const QJsonObject& event) {
-    m_eventRouter.route(event, m_subscribers, [this](QLocalSocket* socket, const QJsonObject& routedEvent) { m_ipcServer.sendJson(socket, routedEvent); });
+    const bb::EncodedEvent encoded(event);
+    m_eventRouter.route(encoded, m_subscribers, [this](QLocalSocket* socket, const bb::EncodedEvent& routedEvent) { m_ipcServer.sendEvent(socket, routedEvent); });
 }
 
 bool CAgent::onPolkitRequest(const QString& cookie, const QString& message, [[maybe_unused]] const QString& iconName, const QString& actionId, const QString& user,
@@ -397,20 +530,10 @@ bool CAgent::onPolkitRequest(const QString& cookie, const QString& message, [[ma
     ctx.actionId = actionId;
     ctx.user     = user;
 
-    auto pid = RequestContextHelper::extractSubjectPid(details);
+    const auto pid = RequestContextHelper::extractSubjectPid(details);
     if (pid) {
-        auto proc = RequestContextHelper::readProc(*pid);
-        if (proc) {
-            auto actor                   = RequestContextHelper::resolveRequestorFromSubject(*proc, getuid());
-            ctx.requestor.name           = actor.displayName;
-            ctx.requestor.icon           = actor.iconName;
-            ctx.requestor.fallbackLetter = actor.fallbackLetter;
-            ctx.requestor.fallbackKey    = actor.fallbackKey;
-            ctx.requestor.pid            = *pid;
-        }
-    }
-
-    if (ctx.requestor.name.isEmpty()) {
+        ctx.requestor.pid = *pid;
+    } else {
         ctx.requestor.name           = "Unknown";
         ctx.requestor.fallbackLetter = "?";
         ctx.requestor.fallbackKey    = "unknown";
@@ -421,6 +544,9 @@ bool CAgent::onPolkitRequest(const QString& cookie, const QString& message, [[ma
         return false;
     }
 
+    if (pid) {
+        resolveSessionRequestor(cookie, *pid);
+    }
     return true;
 }
 
@@ -466,6 +592,33 @@ void CAgent::onSessionInfo(const QString& cookie, const QString& info) {
 }
 
 void CAgent::onPolkitCompleted([[maybe_unused]] bool gainedAuthorization) {}
+void CAgent::onRequestorResolved(const QString& id, qint64 pid, const ActorInfo& actor) {
+    const Session* session = m_sessionStore.getSession(id);
+    if (!session) {
+        return;
+    }
+
+    Session::Requestor requestor;
+    requestor.name           = actor.displayName;
+    requestor.icon           = actor.iconName;
+    requestor.fallbackLetter = actor.fallbackLetter;
+    requestor.fallbackKey    = actor.fallbackKey;
+    requestor.pid            = pid;
+
+    // Polkit prompts always name someone, even when the subject exited before it could be read
+    if (requestor.name.isEmpty() && session->source() == Session::Source::Polkit) {
+        requestor.name           = "Unknown";
+        requestor.fallbackLetter = "?";
+        requestor.fallbackKey    = "unknown";
+    }
+
+    const auto updated = m_sessionStore.updateRequestor(id, requestor);
+    if (!updated) {
+        return;
+    }
+
+    emitSessionEvent(*updated);
+}
 // Centralized session management
 bool CAgent::createSession(const QString& id, Session::Source source, Session::Context ctx) {
     const auto createdEvent = m_sessionStore.createSession(id, source, ctx);
@@ -476,9 +629,17 @@ bool CAgent::createSession(const QString& id, Session::Source source, Session::C
     emitSessionEvent(*createdEvent);
     if (!hasActiveProvider()) {
         ensureFallbackUiRunning("session-created");
+    } else {
+        probeActiveProvider();
     }
     return true;
 }
+void CAgent::resolveSessionRequestor(const QString& id, qint64 pid, std::shared_ptr<const int> pidfd) {
+    if (pid <= 0) {
+        return;
+    }
+    m_requestorResolver.resolve(id, pid, std::move(pidfd));
+}
 void CAgent::updateSessionPrompt(const QString& id, const QString& prompt, bool echo, bool clearError) {
     const auto updated = m_sessionStore.updatePrompt(id, prompt, echo, clearError);
     if (!updated) {
@@ -542,6 +703,37 @@ void CAgent::pruneStaleProviders() {
     if (!hasActiveProvider() && !m_sessionStore.empty()) {
         ensureFallbackUiRunning("provider-prune");
     }
+    armProviderExpiry();
+}
+
+void CAgent::armProviderExpiry() {
+    m_providerTimers.armExpiry(m_providerRegistry.nextExpiryMs());
+}
+
+void CAgent::probeActiveProvider() {
+    // A quiescent provider sends no heartbeats, so a hung one would keep the prompt forever;
+    // it has until the probe deadline to answer, and the expiry timer fails over if it does not
+    QLocalSocket* active = m_providerRegistry.activeProvider();
+    if (!active || !m_providerRegistry.probe(active)) {
+        return;
+    }
+
+    // An event, so it never carries the requestId of the request being handled
+    m_ipcServer.sendEvent(active, bb::EncodedEvent(QJsonObject{{json::KEY_TYPE, json::VAL_UI_PING}}));
+    armProviderExpiry();
+}
+
+void CAgent::runProviderMaintenance() {
+    // Retries a launch that was throttled or failed while sessions wait
+    const bool unserved = !hasActiveProvider() && !m_sessionStore.empty();
+    if (unserved) {
+        ensureFallbackUiRunning("launch-retry");
+    }
+    maintainFallbackStandby();
+
+    if (!unserved && !m_fallbackStandby.needsPolling()) {
+        m_providerTimers.stopMaintenance();
+    }
 }
 void CAgent::emitProviderStatus() {
     QJsonObject status{{json::KEY_TYPE, json::VAL_UI_ACTIVE}, {json::KEY_ACTIVE, hasActiveProvider()}};
@@ -552,23 +744,171 @@ void CAgent::emitProviderStatus() {
         status[json::KEY_PRIORITY] = provider->priority;
     }
 
-    QSet<QLocalSocket*> sent;
+    // Each status supersedes the last, so a slow reader may lose some
+    const bb::EncodedEvent encoded(status);
+    QSet<QLocalSocket*>    sent;
 
     for (QLocalSocket* socket : m_providerRegistry.sockets()) {
         if (socket && socket->isValid()) {
-            m_ipcServer.sendJson(socket, status);
+            m_ipcServer.sendEvent(socket, encoded, true);
             sent.insert(socket);
         }
     }
     for (auto* subscriber : m_subscribers) {
         if (subscriber && subscriber->isValid() && !sent.contains(subscriber)) {
-            m_ipcServer.sendJson(subscriber, status);
+            m_ipcServer.sendEvent(subscriber, encoded, true);
+        }
+    }
+}
+
+void CAgent::onProviderExited(const bb::providers::ProviderExit& exit) {
+    armRegistrationDeadline();
+    if (exit.superseded) {
+        qInfo() << "Provider that lost the launch race exited:" << exit.providerId << "pid=" << exit.pid << exit.status;
+        return;
+    }
+    if (!exit.beforeRegistration) {
+        qInfo() << "Provider exited:" << exit.providerId << "pid=" << exit.pid << exit.status;
+        return;
+    }
+
+    if (exit.timedOut) {
+        qInfo() << "Provider stopped after missing its registration deadline:" << exit.providerId << "pid=" << exit.pid;
+    } else {
+        qWarning() << "Provider exited before registering:" << exit.providerId << "pid=" << exit.pid << exit.status;
+    }
+
+    // The launch cooldown guards against duplicate starts, not against a provider that is already gone
+    m_lastFallbackLaunchMs = 0;
+    dropProviderHandoff(exit.pid);
+    if (!m_sessionStore.empty()) {
+        ensureFallbackUiRunning(exit.timedOut ? "register-timeout" : "provider-exited");
+    }
+}
+
+void CAgent::onRegistrationDeadline() {
+    if (const auto hedge = m_providerLauncher.startHedge()) {
+        if (hedge->launched) {
+            qInfo() << "Provider launch:" << hedge->detail << "id=" << hedge->providerId << "exec=" << hedge->executable << "pid=" << hedge->pid;
+            adoptProviderHandoff(*hedge);
+        } else {
+            qWarning() << "Provider launch failed:" << hedge->detail << "id=" << hedge->providerId << "exec=" << hedge->executable;
+        }
+    }
+
+    bool failOver = false;
+    while (const auto timeout = m_providerLauncher.expireRegistration()) {
+        qWarning() << "Provider did not register within" << timeout->waitedMs << "ms:" << timeout->providerId;
+        // A stopped provider still holds the fallback lock until it is gone; its exit continues from onProviderExited()
+        failOver = failOver || !timeout->terminated;
+    }
+    armRegistrationDeadline();
+
+    if (failOver) {
+        m_lastFallbackLaunchMs = 0;
+        if (!m_sessionStore.empty()) {
+            ensureFallbackUiRunning("register-timeout");
+        }
+    }
+}
+
+void CAgent::adoptProviderHandoff(const bb::providers::LaunchAttemptResult& launch) {
+    if (launch.handoffFd < 0) {
+        return;
+    }
+
+    // SO_PEERCRED on a socketpair names the daemon itself; the launcher knows who holds the other end
+    PeerCredentials peer;
+    peer.pid             = static_cast<pid_t>(launch.pid);
+    peer.uid             = ::getuid();
+    peer.gid             = ::getgid();
+    QLocalSocket* socket = m_ipcServer.adoptConnection(launch.handoffFd, peer);
+    if (!socket) {
+        return;
+    }
+
+    // Registered before it runs, but not made active until its first message shows it is up;
+    // a hedged launch may still win in the meantime
+    m_handoffSockets.insert(socket);
+    registerUIProvider(socket, launch.handoffRegistration, true);
+}
+
+void CAgent::dropProviderHandoff(qint64 pid) {
+    QLocalSocket* handoff = nullptr;
+    for (QLocalSocket* socket : std::as_const(m_handoffSockets)) {
+        if (m_ipcServer.peerCredentials(socket).pid == pid) {
+            handoff = socket;
         }
     }
+
+    // Its pre-registered slot goes now rather than when the hangup is read
+    if (handoff) {
+        m_handoffSockets.remove(handoff);
+        if (m_providerRegistry.unregisterProvider(handoff) && m_providerRegistry.recomputeActiveProvider()) {
+            emitProviderStatus();
+        }
+        handoff->abort();
+    }
+}
+
+bool CAgent::promoteStandby() {
+    QLocalSocket* socket = m_providerRegistry.promoteStandby();
+    if (!socket) {
+        return false;
+    }
+
+    qInfo() << "Promoting standby provider";
+    m_fallbackStandby.promoted();
+    if (m_providerRegistry.recomputeActiveProvider()) {
+        emitProviderStatus();
+    }
+    return true;
+}
+
+void CAgent::maintainFallbackStandby() {
+    if (!m_fallbackStandby.isEnabled()) {
+        m_providerTimers.armStandbyCheck(std::nullopt);
+        return;
+    }
+
+    if (!m_fallbackStandby.withinBudget()) {
+        qWarning() << "Standby provider grew past its memory budget; warm standby disabled";
+        if (m_standbySocket) {
+            m_ipcServer.sendJson(m_standbySocket, QJsonObject{{json::KEY_TYPE, json::VAL_UI_SHUTDOWN}, {json::KEY_REASON, "standby-declined"}});
+            m_providerRegistry.unregisterProvider(m_standbySocket);
+        }
+        m_providerTimers.armStandbyCheck(std::nullopt);
+        return;
+    }
+
+    if (m_fallbackStandby.ensureRunning(fallbackUiPath(), m_socketPath)) {
+        qInfo() << "Starting standby provider: pid=" << m_fallbackStandby.pid();
+    }
+    armStandbyChecks();
+}
+
+void CAgent::armStandbyChecks() {
+    // Only a standby that could not be watched is polled; a registered one is measured on its own rare deadline
+    if (m_fallbackStandby.needsPolling()) {
+        m_providerTimers.startMaintenance();
+    }
+    m_providerTimers.armStandbyCheck(m_fallbackStandby.nextCheckMs());
+}
+
+void CAgent::armRegistrationDeadline() {
+    m_providerTimers.armRegistrationDeadline(m_providerLauncher.nextDeadlineMs());
 }
 
 void CAgent::ensureFallbackUiRunning(const QString& reason) {
-    if (hasActiveProvider()) {
+    if (hasActiveProvider() || promoteStandby()) {
+        return;
+    }
+
+    // Until a provider takes the sessions, retried on a slow tick; see runProviderMaintenance()
+    m_providerTimers.startMaintenance();
+
+    // The provider launched last has until its registration deadline; see onRegistrationDeadline()
+    if (m_providerLauncher.awaitingRegistration()) {
         return;
     }
 
@@ -587,7 +927,7 @@ void CAgent::ensureFallbackUiRunning(const QString& reason) {
         return;
     }
 
-    const auto discovery = bb::providers::ProviderDiscovery::discover(m_providerSearchDirs);
+    const auto& discovery = m_providerDiscovery.result();
     for (const auto& warning : discovery.warnings) {
         qWarning() << warning;
     }
@@ -608,11 +948,14 @@ void CAgent::ensureFallbackUiRunning(const QString& reason) {
 
     if (launch.launched) {
         m_lastFallbackLaunchMs = nowMs;
-        qInfo() << "Provider launch:" << launch.detail << "id=" << launch.providerId << "exec=" << launch.executable;
+        qInfo() << "Provider launch:" << launch.detail << "id=" << launch.providerId << "exec=" << launch.executable << "pid=" << launch.pid;
+        armRegistrationDeadline();
+        adoptProviderHandoff(launch);
         return;
     }
 
     if (launch.attempted) {
+        // The manifests stay as parsed: inotify reports edits to them, and the launcher resolves a failed executable again
         qWarning() << "Provider launch failed:" << launch.detail << "id=" << launch.providerId << "exec=" << launch.executable;
         return;
     }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QCoreApplication>
+#include <QSet>
 #include <QSharedPointer>
 #include <QTimer>
 
@@ -11,12 +12,15 @@
 #include "agent/EventQueue.hpp"
 #include "agent/EventRouter.hpp"
 #include "agent/ProviderRegistry.hpp"
+#include "agent/ProviderTimers.hpp"
+#include "agent/RequestorResolver.hpp"
 #include "agent/SessionStore.hpp"
 #include "agent/MessageRouter.hpp"
 #include "ipc/IpcServer.hpp"
 #include "managers/KeyringManager.hpp"
 #include "managers/PinentryManager.hpp"
-#include "providers/ProviderDiscovery.hpp"
+#include "providers/FallbackStandby.hpp"
+#include "providers/ProviderDiscoveryCache.hpp"
 #include "providers/ProviderLauncher.hpp"
 
 namespace bb {
@@ -44,14 +48,29 @@ namespace bb {
         void handleUIUnregister(QLocalSocket* socket, const QJsonObject& msg);
         void handleRespond(QLocalSocket* socket, const QJsonObject& msg);
         void handleCancel(QLocalSocket* socket, const QJsonObject& msg);
+        void replyNegotiated(QLocalSocket* socket, const QJsonObject& msg, QJsonObject reply);
+        void registerUIProvider(QLocalSocket* socket, const QJsonObject& msg, bool awaitingLaunch = false);
+        bool creditProviderLaunch(QLocalSocket* socket);
 
         bool isAuthorizedProviderSocket(QLocalSocket* socket) const;
         bool hasActiveProvider() const;
         void pruneStaleProviders();
+        void armProviderExpiry();
+        void probeActiveProvider();
+        void runProviderMaintenance();
         void emitProviderStatus();
         void ensureFallbackUiRunning(const QString& reason);
+        void onProviderExited(const bb::providers::ProviderExit& exit);
+        void onRegistrationDeadline();
+        void adoptProviderHandoff(const bb::providers::LaunchAttemptResult& launch);
+        void dropProviderHandoff(qint64 pid);
+        void armRegistrationDeadline();
+        bool promoteStandby();
+        void maintainFallbackStandby();
+        void armStandbyChecks();
 
         void onPolkitCompleted(bool gainedAuthorization);
+        void onRequestorResolved(const QString& id, qint64 pid, const ActorInfo& actor);
 
       public:
         bool        onPolkitRequest(const QString& cookie, const QString& message, const QString& iconName, const QString& actionId, const QString& user,
@@ -62,8 +81,11 @@ namespace bb {
         void        onSessionInfo(const QString& cookie, const QString& info);
 
         void        emitSessionEvent(const QJsonObject& event);
+        void        sendJson(QLocalSocket* socket, const QJsonObject& json);
 
         bool        createSession(const QString& id, Session::Source source, Session::Context ctx);
+        // Announced sessions carry a pid-only requestor; this resolves it off the event loop and sends session.updated
+        void        resolveSessionRequestor(const QString& id, qint64 pid, std::shared_ptr<const int> pidfd = {});
         void        updateSessionPrompt(const QString& id, const QString& prompt, bool echo = false, bool clearError = true);
         void        updateSessionError(const QString& id, const QString& error);
         void        updateSessionPinentryRetry(const QString& id, int curRetry, int maxRetries);
@@ -71,22 +93,27 @@ namespace bb {
         Session*    getSession(const QString& id);
 
       private:
-        bb::IpcServer                   m_ipcServer;
-        bb::KeyringManager              m_keyringManager;
-        bb::PinentryManager             m_pinentryManager;
-
-        QSharedPointer<CPolkitListener> m_listener;
-        bb::agent::ProviderRegistry     m_providerRegistry;
-        bb::agent::EventQueue           m_eventQueue;
-        bb::agent::EventRouter          m_eventRouter;
-        bb::agent::SessionStore         m_sessionStore;
-        bb::agent::MessageRouter        m_messageRouter;
-        QList<QLocalSocket*>            m_subscribers;
-        QTimer                          m_providerMaintenanceTimer;
-        QString                         m_socketPath;
-        bb::providers::ProviderLauncher m_providerLauncher;
-        QStringList                     m_providerSearchDirs;
-        qint64                          m_lastFallbackLaunchMs = 0;
+        bb::IpcServer                         m_ipcServer;
+        bb::KeyringManager                    m_keyringManager;
+        bb::PinentryManager                   m_pinentryManager;
+
+        QSharedPointer<CPolkitListener>       m_listener;
+        bb::agent::ProviderRegistry           m_providerRegistry;
+        bb::agent::EventQueue                 m_eventQueue;
+        bb::agent::EventRouter                m_eventRouter;
+        bb::agent::SessionStore               m_sessionStore;
+        bb::agent::RequestorResolver          m_requestorResolver;
+        bb::agent::MessageRouter              m_messageRouter;
+        QList<QLocalSocket*>                  m_subscribers;
+        bb::agent::ProviderTimers             m_providerTimers;
+        QString                               m_socketPath;
+        bb::providers::ProviderLauncher       m_providerLauncher;
+        bb::providers::ProviderDiscoveryCache m_providerDiscovery;
+        bb::providers::FallbackStandby        m_fallbackStandby;
+        QPointer<QLocalSocket>                m_standbySocket;
+        // Pre-registered at spawn; the first message on one credits its launch
+        QSet<QLocalSocket*>                   m_handoffSockets;
+        qint64                                m_lastFallbackLaunchMs = 0;
     };
 
 } // namespace bb
@@ -0,0 +1,123 @@
+#include "DesktopEntry.hpp"
+
+#include <QByteArray>
+#include <QFile>
+
+namespace bb {
+
+    namespace {
+
+        // Entries are a few hundred bytes; anything this large is not a launcher
+        inline constexpr qint64 MAX_DESKTOP_FILE_SIZE = 1024 * 1024;
+
+        QString                 decodeValue(QByteArrayView value) {
+            if (value.indexOf('\\') < 0)
+                return QString::fromUtf8(value);
+
+            QByteArray unescaped;
+            unescaped.reserve(value.size());
+            for (qsizetype i = 0; i < value.size(); ++i) {
+                const char c = value.at(i);
+                if (c != '\\' || i + 1 == value.size()) {
+                    unescaped.append(c);
+                    continue;
+                }
+
+                switch (const char next = value.at(++i)) {
+                    case 's': unescaped.append(' '); break;
+                    case 'n': unescaped.append('\n'); break;
+                    case 't': unescaped.append('\t'); break;
+                    case 'r': unescaped.append('\r'); break;
+                    default: unescaped.append(next); break;
+                }
+            }
+            return QString::fromUtf8(unescaped);
+        }
+
+        // Same truth values as QVariant(QString)::toBool(), which the QSettings reader relied on
+        bool isTrue(QByteArrayView value) {
+            return !value.isEmpty() && value != "0" && value.compare("false", Qt::CaseInsensitive) != 0;
+        }
+
+    } // namespace
+
+    std::optional<DesktopInfo> parseDesktopEntry(QByteArrayView contents, const QString& desktopId) {
+        if (contents.startsWith("\xEF\xBB\xBF")) {
+            contents = contents.sliced(3);
+        }
+
+        // Views into contents; only the kept values are ever copied
+        QByteArrayView name;
+        QByteArrayView icon;
+        QByteArrayView exec;
+        QByteArrayView tryExec;
+        QByteArrayView noDisplay;
+        bool           inEntry = false;
+
+        while (!contents.isEmpty()) {
+            const qsizetype eol  = contents.indexOf('\n');
+            QByteArrayView  line = (eol < 0 ? contents : contents.first(eol)).trimmed();
+            contents             = eol < 0 ? QByteArrayView() : contents.sliced(eol + 1);
+
+            if (line.isEmpty() || line.front() == '#')
+                continue;
+
+            if (line.front() == '[') {
+                // [Desktop Entry] comes first; action groups after it repeat Name and Exec
+                if (inEntry)
+                    break;
+                inEntry = line == "[Desktop Entry]";
+                continue;
+            }
+
+            const qsizetype eq = line.indexOf('=');
+            if (!inEntry || eq <= 0)
+                continue;
+
+            const QByteArrayView key   = line.first(eq).trimmed();
+            const QByteArrayView value = line.sliced(eq + 1).trimmed();
+            if (key == "Name") {
+                name = value;
+            } else if (key == "Icon") {
+                icon = value;
+            } else if (key == "Exec") {
+                exec = value;
+            } else if (key == "TryExec") {
+                tryExec = value;
+            } else if (key == "NoDisplay") {
+                noDisplay = value;
+            }
+        }
+
+        if (isTrue(noDisplay) || name.isEmpty())
+            return std::nullopt;
+
+        DesktopInfo d;
+        d.desktopId = desktopId;
+        d.name      = decodeValue(name);
+        d.iconName  = decodeValue(icon);
+        d.exec      = decodeValue(exec).split(' ').first().remove('"');
+        d.tryExec   = decodeValue(tryExec);
+        return d;
+    }
+
+    std::optional<DesktopInfo> readDesktopEntry(const QString& path) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return std::nullopt;
+
+        const qint64 size = file.size();
+        if (size <= 0 || size > MAX_DESKTOP_FILE_SIZE)
+            return std::nullopt;
+
+        // One buffer per thread, reused for every file of a scan
+        thread_local QByteArray buffer;
+        buffer.resize(size);
+        const qint64 read = file.read(buffer.data(), size);
+        if (read <= 0)
+            return std::nullopt;
+
+        return parseDesktopEntry(QByteArrayView(buffer.constData(), read), path.sliced(path.lastIndexOf(u'/') + 1));
+    }
+
+} // namespace bb
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "RequestContext.hpp"
+
+#include <QByteArrayView>
+#include <QString>
+
+#include <optional>
+
+namespace bb {
+
+    // Reads the handful of [Desktop Entry] keys the index needs, following the Desktop Entry spec:
+    // '#' comments, trimmed keys and values, \s \n \t \r \\ escapes; localized keys are ignored
+    // std::nullopt for entries that are hidden (NoDisplay) or have no Name
+    std::optional<DesktopInfo> parseDesktopEntry(QByteArrayView contents, const QString& desktopId);
+
+    // Read the file in one go and parse it; the desktop id is its file name
+    std::optional<DesktopInfo> readDesktopEntry(const QString& path);
+
+} // namespace bb
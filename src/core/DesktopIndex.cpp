@@ -0,0 +1,268 @@
+#include "DesktopIndex.hpp"
+#include "DesktopEntry.hpp"
+
+#include <QDataStream>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QSaveFile>
+#include <QScopeGuard>
+
+#include <algorithm>
+#include <sys/stat.h>
+
+namespace bb {
+
+    namespace {
+
+        inline constexpr quint32 SNAPSHOT_MAGIC   = 0x42424449; // "BBDI"
+        inline constexpr quint32 SNAPSHOT_VERSION = 3;
+
+        // Same result as QFileInfo(path).fileName(), without the filesystem object
+        QStringView fileNameOf(QStringView path) {
+            return path.sliced(path.lastIndexOf(u'/') + 1);
+        }
+
+        bool isBelow(const QString& path, const QString& directory) {
+            return path.size() > directory.size() && path.startsWith(directory) && path.at(directory.size()) == u'/';
+        }
+
+        void indexFirst(QHash<QString, qsizetype>& table, const QString& key, qsizetype row) {
+            if (!key.isEmpty()) {
+                table.tryEmplace(key, row);
+            }
+        }
+
+        // QFileInfo only resolves milliseconds, which misses quick successive installs
+        qint64 modificationTime(const QString& path, bool directory) {
+            struct stat st{};
+            if (::stat(QFile::encodeName(path).constData(), &st) != 0 || S_ISDIR(st.st_mode) != directory)
+                return -1;
+            return static_cast<qint64>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        }
+
+    } // namespace
+
+    DesktopIndex::DesktopIndex(QList<DesktopInfo> entries) : m_entries(std::move(entries)) {
+        buildTables();
+    }
+
+    DesktopIndex::DesktopIndex(QStringList roots, const SourceFiles& files) : m_roots(std::move(roots)) {
+        m_sources.reserve(files.size());
+        for (const auto& root : m_roots) {
+            const qsizetype first = m_sources.size();
+            for (const auto& file : files) {
+                if (isBelow(file.path, root)) {
+                    m_sources.append(file);
+                }
+            }
+            std::sort(m_sources.begin() + first, m_sources.end(), [](const SourceFile& a, const SourceFile& b) { return a.path < b.path; });
+        }
+
+        for (const auto& source : m_sources) {
+            if (source.entry) {
+                m_entries.append(*source.entry);
+            }
+        }
+        buildTables();
+    }
+
+    DesktopIndex DesktopIndex::scan(const QStringList& directories) {
+        SourceFiles files;
+        for (const auto& root : directories) {
+            collectFiles(root, {}, files);
+        }
+        return DesktopIndex(directories, files);
+    }
+
+    DesktopIndex DesktopIndex::updated(const QSet<QString>& changedDirectories) const {
+        SourceFiles previous;
+        SourceFiles files;
+        previous.reserve(m_sources.size());
+        files.reserve(m_sources.size());
+
+        for (const auto& source : m_sources) {
+            previous.insert(source.path, source);
+
+            const bool relisted = std::any_of(changedDirectories.cbegin(), changedDirectories.cend(), [&](const QString& dir) { return isBelow(source.path, dir); });
+            if (!relisted) {
+                files.insert(source.path, source);
+            }
+        }
+
+        // A directory that is gone lists nothing, which drops its entries
+        for (const auto& dir : changedDirectories) {
+            collectFiles(dir, previous, files);
+        }
+
+        return DesktopIndex(m_roots, files);
+    }
+
+    void DesktopIndex::collectFiles(const QString& directory, const SourceFiles& previous, SourceFiles& into) {
+        QDirIterator it(directory, QStringList() << "*.desktop", QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            const QString file  = it.next();
+            const qint64  mtime = modificationTime(file, false);
+
+            const auto    known = previous.constFind(file);
+            if (known != previous.cend() && mtime >= 0 && known->mtime == mtime) {
+                into.insert(file, *known);
+                continue;
+            }
+
+            into.insert(file, SourceFile{file, mtime, readDesktopEntry(file)});
+        }
+    }
+
+    void DesktopIndex::buildTables() {
+        m_byId.reserve(m_entries.size());
+        m_byFoldedId.reserve(m_entries.size());
+        m_byExec.reserve(m_entries.size());
+        m_byTryExec.reserve(m_entries.size());
+        m_byFoldedName.reserve(m_entries.size());
+
+        for (qsizetype row = 0; row < m_entries.size(); ++row) {
+            const DesktopInfo& d = m_entries.at(row);
+            indexFirst(m_byId, d.desktopId, row);
+            indexFirst(m_byFoldedId, d.desktopId.toCaseFolded(), row);
+            indexFirst(m_byExec, fileNameOf(d.exec).toString(), row);
+            indexFirst(m_byTryExec, fileNameOf(d.tryExec).toString(), row);
+            indexFirst(m_byFoldedName, d.name.toCaseFolded(), row);
+        }
+    }
+
+    DesktopIndex::DirectoryStamps DesktopIndex::directoryStamps(const QStringList& directories) {
+        DirectoryStamps stamps;
+        for (const auto& root : directories) {
+            const qint64 rootTime = modificationTime(root, true);
+            stamps.append({root, rootTime});
+            if (rootTime < 0)
+                continue;
+
+            // Adding or removing an entry touches its directory; a new subdirectory touches the parent
+            DirectoryStamps nested;
+            QDirIterator    it(root, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                const QString dir = it.next();
+                nested.append({dir, modificationTime(dir, true)});
+            }
+            std::sort(nested.begin(), nested.end());
+            stamps += nested;
+        }
+        return stamps;
+    }
+
+    bool DesktopIndex::saveSnapshot(const QString& path, const DirectoryStamps& stamps) const {
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly))
+            return false;
+
+        QDataStream out(&file);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << SNAPSHOT_MAGIC << SNAPSHOT_VERSION << m_roots;
+
+        out << static_cast<quint32>(stamps.size());
+        for (const auto& [dir, time] : stamps) {
+            out << dir << time;
+        }
+
+        out << static_cast<quint32>(m_sources.size());
+        for (const auto& source : m_sources) {
+            out << source.path << source.mtime << source.entry.has_value();
+            if (const auto& d = source.entry) {
+                out << d->desktopId << d->name << d->iconName << d->exec << d->tryExec;
+            }
+        }
+
+        return out.status() == QDataStream::Ok && file.commit();
+    }
+
+    std::optional<DesktopIndex> DesktopIndex::loadSnapshot(const QString& path, DirectoryStamps* stamps) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly) || file.size() <= 0)
+            return std::nullopt;
+
+        uchar* data = file.map(0, file.size());
+        if (!data)
+            return std::nullopt;
+        const auto unmap = qScopeGuard([&] { file.unmap(data); });
+
+        // Strings are copied out while parsing, so nothing refers to the mapping afterwards
+        QDataStream in(QByteArray::fromRawData(reinterpret_cast<const char*>(data), file.size()));
+        in.setVersion(QDataStream::Qt_6_0);
+
+        quint32 magic   = 0;
+        quint32 version = 0;
+        in >> magic >> version;
+        if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION)
+            return std::nullopt;
+
+        QStringList roots;
+        in >> roots;
+
+        DirectoryStamps snapshotStamps;
+        quint32         stampCount = 0;
+        in >> stampCount;
+        for (quint32 i = 0; i < stampCount && in.status() == QDataStream::Ok; ++i) {
+            QString dir;
+            qint64  time = 0;
+            in >> dir >> time;
+            snapshotStamps.append({dir, time});
+        }
+
+        SourceFiles files;
+        quint32     sourceCount = 0;
+        in >> sourceCount;
+        for (quint32 i = 0; i < sourceCount && in.status() == QDataStream::Ok; ++i) {
+            SourceFile source;
+            bool       hasEntry = false;
+            in >> source.path >> source.mtime >> hasEntry;
+            if (hasEntry) {
+                DesktopInfo d;
+                in >> d.desktopId >> d.name >> d.iconName >> d.exec >> d.tryExec;
+                source.entry = std::move(d);
+            }
+            files.insert(source.path, std::move(source));
+        }
+
+        if (in.status() != QDataStream::Ok || !in.atEnd())
+            return std::nullopt;
+
+        if (stamps) {
+            *stamps = std::move(snapshotStamps);
+        }
+        return DesktopIndex(std::move(roots), files);
+    }
+
+    DesktopInfo DesktopIndex::find(QStringView exeOrName) const {
+        if (exeOrName.isEmpty())
+            return {};
+
+        const QString base = fileNameOf(exeOrName).toString();
+        if (base.isEmpty())
+            return {};
+
+        const QString desktopId = base + QStringLiteral(".desktop");
+        for (const auto& [table, key] : {std::pair{&m_byId, desktopId}, std::pair{&m_byFoldedId, desktopId.toCaseFolded()}, std::pair{&m_byExec, base},
+                                         std::pair{&m_byTryExec, base}, std::pair{&m_byFoldedName, base.toCaseFolded()}}) {
+            if (const DesktopInfo* d = lookup(*table, key))
+                return *d;
+        }
+
+        return {};
+    }
+
+    qsizetype DesktopIndex::size() const {
+        return m_entries.size();
+    }
+
+    bool DesktopIndex::isEmpty() const {
+        return m_entries.isEmpty();
+    }
+
+    const DesktopInfo* DesktopIndex::lookup(const QHash<QString, qsizetype>& table, const QString& key) const {
+        const auto it = table.constFind(key);
+        return it != table.cend() ? &m_entries.at(*it) : nullptr;
+    }
+
+} // namespace bb
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "RequestContext.hpp"
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+#include <optional>
+#include <utility>
+
+namespace bb {
+
+    // Installed .desktop entries with precomputed lookup tables
+    // Each key maps to the first entry carrying it, so lookups keep the scan-order precedence
+    class DesktopIndex {
+      public:
+        DesktopIndex() = default;
+        explicit DesktopIndex(QList<DesktopInfo> entries);
+
+        // Modification time of every directory scan() walks, in nanoseconds; -1 for a missing root
+        // A snapshot taken with equal stamps still matches what is installed
+        using DirectoryStamps = QList<std::pair<QString, qint64>>;
+
+        // Read every displayable *.desktop file below the given directories
+        // Directories keep their order; files within one are taken in path order
+        static DesktopIndex                scan(const QStringList& directories);
+        static DirectoryStamps             directoryStamps(const QStringList& directories);
+
+        // Re-list only the changed directories and everything below them; a file whose
+        // modification time is unchanged keeps its parsed entry, the rest is carried over
+        DesktopIndex                       updated(const QSet<QString>& changedDirectories) const;
+
+        // Compact binary snapshot, written atomically and read back through a memory mapping
+        bool                               saveSnapshot(const QString& path, const DirectoryStamps& stamps) const;
+        static std::optional<DesktopIndex> loadSnapshot(const QString& path, DirectoryStamps* stamps = nullptr);
+
+        // Match an executable path or process name, in order of precedence:
+        // <base>.desktop, the same case-insensitively, Exec basename, TryExec basename,
+        // then Name case-insensitively
+        DesktopInfo find(QStringView exeOrName) const;
+
+        qsizetype   size() const;
+        bool        isEmpty() const;
+
+      private:
+        // One scanned file; hidden and nameless ones are kept too, so they aren't re-read
+        struct SourceFile {
+            QString                    path;
+            qint64                     mtime = -1;
+            std::optional<DesktopInfo> entry;
+        };
+        using SourceFiles = QHash<QString, SourceFile>;
+
+        DesktopIndex(QStringList roots, const SourceFiles& files);
+
+        static void               collectFiles(const QString& directory, const SourceFiles& previous, SourceFiles& into);
+        void                      buildTables();
+        const DesktopInfo*        lookup(const QHash<QString, qsizetype>& table, const QString& key) const;
+
+        QStringList               m_roots;
+        QList<SourceFile>         m_sources;
+        QList<DesktopInfo>        m_entries;
+        QHash<QString, qsizetype> m_byId;
+        QHash<QString, qsizetype> m_byFoldedId;
+        QHash<QString, qsizetype> m_byExec;
+        QHash<QString, qsizetype> m_byTryExec;
+        QHash<QString, qsizetype> m_byFoldedName;
+    };
+
+} // namespace bb
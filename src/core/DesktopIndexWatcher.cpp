@@ -0,0 +1,111 @@
+#include "DesktopIndexWatcher.hpp"
+
+#include <QDirIterator>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <utility>
+
+namespace bb {
+
+    namespace {
+
+        inline constexpr int DESKTOP_INDEX_DEBOUNCE_MS = 1000;
+
+    } // namespace
+
+    DesktopIndexWatcher::DesktopIndexWatcher(const QStringList& directories, QObject* parent) : QObject(parent), m_roots(directories) {
+        m_debounce.setSingleShot(true);
+        m_debounce.setInterval(DESKTOP_INDEX_DEBOUNCE_MS);
+        connect(&m_debounce, &QTimer::timeout, this, &DesktopIndexWatcher::flush);
+        connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &DesktopIndexWatcher::onDirectoryChanged);
+
+        for (const auto& root : m_roots) {
+            watch(root);
+        }
+    }
+
+    void DesktopIndexWatcher::setDebounceInterval(int ms) {
+        m_debounce.setInterval(ms);
+    }
+
+    void DesktopIndexWatcher::onDirectoryChanged(const QString& path) {
+        if (const auto missing = m_missingRoots.constFind(path); missing != m_missingRoots.cend()) {
+            // Something changed next to a root that doesn't exist yet; only its creation matters
+            if (!QFileInfo(*missing).isDir())
+                return;
+            m_changed.insert(*missing);
+        } else if (isWatchedTree(path)) {
+            m_changed.insert(path);
+        } else {
+            // A parent that stopped standing in for its root, and is about to be unwatched
+            return;
+        }
+
+        // Trailing debounce: every change restarts the quiet period
+        m_debounce.start();
+    }
+
+    void DesktopIndexWatcher::flush() {
+        const QSet<QString> changed = std::exchange(m_changed, {});
+
+        // Pick up new subdirectories and roots that appeared or went away
+        for (auto it = m_missingRoots.cbegin(); it != m_missingRoots.cend(); ++it) {
+            if (!isWatchedTree(it.key())) {
+                m_watcher.removePath(it.key());
+            }
+        }
+        m_missingRoots.clear();
+        for (const auto& root : m_roots) {
+            watch(root);
+        }
+        for (const auto& dir : changed) {
+            if (QFileInfo(dir).isDir()) {
+                watchTree(dir);
+            }
+        }
+
+        emit directoriesChanged(changed);
+    }
+
+    bool DesktopIndexWatcher::isWatchedTree(const QString& path) const {
+        return std::any_of(m_roots.cbegin(), m_roots.cend(), [&](const QString& root) { return path == root || path.startsWith(root + u'/'); });
+    }
+
+    void DesktopIndexWatcher::watch(const QString& root) {
+        if (QFileInfo(root).isDir()) {
+            watchTree(root);
+            return;
+        }
+
+        const QString parent = QFileInfo(root).path();
+        if (QFileInfo(parent).isDir()) {
+            m_missingRoots.insert(parent, root);
+            if (!m_watcher.directories().contains(parent)) {
+                m_watcher.addPath(parent);
+            }
+        }
+    }
+
+    void DesktopIndexWatcher::watchTree(const QString& directory) {
+        const QStringList watched = m_watcher.directories();
+
+        QStringList       added;
+        if (!watched.contains(directory)) {
+            added << directory;
+        }
+
+        QDirIterator it(directory, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            const QString dir = it.next();
+            if (!watched.contains(dir)) {
+                added << dir;
+            }
+        }
+
+        if (!added.isEmpty()) {
+            m_watcher.addPaths(added);
+        }
+    }
+
+} // namespace bb
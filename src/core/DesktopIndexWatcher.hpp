@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+namespace bb {
+
+    // Watches the application directories (and their subdirectories) through inotify
+    // A burst of changes, like a package manager transaction, is reported once it settles
+    class DesktopIndexWatcher : public QObject {
+        Q_OBJECT
+
+      public:
+        explicit DesktopIndexWatcher(const QStringList& directories, QObject* parent = nullptr);
+
+        // Quiet period after the last change before directoriesChanged() fires
+        void setDebounceInterval(int ms);
+
+      signals:
+        // Directories whose contents changed, to be re-listed recursively; may include removed ones
+        void directoriesChanged(const QSet<QString>& directories);
+
+      private:
+        void                    onDirectoryChanged(const QString& path);
+        void                    flush();
+        void                    watch(const QString& root);
+        void                    watchTree(const QString& directory);
+        bool                    isWatchedTree(const QString& path) const;
+
+        QStringList             m_roots;
+        QFileSystemWatcher      m_watcher;
+        QTimer                  m_debounce;
+        QSet<QString>           m_changed;
+        // Parent directory -> root that does not exist yet; the root is watched once it appears
+        QHash<QString, QString> m_missingRoots;
+    };
+
+} // namespace bb
@@ -0,0 +1,75 @@
+#include "ProcessCache.hpp"
+
+namespace bb {
+
+    ProcessCache::ProcessCache(ProcReader procReader, StampReader stampReader, qsizetype procCapacity, qsizetype actorCapacity) :
+        m_procReader(std::move(procReader)), m_stampReader(std::move(stampReader)), m_procs(procCapacity), m_actors(actorCapacity) {}
+
+    std::optional<ProcInfo> ProcessCache::readProc(qint64 pid) {
+        const auto stamp = m_stampReader(pid);
+        if (!stamp) {
+            std::lock_guard lock(m_mutex);
+            ++m_stats.procMisses;
+        } else {
+            std::lock_guard  lock(m_mutex);
+            const ProcessKey key{pid, stamp->startTime};
+            // A reparented process keeps its start time and comm, but the walk must follow its new parent
+            if (const ProcInfo* cached = m_procs.object(key); cached && cached->name == stamp->name && cached->ppid == stamp->ppid) {
+                ++m_stats.procHits;
+                ProcInfo info = *cached;
+                info.uid      = stamp->uid;
+                info.euid     = stamp->euid;
+                return info;
+            }
+            ++m_stats.procMisses;
+        }
+
+        auto info = m_procReader(pid);
+        if (stamp) {
+            std::lock_guard  lock(m_mutex);
+            const ProcessKey key{pid, stamp->startTime};
+            if (info && info->startTime == stamp->startTime) {
+                m_procs.insert(key, new ProcInfo(*info));
+            } else {
+                m_procs.remove(key);
+            }
+        }
+        return info;
+    }
+
+    ActorInfo ProcessCache::resolveRequestor(const ProcInfo& subject, qint64 agentUid, quint64 indexGeneration) {
+        // The subject was just read, so its start time, name, parent and credentials are current
+        const ActorKey key{{subject.pid, subject.startTime}, agentUid, indexGeneration};
+        {
+            std::lock_guard lock(m_mutex);
+            if (subject.startTime != 0) {
+                const CachedActor* cached = m_actors.object(key);
+                if (cached && cached->name == subject.name && cached->ppid == subject.ppid && cached->uid == subject.uid && cached->euid == subject.euid) {
+                    ++m_stats.actorHits;
+                    return cached->actor;
+                }
+            }
+            ++m_stats.actorMisses;
+        }
+
+        // Two threads missing on the same key both resolve; the second insert just replaces the first
+        ActorInfo actor = RequestContextHelper::resolveRequestorFromSubject(subject, agentUid, [this](qint64 pid) { return readProc(pid); });
+        if (subject.startTime != 0) {
+            std::lock_guard lock(m_mutex);
+            m_actors.insert(key, new CachedActor{actor, subject.name, subject.ppid, subject.uid, subject.euid});
+        }
+        return actor;
+    }
+
+    ProcessCacheStats ProcessCache::stats() const {
+        std::lock_guard lock(m_mutex);
+        return m_stats;
+    }
+
+    void ProcessCache::clear() {
+        std::lock_guard lock(m_mutex);
+        m_procs.clear();
+        m_actors.clear();
+    }
+
+} // namespace bb
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "RequestContext.hpp"
+
+#include <QCache>
+#include <QHashFunctions>
+
+#include <functional>
+#include <mutex>
+#include <optional>
+
+namespace bb {
+
+    struct ProcessCacheStats {
+        quint64 procHits    = 0;
+        quint64 procMisses  = 0;
+        quint64 actorHits   = 0;
+        quint64 actorMisses = 0;
+    };
+
+    // Bounded LRU caches of ProcInfo and resolved requestors, keyed by pid and start time,
+    // so a recycled pid never returns another process's entry
+    // Every lookup re-reads /proc/<pid>/stat and the credentials in status; a changed comm (exec)
+    // or parent (reparenting) also invalidates, and uid/euid are always the freshly read ones
+    // Safe to share between threads; /proc is read outside the lock
+    class ProcessCache {
+      public:
+        using ProcReader  = std::function<std::optional<ProcInfo>(qint64)>;
+        using StampReader = std::function<std::optional<ProcStamp>(qint64)>;
+
+        ProcessCache(ProcReader procReader, StampReader stampReader, qsizetype procCapacity = 256, qsizetype actorCapacity = 64);
+
+        // ProcInfo for a live pid; the full status, exe and cmdline reads only happen on a miss
+        std::optional<ProcInfo>  readProc(qint64 pid);
+
+        // resolveRequestorFromSubject() through the cache; indexGeneration names the desktop
+        // index the result is valid for, since a refreshed index may match differently
+        ActorInfo                resolveRequestor(const ProcInfo& subject, qint64 agentUid, quint64 indexGeneration);
+
+        ProcessCacheStats        stats() const;
+        void                     clear();
+
+      private:
+        struct ProcessKey {
+            qint64  pid       = 0;
+            quint64 startTime = 0;
+
+            friend bool operator==(const ProcessKey& a, const ProcessKey& b) {
+                return a.pid == b.pid && a.startTime == b.startTime;
+            }
+            friend size_t qHash(const ProcessKey& key, size_t seed = 0) {
+                return qHashMulti(seed, key.pid, key.startTime);
+            }
+        };
+
+        struct ActorKey {
+            ProcessKey process;
+            qint64     agentUid        = 0;
+            quint64    indexGeneration = 0;
+
+            friend bool operator==(const ActorKey& a, const ActorKey& b) {
+                return a.process == b.process && a.agentUid == b.agentUid && a.indexGeneration == b.indexGeneration;
+            }
+            friend size_t qHash(const ActorKey& key, size_t seed = 0) {
+                return qHashMulti(seed, key.process, key.agentUid, key.indexGeneration);
+            }
+        };
+
+        // Cached value plus what the subject looked like when it was resolved
+        struct CachedActor {
+            ActorInfo actor;
+            QString   name;
+            qint64    ppid = 0;
+            qint64    uid  = 0;
+            qint64    euid = 0;
+        };
+
+        ProcReader                    m_procReader;
+        StampReader                   m_stampReader;
+        mutable std::mutex            m_mutex;
+        QCache<ProcessKey, ProcInfo>  m_procs;
+        QCache<ActorKey, CachedActor> m_actors;
+        ProcessCacheStats             m_stats;
+    };
+
+} // namespace bb
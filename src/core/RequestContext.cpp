@@ -1,14 +1,28 @@
 #include "RequestContext.hpp"
+#include "DesktopIndex.hpp"
+#include "DesktopIndexWatcher.hpp"
+#include "ProcessCache.hpp"
+#include <QCoreApplication>
 #include <QFile>
+#include <QDir>
 #include <QFileInfo>
 #include <QTextStream>
-#include <QDir>
-#include <QDirIterator>
 #include <QStandardPaths>
-#include <QSettings>
 #include <QProcess>
 #include <QDebug>
+#include <QScopeGuard>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <mutex>
+#include <utility>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
 
 QJsonObject ProcInfo::toJson() const {
     QJsonObject obj;
@@ -64,135 +78,366 @@ std::optional<qint64> RequestContextHelper::extractCallerPid(const PolkitQt1::De
     return std::nullopt;
 }
 
-std::optional<ProcInfo> RequestContextHelper::readProc(qint64 pid) {
-    ProcInfo info;
-    info.pid = pid;
+// Next whitespace-separated token of a /proc line, consumed from rest
+static QByteArrayView takeField(QByteArrayView& rest) {
+    rest = rest.trimmed();
+    qsizetype end = 0;
+    while (end < rest.size() && rest.at(end) != ' ' && rest.at(end) != '\t') {
+        ++end;
+    }
+    const QByteArrayView field = rest.first(end);
+    rest                       = rest.sliced(end);
+    return field;
+}
 
-    // 1. Read Status first (world-readable, metadata hero)
-    QFile fStat(QString("/proc/%1/status").arg(pid));
-    if (fStat.open(QIODevice::ReadOnly)) {
-        QByteArray data = fStat.readAll();
-        fStat.close();
-        if (data.isEmpty()) {
-            qDebug() << "readProc: /proc/" << pid << "/status is EMPTY";
+// A small /proc file in one go, at most size bytes; -1 if it can't be opened
+static ssize_t readProcFile(int dirfd, const char* name, char* buffer, size_t size) {
+    const int fd = ::openat(dirfd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    size_t total = 0;
+    while (total < size) {
+        const ssize_t n = ::read(fd, buffer + total, size - total);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        total += static_cast<size_t>(n);
+    }
+    ::close(fd);
+    return static_cast<ssize_t>(total);
+}
+
+static void parseStatus(QByteArrayView status, ProcInfo& info) {
+    // Name, PPid and Uid are all in the first few lines; the rest is never looked at
+    int wanted = 3;
+    while (wanted > 0 && !status.isEmpty()) {
+        const qsizetype      eol  = status.indexOf('\n');
+        const QByteArrayView line = eol < 0 ? status : status.first(eol);
+        status                    = eol < 0 ? QByteArrayView() : status.sliced(eol + 1);
+
+        if (line.startsWith("Name:")) {
+            info.name = QString::fromUtf8(line.sliced(5).trimmed());
+            --wanted;
+        } else if (line.startsWith("PPid:")) {
+            info.ppid = line.sliced(5).trimmed().toLongLong();
+            --wanted;
+        } else if (line.startsWith("Uid:")) {
+            QByteArrayView ids = line.sliced(4);
+            info.uid           = takeField(ids).toLongLong();
+            info.euid          = takeField(ids).toLongLong();
+            --wanted;
         }
-        QStringList lines = QString::fromUtf8(data).split('\n');
-        for (const auto& line : lines) {
-            if (line.startsWith("Name:")) {
-                info.name = line.section(':', 1).trimmed();
-            } else if (line.startsWith("PPid:")) {
-                info.ppid = line.section(':', 1).trimmed().toLongLong();
-            } else if (line.startsWith("Uid:")) {
-                QStringList parts = line.section(':', 1).simplified().split(' ');
-                if (parts.size() >= 1)
-                    info.uid = parts[0].toLongLong();
-                if (parts.size() >= 2)
-                    info.euid = parts[1].toLongLong();
+    }
+}
+
+static std::optional<ProcStamp> parseStamp(QByteArrayView stat) {
+    // "pid (comm) state ppid ...": comm may hold spaces and parentheses, so count from the last ')'
+    const qsizetype commBegin = stat.indexOf('(');
+    const qsizetype commEnd   = stat.lastIndexOf(')');
+    if (commBegin < 0 || commEnd < commBegin)
+        return std::nullopt;
+
+    ProcStamp stamp;
+    stamp.name          = QString::fromUtf8(stat.sliced(commBegin + 1, commEnd - commBegin - 1));
+
+    QByteArrayView rest = stat.sliced(commEnd + 1);
+    takeField(rest); // state
+    stamp.ppid = takeField(rest).toLongLong();
+    for (int field = 5; field < 22; ++field) {
+        takeField(rest);
+    }
+    stamp.startTime = takeField(rest).toULongLong();
+    return stamp;
+}
+
+static QString readCmdline(int dirfd) {
+    const int fd = ::openat(dirfd, "cmdline", O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return {};
+
+    QByteArray data;
+    char       chunk[4096];
+    for (;;) {
+        const ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        data.append(chunk, n);
+    }
+    ::close(fd);
+
+    // Arguments are NUL-terminated; empty ones are dropped and the rest joined with spaces
+    QByteArray joined;
+    joined.reserve(data.size());
+    for (qsizetype begin = 0; begin < data.size();) {
+        qsizetype end = data.indexOf('\0', begin);
+        if (end < 0) {
+            end = data.size();
+        }
+        if (end > begin) {
+            if (!joined.isEmpty()) {
+                joined.append(' ');
             }
+            joined.append(data.constData() + begin, end - begin);
         }
-    } else {
-        qDebug() << "readProc: Failed to open /proc/" << pid << "/status:" << fStat.errorString();
+        begin = end + 1;
+    }
+    return QString::fromUtf8(joined);
+}
+
+std::optional<ProcInfo> RequestContextHelper::readProc(qint64 pid) {
+    // Every file is opened relative to one /proc/<pid> handle, so they all describe the same process
+    char path[32];
+    std::snprintf(path, sizeof(path), "/proc/%lld", static_cast<long long>(pid));
+    const int dirfd = ::open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirfd < 0) {
+        qDebug() << "readProc: Failed to open /proc/" << pid << ":" << strerror(errno);
+        return std::nullopt;
+    }
+    const auto closeDir = qScopeGuard([dirfd] { ::close(dirfd); });
+
+    ProcInfo   info;
+    info.pid = pid;
+
+    // 1. Status (world-readable, metadata hero)
+    char          buffer[4096];
+    const ssize_t statusSize = readProcFile(dirfd, "status", buffer, sizeof(buffer));
+    if (statusSize < 0) {
+        qDebug() << "readProc: Failed to open /proc/" << pid << "/status:" << strerror(errno);
         return std::nullopt;
     }
+    parseStatus(QByteArrayView(buffer, statusSize), info);
 
-    // 2. Try to read Exe (May fail if root/setuid, but that's okay now)
-    info.exe = QFileInfo(QString("/proc/%1/exe").arg(pid)).symLinkTarget();
-
-    // 3. Cmdline
-    QFile fCmd(QString("/proc/%1/cmdline").arg(pid));
-    if (fCmd.open(QIODevice::ReadOnly)) {
-        QByteArray data = fCmd.readAll();
-        fCmd.close();
-        QList<QByteArray> args = data.split('\0');
-        QStringList       cleanArgs;
-        for (const auto& a : args)
-            if (!a.isEmpty())
-                cleanArgs << QString::fromUtf8(a);
-        info.cmdline = cleanArgs.join(" ");
+    // 2. Start time, which tells a recycled pid apart
+    const ssize_t statSize = readProcFile(dirfd, "stat", buffer, sizeof(buffer));
+    if (const auto stamp = statSize > 0 ? parseStamp(QByteArrayView(buffer, statSize)) : std::nullopt) {
+        info.startTime = stamp->startTime;
     }
 
+    // 3. Exe (may fail if root/setuid, but that's okay now)
+    char          target[PATH_MAX];
+    const ssize_t targetSize = ::readlinkat(dirfd, "exe", target, sizeof(target));
+    if (targetSize > 0) {
+        info.exe = QFile::decodeName(QByteArray(target, targetSize));
+    }
+
+    // 4. Cmdline
+    info.cmdline = readCmdline(dirfd);
+
     return info;
 }
 
-static QList<DesktopInfo> g_desktopIndex;
-static bool               g_indexDone = false;
-
-void                      RequestContextHelper::ensureDesktopIndex() {
-    if (g_indexDone)
-        return;
-    g_indexDone = true;
-
-    QStringList paths = QStandardPaths::standardLocations(QStandardPaths::ApplicationsLocation);
-    for (const auto& path : paths) {
-        QDirIterator it(path, QStringList() << "*.desktop", QDir::Files, QDirIterator::Subdirectories);
-        while (it.hasNext()) {
-            QString   file = it.next();
-            QSettings settings(file, QSettings::IniFormat);
-            settings.beginGroup("Desktop Entry");
-
-            if (settings.value("NoDisplay", false).toBool())
-                continue;
-
-            DesktopInfo d;
-            d.desktopId = QFileInfo(file).fileName();
-            d.name      = settings.value("Name").toString();
-            d.iconName  = settings.value("Icon").toString();
-            d.exec      = settings.value("Exec").toString().split(' ').first().remove('"');
-            d.tryExec   = settings.value("TryExec").toString();
-
-            // We'll store the Exec string too for matching if needed,
-            // but for now let's just use the index.
-            // Matching will be done by filename vs exe basename mostly.
-
-            if (!d.name.isEmpty()) {
-                g_desktopIndex << d;
-            }
-        }
+std::optional<ProcStamp> RequestContextHelper::readProcStamp(qint64 pid) {
+    char path[32];
+    std::snprintf(path, sizeof(path), "/proc/%lld", static_cast<long long>(pid));
+    const int dirfd = ::open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirfd < 0)
+        return std::nullopt;
+    const auto closeDir = qScopeGuard([dirfd] { ::close(dirfd); });
+
+    char          buffer[4096];
+    const ssize_t statSize = readProcFile(dirfd, "stat", buffer, sizeof(buffer));
+    auto          stamp    = statSize > 0 ? parseStamp(QByteArrayView(buffer, statSize)) : std::nullopt;
+    if (!stamp)
+        return std::nullopt;
+
+    // Credentials are never served from the cache; the few status lines holding them are read every time
+    const ssize_t statusSize = readProcFile(dirfd, "status", buffer, sizeof(buffer));
+    if (statusSize < 0)
+        return std::nullopt;
+    ProcInfo credentials;
+    parseStatus(QByteArrayView(buffer, statusSize), credentials);
+    stamp->uid  = credentials.uid;
+    stamp->euid = credentials.euid;
+    return stamp;
+}
+
+static bool pidfdExited(int pidfd) {
+    pollfd pfd{pidfd, POLLIN, 0};
+    return ::poll(&pfd, 1, 0) != 0;
+}
+
+std::optional<ProcInfo> RequestContextHelper::readProc(qint64 pid, int pidfd) {
+    if (pidfd < 0) {
+        return readProc(pid);
+    }
+
+    if (pidfdExited(pidfd)) {
+        return std::nullopt;
     }
+
+    std::optional<ProcInfo> info = readProc(pid);
+
+    // Still alive afterwards means /proc/<pid> described the process behind pidfd
+    if (!info || pidfdExited(pidfd)) {
+        return std::nullopt;
+    }
+
+    return info;
 }
 
-DesktopInfo RequestContextHelper::findDesktopForExe(const QString& exePath) {
-    ensureDesktopIndex();
-    if (exePath.isEmpty())
-        return {};
+// Shared with the build thread and never destroyed, so a build still running at exit stays safe
+struct DesktopIndexState {
+    std::mutex                              mutex;
+    std::condition_variable                 ready;
+    std::shared_ptr<const bb::DesktopIndex> index;
+    bool                                    started  = false;
+    bool                                    building = false;
+    // Bumped whenever index is replaced; cached requestors resolved against an older one are stale
+    quint64                                 generation = 0;
+    // Changes seen while a build or refresh runs; it applies them before publishing
+    QSet<QString>                           pendingChanges;
+    QStringList                             directories;
+    QString                                 snapshot;
+};
+
+static DesktopIndexState& desktopIndexState() {
+    static auto* state = new DesktopIndexState;
+    return *state;
+}
 
-    QString base = QFileInfo(exePath).fileName();
+static QString desktopSnapshotPath() {
+    const QString stateRoot = QStandardPaths::writableLocation(QStandardPaths::GenericStateLocation);
+    if (stateRoot.isEmpty() || !QDir().mkpath(stateRoot + "/bb-auth"))
+        return {};
+    return stateRoot + "/bb-auth/desktop-index.bin";
+}
 
-    // 1. Exact match <base>.desktop
-    for (const auto& d : g_desktopIndex) {
-        if (d.desktopId == base + ".desktop")
-            return d;
+static void saveDesktopSnapshot(const bb::DesktopIndex& index, const QString& snapshot, const bb::DesktopIndex::DirectoryStamps& stamps) {
+    if (!snapshot.isEmpty() && !index.saveSnapshot(snapshot, stamps)) {
+        qWarning() << "Failed to write desktop index snapshot" << snapshot;
     }
+}
 
-    // 2. Case-insensitive match
-    for (const auto& d : g_desktopIndex) {
-        if (d.desktopId.compare(base + ".desktop", Qt::CaseInsensitive) == 0)
-            return d;
+void RequestContextHelper::preloadDesktopIndex() {
+    auto& state = desktopIndexState();
+    {
+        std::lock_guard lock(state.mutex);
+        if (state.started)
+            return;
+        state.started     = true;
+        state.building    = true;
+        state.directories = QStandardPaths::standardLocations(QStandardPaths::ApplicationsLocation);
+        state.snapshot    = desktopSnapshotPath();
     }
 
-    // 3. Match by Exec basename
-    for (const auto& d : g_desktopIndex) {
-        if (!d.exec.isEmpty() && QFileInfo(d.exec).fileName() == base)
-            return d;
+    const QStringList directories = state.directories;
+    const QString     snapshot    = state.snapshot;
+
+    // Watch before scanning, so nothing installed during the scan is missed
+    if (auto* app = QCoreApplication::instance()) {
+        auto* watcher = new bb::DesktopIndexWatcher(directories, app);
+        QObject::connect(watcher, &bb::DesktopIndexWatcher::directoriesChanged, watcher, [](const QSet<QString>& changed) { refreshDesktopIndex(changed); });
     }
 
-    // 4. Match by TryExec basename
-    for (const auto& d : g_desktopIndex) {
-        if (!d.tryExec.isEmpty() && QFileInfo(d.tryExec).fileName() == base)
-            return d;
+    // The previous run's snapshot answers lookups until the rescan below is done
+    bb::DesktopIndex::DirectoryStamps snapshotStamps;
+    bool                              haveSnapshot = false;
+    if (!snapshot.isEmpty()) {
+        if (auto loaded = bb::DesktopIndex::loadSnapshot(snapshot, &snapshotStamps)) {
+            std::lock_guard lock(state.mutex);
+            state.index  = std::make_shared<const bb::DesktopIndex>(std::move(*loaded));
+            ++state.generation;
+            haveSnapshot = true;
+        }
     }
 
-    // 5. Match by Name (case-insensitive)
-    for (const auto& d : g_desktopIndex) {
-        if (d.name.compare(base, Qt::CaseInsensitive) == 0)
-            return d;
+    std::thread([&state, directories, snapshot, snapshotStamps, haveSnapshot] {
+        const auto                              stamps = bb::DesktopIndex::directoryStamps(directories);
+        std::shared_ptr<const bb::DesktopIndex> index;
+        if (!haveSnapshot || stamps != snapshotStamps) {
+            // Stamps are taken before scanning, so a change during the scan is picked up next start
+            index = std::make_shared<const bb::DesktopIndex>(bb::DesktopIndex::scan(directories));
+            saveDesktopSnapshot(*index, snapshot, stamps);
+        }
+
+        std::unique_lock lock(state.mutex);
+        if (!index) {
+            index = state.index;
+        }
+        while (!state.pendingChanges.isEmpty()) {
+            const QSet<QString> changed = std::exchange(state.pendingChanges, {});
+            lock.unlock();
+            index = std::make_shared<const bb::DesktopIndex>(index->updated(changed));
+            lock.lock();
+        }
+
+        state.index    = std::move(index);
+        state.building = false;
+        ++state.generation;
+        state.ready.notify_all();
+    }).detach();
+}
+
+void RequestContextHelper::refreshDesktopIndex(const QSet<QString>& changedDirectories) {
+    auto&                                   state = desktopIndexState();
+    std::shared_ptr<const bb::DesktopIndex> current;
+    {
+        std::lock_guard lock(state.mutex);
+        state.pendingChanges += changedDirectories;
+        if (state.building) {
+            return;
+        }
+        state.building = true;
+        current        = state.index;
     }
 
-    return {};
+    // Stamping, parsing and writing the snapshot stay off the event loop; lookups keep the current index meanwhile
+    std::thread([&state, index = std::move(current)]() mutable {
+        std::unique_lock lock(state.mutex);
+        while (!state.pendingChanges.isEmpty()) {
+            const QSet<QString> changed = std::exchange(state.pendingChanges, {});
+            lock.unlock();
+            // Only files in the changed directories are looked at; unchanged ones keep their entry
+            const auto stamps = bb::DesktopIndex::directoryStamps(state.directories);
+            index             = std::make_shared<const bb::DesktopIndex>(index->updated(changed));
+            saveDesktopSnapshot(*index, state.snapshot, stamps);
+            lock.lock();
+        }
+
+        state.index    = std::move(index);
+        state.building = false;
+        ++state.generation;
+    }).detach();
+}
+
+std::shared_ptr<const bb::DesktopIndex> RequestContextHelper::desktopIndex() {
+    preloadDesktopIndex();
+
+    // Only the very first start, without any snapshot, has to wait for the scan
+    auto&            state = desktopIndexState();
+    std::unique_lock lock(state.mutex);
+    state.ready.wait(lock, [&state] { return state.index != nullptr; });
+    return state.index;
+}
+
+DesktopInfo RequestContextHelper::findDesktopForExe(const QString& exePath) {
+    if (exePath.isEmpty())
+        return {};
+
+    return desktopIndex()->find(exePath);
+}
+
+static bb::ProcessCache& processCache() {
+    static bb::ProcessCache cache([](qint64 pid) { return RequestContextHelper::readProc(pid); }, [](qint64 pid) { return RequestContextHelper::readProcStamp(pid); });
+    return cache;
 }
 
 ActorInfo RequestContextHelper::resolveRequestorFromSubject(const ProcInfo& subject, qint64 agentUid) {
-    return resolveRequestorFromSubject(subject, agentUid, [](qint64 pid) { return readProc(pid); });
+    quint64 generation = 0;
+    {
+        auto&           state = desktopIndexState();
+        std::lock_guard lock(state.mutex);
+        generation = state.generation;
+    }
+    return processCache().resolveRequestor(subject, agentUid, generation);
+}
+
+bb::ProcessCacheStats RequestContextHelper::processCacheStats() {
+    return processCache().stats();
 }
 
 ActorInfo RequestContextHelper::resolveRequestorFromSubject(const ProcInfo& subject, qint64 agentUid, std::function<std::optional<ProcInfo>(qint64)> procReader) {
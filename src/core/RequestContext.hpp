@@ -2,10 +2,17 @@
 
 #include <QString>
 #include <QJsonObject>
+#include <QSet>
 #include <optional>
 #include <functional>
+#include <memory>
 #include <polkitqt1-details.h>
 
+namespace bb {
+    class DesktopIndex;
+    struct ProcessCacheStats;
+}
+
 struct ProcInfo {
     qint64      pid  = 0;
     qint64      ppid = 0;
@@ -14,10 +21,21 @@ struct ProcInfo {
     QString     name;
     QString     exe;
     QString     cmdline;
+    // Clock ticks after boot (/proc/<pid>/stat field 22); with pid it names one process
+    quint64     startTime = 0;
 
     QJsonObject toJson() const;
 };
 
+// What /proc/<pid>/stat and the Uid line of status tell: enough to check that a cached ProcInfo still holds
+struct ProcStamp {
+    quint64 startTime = 0;
+    qint64  ppid      = 0; // changes without exec() when the parent exits and the process is reparented
+    qint64  uid       = 0; // both change without exec() through setuid() and friends
+    qint64  euid      = 0;
+    QString name;          // comm, which exec() replaces
+};
+
 struct DesktopInfo {
     QString desktopId;
     QString name;
@@ -44,15 +62,24 @@ struct ActorInfo {
 
 class RequestContextHelper {
   public:
-    static std::optional<qint64>   extractSubjectPid(const PolkitQt1::Details& details);
-    static std::optional<qint64>   extractCallerPid(const PolkitQt1::Details& details);
-    static std::optional<ProcInfo> readProc(qint64 pid);
-    static DesktopInfo             findDesktopForExe(const QString& exePath);
-    static ActorInfo               resolveRequestorFromSubject(const ProcInfo& subject, qint64 agentUid);
-    static ActorInfo               resolveRequestorFromSubject(const ProcInfo& subject, qint64 agentUid, std::function<std::optional<ProcInfo>(qint64)> procReader);
-    static QString                 normalizePrompt(QString s);
-    static QJsonObject             classifyRequest(const QString& source, const QString& title, const QString& description);
+    static std::optional<qint64>    extractSubjectPid(const PolkitQt1::Details& details);
+    static std::optional<qint64>    extractCallerPid(const PolkitQt1::Details& details);
+    static std::optional<ProcInfo>  readProc(qint64 pid);
+    // pidfd-verified: nullopt if the process exited around the read, so a recycled pid is never misattributed
+    static std::optional<ProcInfo>  readProc(qint64 pid, int pidfd);
+    static std::optional<ProcStamp> readProcStamp(qint64 pid);
+    static DesktopInfo              findDesktopForExe(const QString& exePath);
+    // Load the on-disk snapshot and rescan in the background; called once at daemon startup
+    static void                     preloadDesktopIndex();
+    // Answers repeated requests from the process cache; see processCacheStats()
+    static ActorInfo                resolveRequestorFromSubject(const ProcInfo& subject, qint64 agentUid);
+    static ActorInfo                resolveRequestorFromSubject(const ProcInfo& subject, qint64 agentUid, std::function<std::optional<ProcInfo>(qint64)> procReader);
+    static QString                  normalizePrompt(QString s);
+    static QJsonObject              classifyRequest(const QString& source, const QString& title, const QString& description);
+    static bb::ProcessCacheStats    processCacheStats();
 
   private:
-    static void ensureDesktopIndex();
+    static std::shared_ptr<const bb::DesktopIndex> desktopIndex();
+    // Re-read what changed below the given application directories on a worker; from the watcher
+    static void                                    refreshDesktopIndex(const QSet<QString>& changedDirectories);
 };
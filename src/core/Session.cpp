@@ -31,6 +31,10 @@ namespace bb {
         m_context.maxRetries = maxRetries > 0 ? maxRetries : 3;
     }
 
+    void Session::setRequestor(Requestor requestor) {
+        m_context.requestor = std::move(requestor);
+    }
+
     void Session::close(Result result) {
         m_result = result;
         m_state  = State::Closed;
@@ -132,6 +136,12 @@ namespace bb {
         return event;
     }
 
+    QJsonObject Session::toRequestorUpdatedEvent() const {
+        QJsonObject event  = toUpdatedEvent();
+        event["requestor"] = requestorToJson();
+        return event;
+    }
+
     QJsonObject Session::toClosedEvent() const {
         QJsonObject event{{"type", "session.closed"}, {"id", m_id}, {"result", resultToString(m_result.value_or(Result::Error))}};
 
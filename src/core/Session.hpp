@@ -67,17 +67,23 @@ namespace bb {
         [[nodiscard]] State state() const {
             return m_state;
         }
+        [[nodiscard]] const Requestor& requestor() const {
+            return m_context.requestor;
+        }
 
         // State transitions
         void setPrompt(const QString& prompt, bool echo = false, bool clearError = true);
         void setError(const QString& error);
         void setInfo(const QString& info);
         void setPinentryRetry(int curRetry, int maxRetries);
+        void setRequestor(Requestor requestor);
         void close(Result result);
 
         // Serialization (v2 protocol)
         [[nodiscard]] QJsonObject toCreatedEvent() const;
         [[nodiscard]] QJsonObject toUpdatedEvent() const;
+        // session.updated that also carries the requestor, once it was resolved
+        [[nodiscard]] QJsonObject toRequestorUpdatedEvent() const;
         [[nodiscard]] QJsonObject toClosedEvent() const;
 
       private:
@@ -12,11 +12,11 @@ namespace bb::agent {
         return !m_eventQueue.isEmpty();
     }
 
-    QJsonObject EventQueue::takeNext() {
-        return m_eventQueue.isEmpty() ? QJsonObject{} : m_eventQueue.takeFirst();
+    EncodedEvent EventQueue::takeNext() {
+        return m_eventQueue.isEmpty() ? EncodedEvent{} : m_eventQueue.takeFirst();
     }
 
-    void EventQueue::enqueue(const QJsonObject& event) {
+    void EventQueue::enqueue(const EncodedEvent& event) {
         if (m_eventQueue.size() >= m_maxSize) {
             m_eventQueue.dequeue();
         }
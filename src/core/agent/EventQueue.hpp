@@ -1,6 +1,7 @@
 #pragma once
 
-#include <QJsonObject>
+#include "../ipc/EncodedEvent.hpp"
+
 #include <QList>
 #include <QQueue>
 
@@ -12,13 +13,13 @@ namespace bb::agent {
       public:
         explicit EventQueue(int maxSize = 256);
 
-        bool        isEmpty() const;
-        bool        hasEvents() const;
-        QJsonObject takeNext();
+        bool         isEmpty() const;
+        bool         hasEvents() const;
+        EncodedEvent takeNext();
 
-        void        enqueue(const QJsonObject& event);
-        void        subscribeNext(QLocalSocket* socket);
-        void        removeWaiter(QLocalSocket* socket);
+        void         enqueue(const EncodedEvent& event);
+        void         subscribeNext(QLocalSocket* socket);
+        void         removeWaiter(QLocalSocket* socket);
 
         template <typename SendFn>
         void drainToWaiters(SendFn sendFn) {
@@ -30,7 +31,7 @@ namespace bb::agent {
 
       private:
         int                  m_maxSize;
-        QQueue<QJsonObject>  m_eventQueue;
+        QQueue<EncodedEvent> m_eventQueue;
         QList<QLocalSocket*> m_nextWaiters;
     };
 
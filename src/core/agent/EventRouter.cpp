@@ -7,9 +7,8 @@ namespace bb::agent {
 
     EventRouter::EventRouter(ProviderRegistry& providerRegistry, EventQueue& eventQueue) : m_providerRegistry(providerRegistry), m_eventQueue(eventQueue) {}
 
-    bool EventRouter::isSessionEventForProviderRouting(const QJsonObject& event) const {
-        const QString type = event.value("type").toString();
-        return type.startsWith("session.");
+    bool EventRouter::isSessionEventForProviderRouting(const EncodedEvent& event) const {
+        return event.type().startsWith("session.");
     }
 
 } // namespace bb::agent
@@ -1,9 +1,9 @@
 #pragma once
 
+#include "../ipc/EncodedEvent.hpp"
 #include "EventQueue.hpp"
 #include "ProviderRegistry.hpp"
 
-#include <QJsonObject>
 #include <QList>
 #include <QLocalSocket>
 
@@ -14,7 +14,7 @@ namespace bb::agent {
         EventRouter(ProviderRegistry& providerRegistry, EventQueue& eventQueue);
 
         template <typename SendFn>
-        void route(const QJsonObject& event, const QList<QLocalSocket*>& subscribers, SendFn sendFn) {
+        void route(const EncodedEvent& event, const QList<QLocalSocket*>& subscribers, SendFn sendFn) {
             if (isSessionEventForProviderRouting(event) && m_providerRegistry.hasActiveProvider()) {
                 QLocalSocket* activeProvider = m_providerRegistry.activeProvider();
                 if (activeProvider && activeProvider->isValid()) {
@@ -33,7 +33,7 @@ namespace bb::agent {
         }
 
       private:
-        bool              isSessionEventForProviderRouting(const QJsonObject& event) const;
+        bool              isSessionEventForProviderRouting(const EncodedEvent& event) const;
 
         ProviderRegistry& m_providerRegistry;
         EventQueue&       m_eventQueue;
@@ -1,6 +1,8 @@
 #include "ProviderRegistry.hpp"
+#include "../../common/Constants.hpp"
 
 #include <QDateTime>
+#include <QJsonArray>
 #include <QLocalSocket>
 #include <QUuid>
 
@@ -12,6 +14,15 @@ namespace bb::agent {
     namespace {
 
         inline constexpr qint64 PROVIDER_HEARTBEAT_TIMEOUT_MS = 15000;
+        inline constexpr qint64 QUIESCENT_PROBE_TIMEOUT_MS    = 5000;
+
+        // First instant recomputeActiveProvider() counts a provider stale; a quiescent one only with a probe out
+        std::optional<qint64>   expiresAtMs(const UIProvider& provider) {
+            if (provider.quiescent) {
+                return provider.probeDeadlineMs > 0 ? std::optional<qint64>(provider.probeDeadlineMs) : std::nullopt;
+            }
+            return provider.lastHeartbeatMs + PROVIDER_HEARTBEAT_TIMEOUT_MS + 1;
+        }
 
     } // namespace
 
@@ -19,7 +30,7 @@ namespace bb::agent {
 
     ProviderRegistry::ProviderRegistry(NowFn nowFn) : m_nowFn(std::move(nowFn)) {}
 
-    UIProvider ProviderRegistry::registerProvider(QLocalSocket* socket, const QJsonObject& msg) {
+    UIProvider ProviderRegistry::registerProvider(QLocalSocket* socket, const QJsonObject& msg, bool awaitingLaunch) {
         auto& provider = m_uiProviders[socket];
 
         if (provider.id.isEmpty()) {
@@ -47,7 +58,12 @@ namespace bb::agent {
             provider.priority = 50;
         }
 
+        provider.standby         = msg.value("standby").toBool();
+        provider.quiescent       = msg.value(json::KEY_CAPABILITIES).toArray().contains(QLatin1String(json::VAL_QUIESCENT));
+        provider.awaitingLaunch  = awaitingLaunch;
+        provider.probeDeadlineMs = 0;
         provider.lastHeartbeatMs = m_nowFn();
+        scheduleExpiry(socket, provider);
         return provider;
     }
 
@@ -58,6 +74,29 @@ namespace bb::agent {
         }
 
         it->lastHeartbeatMs = m_nowFn();
+        it->probeDeadlineMs = 0;
+        scheduleExpiry(socket, *it);
+        return true;
+    }
+
+    bool ProviderRegistry::probe(QLocalSocket* socket) {
+        auto it = m_uiProviders.find(socket);
+        if (it == m_uiProviders.end() || !it->quiescent || it->probeDeadlineMs > 0) {
+            return false;
+        }
+
+        it->probeDeadlineMs = m_nowFn() + QUIESCENT_PROBE_TIMEOUT_MS;
+        scheduleExpiry(socket, *it);
+        return true;
+    }
+
+    bool ProviderRegistry::confirmLaunch(QLocalSocket* socket) {
+        auto it = m_uiProviders.find(socket);
+        if (it == m_uiProviders.end() || !it->awaitingLaunch) {
+            return false;
+        }
+
+        it->awaitingLaunch = false;
         return true;
     }
 
@@ -81,12 +120,18 @@ namespace bb::agent {
             const auto&   provider = it.value();
 
             const bool    socketInvalid = (!socket || socket->state() != QLocalSocket::ConnectedState);
-            const bool    stale         = (nowMs - provider.lastHeartbeatMs) > PROVIDER_HEARTBEAT_TIMEOUT_MS;
+            const auto    expiry        = expiresAtMs(provider);
+            const bool    stale         = expiry && nowMs >= *expiry;
             if (socketInvalid || stale) {
                 it = m_uiProviders.erase(it);
                 continue;
             }
 
+            if (provider.standby || provider.awaitingLaunch) {
+                ++it;
+                continue;
+            }
+
             if (!bestSocket || provider.priority > bestPriority || (provider.priority == bestPriority && provider.lastHeartbeatMs > bestHeartbeat)) {
                 bestSocket    = socket;
                 bestPriority  = provider.priority;
@@ -108,6 +153,35 @@ namespace bb::agent {
         return recomputeActiveProvider();
     }
 
+    std::optional<qint64> ProviderRegistry::nextExpiryMs() {
+        while (!m_expiries.empty()) {
+            const Expiry next = m_expiries.top();
+            const auto   it   = m_uiProviders.constFind(next.socket);
+            if (it != m_uiProviders.cend() && expiresAtMs(*it) == next.atMs) {
+                return next.atMs;
+            }
+            m_expiries.pop();
+        }
+        return std::nullopt;
+    }
+
+    void ProviderRegistry::scheduleExpiry(QLocalSocket* socket, const UIProvider& provider) {
+        if (const auto expiry = expiresAtMs(provider)) {
+            m_expiries.push(Expiry{*expiry, socket});
+        }
+    }
+
+    QLocalSocket* ProviderRegistry::promoteStandby() {
+        for (auto it = m_uiProviders.begin(); it != m_uiProviders.end(); ++it) {
+            QLocalSocket* socket = it.key();
+            if (it->standby && socket && socket->state() == QLocalSocket::ConnectedState) {
+                it->standby = false;
+                return socket;
+            }
+        }
+        return nullptr;
+    }
+
     bool ProviderRegistry::isAuthorized(QLocalSocket* socket) const {
         if (m_uiProviders.isEmpty()) {
             return true;
@@ -4,6 +4,9 @@
 #include <QJsonObject>
 #include <QPointer>
 #include <functional>
+#include <optional>
+#include <queue>
+#include <vector>
 
 class QLocalSocket;
 
@@ -15,6 +18,10 @@ namespace bb::agent {
         QString kind;
         int     priority        = 0;
         qint64  lastHeartbeatMs = 0;
+        bool    standby         = false; // registered ahead of need; never active until promoted
+        bool    quiescent       = false; // sends no heartbeats; stays until its connection closes or it misses a probe
+        qint64  probeDeadlineMs = 0;     // quiescent only: when an unanswered probe makes it stale; 0 with none out
+        bool    awaitingLaunch  = false; // pre-registered for a launched provider that has not spoken yet
     };
 
     class ProviderRegistry {
@@ -24,27 +31,51 @@ namespace bb::agent {
         ProviderRegistry();
         explicit ProviderRegistry(NowFn nowFn);
 
-        UIProvider           registerProvider(QLocalSocket* socket, const QJsonObject& msg);
-        bool                 heartbeat(QLocalSocket* socket);
-        bool                 unregisterProvider(QLocalSocket* socket);
-        bool                 removeSocket(QLocalSocket* socket);
-        bool                 recomputeActiveProvider();
-        bool                 pruneStale();
+        // awaitingLaunch keeps the provider out of the running for active until confirmLaunch()
+        UIProvider            registerProvider(QLocalSocket* socket, const QJsonObject& msg, bool awaitingLaunch = false);
+        // The launched provider behind socket is up; true if that made it eligible
+        bool                  confirmLaunch(QLocalSocket* socket);
+        bool                  heartbeat(QLocalSocket* socket);
+        // Before a quiescent provider is handed a prompt: it goes stale unless a heartbeat answers within the
+        // probe timeout. False when there is nothing to send, for providers that heartbeat anyway or a probe already out
+        bool                  probe(QLocalSocket* socket);
+        bool                  unregisterProvider(QLocalSocket* socket);
+        bool                  removeSocket(QLocalSocket* socket);
+        bool                  recomputeActiveProvider();
+        bool                  pruneStale();
+        // Makes a standby provider eligible; recomputeActiveProvider() then picks it up
+        QLocalSocket*         promoteStandby();
+        // When the next provider goes stale unless it sends a heartbeat; nullopt with no heartbeat or probe awaited.
+        // Deadlines only ever move later, so a timer armed for this needs no rearming on heartbeats
+        std::optional<qint64> nextExpiryMs();
 
-        bool                 isAuthorized(QLocalSocket* socket) const;
-        bool                 hasActiveProvider() const;
+        bool                  isAuthorized(QLocalSocket* socket) const;
+        bool                  hasActiveProvider() const;
 
-        QLocalSocket*        activeProvider() const;
-        const UIProvider*    activeProviderInfo() const;
-        const UIProvider*    provider(QLocalSocket* socket) const;
-        bool                 contains(QLocalSocket* socket) const;
-        QList<QLocalSocket*> sockets() const;
+        QLocalSocket*         activeProvider() const;
+        const UIProvider*     activeProviderInfo() const;
+        const UIProvider*     provider(QLocalSocket* socket) const;
+        bool                  contains(QLocalSocket* socket) const;
+        QList<QLocalSocket*>  sockets() const;
 
       private:
-        NowFn                            m_nowFn;
+        struct Expiry {
+            qint64        atMs   = 0;
+            QLocalSocket* socket = nullptr;
 
-        QHash<QLocalSocket*, UIProvider> m_uiProviders;
-        QPointer<QLocalSocket>           m_activeProvider;
+            bool          operator>(const Expiry& other) const {
+                return atMs > other.atMs;
+            }
+        };
+
+        void                                                             scheduleExpiry(QLocalSocket* socket, const UIProvider& provider);
+
+        NowFn                                                            m_nowFn;
+
+        QHash<QLocalSocket*, UIProvider>                                 m_uiProviders;
+        QPointer<QLocalSocket>                                           m_activeProvider;
+        // Min-heap of staleness deadlines; entries a later heartbeat replaced are dropped when they surface
+        std::priority_queue<Expiry, std::vector<Expiry>, std::greater<>> m_expiries;
     };
 
 } // namespace bb::agent
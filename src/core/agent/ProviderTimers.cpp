@@ -0,0 +1,85 @@
+#include "ProviderTimers.hpp"
+
+#include <QDateTime>
+
+#include <algorithm>
+#include <limits>
+
+namespace bb::agent {
+
+    ProviderTimers::ProviderTimers(int maintenanceIntervalMs) {
+        m_maintenanceTimer.setInterval(maintenanceIntervalMs);
+        m_maintenanceTimer.setSingleShot(false);
+        m_standbyTimer.setSingleShot(true);
+        m_expiryTimer.setSingleShot(true);
+        m_registrationTimer.setSingleShot(true);
+
+        // Handlers are looked up when a timer fires, so they may be set after the timers are armed
+        QObject::connect(&m_maintenanceTimer, &QTimer::timeout, &m_maintenanceTimer, [this]() {
+            if (m_handlers.maintenance) {
+                m_handlers.maintenance();
+            }
+        });
+        QObject::connect(&m_standbyTimer, &QTimer::timeout, &m_standbyTimer, [this]() {
+            if (m_handlers.standbyCheck) {
+                m_handlers.standbyCheck();
+            }
+        });
+        QObject::connect(&m_expiryTimer, &QTimer::timeout, &m_expiryTimer, [this]() {
+            if (m_handlers.expiry) {
+                m_handlers.expiry();
+            }
+        });
+        QObject::connect(&m_registrationTimer, &QTimer::timeout, &m_registrationTimer, [this]() {
+            if (m_handlers.registrationDeadline) {
+                m_handlers.registrationDeadline();
+            }
+        });
+    }
+
+    void ProviderTimers::setHandlers(Handlers handlers) {
+        m_handlers = std::move(handlers);
+    }
+
+    void ProviderTimers::armExpiry(std::optional<qint64> atMs) {
+        arm(m_expiryTimer, atMs);
+    }
+
+    void ProviderTimers::armRegistrationDeadline(std::optional<qint64> atMs) {
+        arm(m_registrationTimer, atMs);
+    }
+
+    void ProviderTimers::armStandbyCheck(std::optional<qint64> atMs) {
+        arm(m_standbyTimer, atMs);
+    }
+
+    void ProviderTimers::startMaintenance() {
+        if (!m_maintenanceTimer.isActive()) {
+            m_maintenanceTimer.start();
+        }
+    }
+
+    void ProviderTimers::stopMaintenance() {
+        m_maintenanceTimer.stop();
+    }
+
+    bool ProviderTimers::maintenanceActive() const {
+        return m_maintenanceTimer.isActive();
+    }
+
+    bool ProviderTimers::idle() const {
+        return !m_maintenanceTimer.isActive() && !m_standbyTimer.isActive() && !m_expiryTimer.isActive() && !m_registrationTimer.isActive();
+    }
+
+    void ProviderTimers::arm(QTimer& timer, std::optional<qint64> atMs) {
+        if (!atMs) {
+            timer.stop();
+            return;
+        }
+
+        // A deadline already passed fires on the next loop iteration
+        const qint64 remainingMs = *atMs - QDateTime::currentMSecsSinceEpoch();
+        timer.start(static_cast<int>(std::clamp<qint64>(remainingMs, 0, std::numeric_limits<int>::max())));
+    }
+
+} // namespace bb::agent
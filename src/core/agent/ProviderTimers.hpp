@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QTimer>
+#include <QtGlobal>
+
+#include <functional>
+#include <optional>
+
+namespace bb::agent {
+
+    // The agent's provider bookkeeping timers. Each one is armed for the next deadline it is given and left
+    // stopped without one, so an agent with nothing to launch, expire or watch never wakes up on its own
+    class ProviderTimers {
+      public:
+        struct Handlers {
+            std::function<void()> maintenance;          // slow tick while sessions wait unserved, or a standby is registered
+            std::function<void()> standbyCheck;         // next standby start, or the registered standby's memory check
+            std::function<void()> expiry;               // next heartbeat or probe deadline
+            std::function<void()> registrationDeadline; // a launched provider's registration deadline, or a hedge start
+        };
+
+        explicit ProviderTimers(int maintenanceIntervalMs);
+
+        void setHandlers(Handlers handlers);
+
+        // Absolute times in ms since the epoch; nullopt stops the timer
+        void armExpiry(std::optional<qint64> atMs);
+        void armRegistrationDeadline(std::optional<qint64> atMs);
+        void armStandbyCheck(std::optional<qint64> atMs);
+
+        // Left running if it already is, so repeated calls do not push the next tick back
+        void startMaintenance();
+        void stopMaintenance();
+
+        bool maintenanceActive() const;
+        bool idle() const;
+
+      private:
+        static void arm(QTimer& timer, std::optional<qint64> atMs);
+
+        Handlers    m_handlers;
+        QTimer      m_maintenanceTimer;
+        QTimer      m_standbyTimer;
+        QTimer      m_expiryTimer;
+        QTimer      m_registrationTimer;
+    };
+
+} // namespace bb::agent
@@ -0,0 +1,48 @@
+#include "RequestorResolver.hpp"
+
+#include <QMetaObject>
+
+#include <unistd.h>
+
+namespace bb::agent {
+
+    namespace {
+
+        // Resolution is mostly blocking reads, but a handful of concurrent prompts is the realistic peak
+        inline constexpr int REQUESTOR_RESOLVER_THREADS = 2;
+
+        ActorInfo resolveFromProc(qint64 pid, int pidfd) {
+            const auto proc = pidfd >= 0 ? RequestContextHelper::readProc(pid, pidfd) : RequestContextHelper::readProc(pid);
+            if (!proc) {
+                return {};
+            }
+
+            return RequestContextHelper::resolveRequestorFromSubject(*proc, getuid());
+        }
+
+    } // namespace
+
+    RequestorResolver::RequestorResolver(QObject* parent) : RequestorResolver(resolveFromProc, parent) {}
+
+    RequestorResolver::RequestorResolver(ResolveFn resolveFn, QObject* parent) : QObject(parent), m_resolveFn(std::move(resolveFn)) {
+        m_pool.setMaxThreadCount(REQUESTOR_RESOLVER_THREADS);
+    }
+
+    RequestorResolver::~RequestorResolver() {
+        // Jobs post back to this object, so none may outlive it
+        m_pool.waitForDone();
+    }
+
+    void RequestorResolver::resolve(const QString& sessionId, qint64 pid, std::shared_ptr<const int> pidfd) {
+        // The destructor waits for the pool, so this outlives every job; a result still queued when it goes away is dropped
+        m_pool.start([this, sessionId, pid, pidfd = std::move(pidfd)]() {
+            ActorInfo actor = m_resolveFn(pid, pidfd ? *pidfd : -1);
+            QMetaObject::invokeMethod(this, [this, sessionId, pid, actor = std::move(actor)]() { emit resolved(sessionId, pid, actor); }, Qt::QueuedConnection);
+        });
+    }
+
+    void RequestorResolver::waitForIdle() {
+        m_pool.waitForDone();
+    }
+
+} // namespace bb::agent
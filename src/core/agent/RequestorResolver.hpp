@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../RequestContext.hpp"
+
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+#include <functional>
+#include <memory>
+
+namespace bb::agent {
+
+    // Resolves requestors on a small worker pool so /proc walks and desktop lookups
+    // never hold up the event loop; results come back on the resolver's thread
+    class RequestorResolver : public QObject {
+        Q_OBJECT
+
+      public:
+        // Runs on a worker; pidfd is -1 when the caller has none
+        using ResolveFn = std::function<ActorInfo(qint64 pid, int pidfd)>;
+
+        explicit RequestorResolver(QObject* parent = nullptr);
+        explicit RequestorResolver(ResolveFn resolveFn, QObject* parent = nullptr);
+        ~RequestorResolver() override;
+
+        // Returns at once; resolved() follows. pidfd is kept open until the job ran
+        void resolve(const QString& sessionId, qint64 pid, std::shared_ptr<const int> pidfd = {});
+
+        // Blocks until queued jobs finished; their results are still delivered through the event loop
+        void waitForIdle();
+
+      signals:
+        void resolved(const QString& sessionId, qint64 pid, const ActorInfo& actor);
+
+      private:
+        ResolveFn   m_resolveFn;
+        QThreadPool m_pool;
+    };
+
+} // namespace bb::agent
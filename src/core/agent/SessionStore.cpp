@@ -53,6 +53,16 @@ namespace bb::agent {
         return true;
     }
 
+    std::optional<QJsonObject> SessionStore::updateRequestor(const QString& id, const Session::Requestor& requestor) {
+        auto it = m_sessions.find(id);
+        if (it == m_sessions.end() || it->second->requestor().pid != requestor.pid) {
+            return std::nullopt;
+        }
+
+        it->second->setRequestor(requestor);
+        return it->second->toRequestorUpdatedEvent();
+    }
+
     std::optional<QJsonObject> SessionStore::closeSession(const QString& id, Session::Result result) {
         auto it = m_sessions.find(id);
         if (it == m_sessions.end()) {
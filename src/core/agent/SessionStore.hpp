@@ -17,6 +17,8 @@ namespace bb::agent {
         std::optional<QJsonObject> updateError(const QString& id, const QString& error);
         std::optional<QJsonObject> updateInfo(const QString& id, const QString& info);
         bool                       updatePinentryRetry(const QString& id, int curRetry, int maxRetries);
+        // Only applies to the session still announced for requestor.pid, so a late result never lands on a reused id
+        std::optional<QJsonObject> updateRequestor(const QString& id, const Session::Requestor& requestor);
         std::optional<QJsonObject> closeSession(const QString& id, Session::Result result);
         Session*                   getSession(const QString& id);
         const SessionMap&          sessions() const;
@@ -0,0 +1,41 @@
+#include "EncodedEvent.hpp"
+
+namespace bb {
+
+    EncodedEvent::EncodedEvent(const QJsonObject& json) : d(std::make_shared<Data>()) {
+        d->json      = json;
+        d->type      = json.value("type").toString();
+        d->jsonFrame = encodeFrame(json, FrameEncoding::Json);
+    }
+
+    const QJsonObject& EncodedEvent::json() const {
+        static const QJsonObject empty;
+        return d ? d->json : empty;
+    }
+
+    const QByteArray& EncodedEvent::frame(FrameEncoding encoding) const {
+        static const QByteArray empty;
+        if (!d) {
+            return empty;
+        }
+
+        if (encoding == FrameEncoding::Cbor) {
+            if (d->cborFrame.isEmpty()) {
+                d->cborFrame = encodeFrame(d->json, FrameEncoding::Cbor);
+            }
+            return d->cborFrame;
+        }
+
+        return d->jsonFrame;
+    }
+
+    const QString& EncodedEvent::type() const {
+        static const QString empty;
+        return d ? d->type : empty;
+    }
+
+    bool EncodedEvent::isEmpty() const {
+        return !d;
+    }
+
+} // namespace bb
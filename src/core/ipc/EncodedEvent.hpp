@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../../common/FrameCodec.hpp"
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+#include <memory>
+
+namespace bb {
+
+    // Outbound event serialized at most once per wire encoding.
+    // Copies share one encoding cache, so fanning an event out to many
+    // sockets never re-encodes it, whichever encoding each socket negotiated.
+    class EncodedEvent {
+      public:
+        EncodedEvent() = default;
+        explicit EncodedEvent(const QJsonObject& json);
+
+        const QJsonObject& json() const;
+        const QByteArray&  frame(FrameEncoding encoding = FrameEncoding::Json) const;
+        const QString&     type() const;
+        bool               isEmpty() const;
+
+      private:
+        struct Data {
+            QJsonObject json;
+            QString     type;
+            QByteArray  jsonFrame;
+            QByteArray  cborFrame; // encoded on first CBOR subscriber
+        };
+
+        std::shared_ptr<Data> d;
+    };
+
+} // namespace bb
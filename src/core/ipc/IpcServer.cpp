@@ -1,12 +1,15 @@
 #include "IpcServer.hpp"
+#include "SocketActivation.hpp"
 #include "../../common/Constants.hpp"
 
 #include <QFile>
-#include <QJsonDocument>
-#include <QJsonParseError>
+#include <QScopeGuard>
 
-#include <sys/socket.h>
+#include <cerrno>
 #include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 namespace bb {
 
@@ -28,9 +31,14 @@ namespace bb {
     }
 
     bool IpcServer::start(const QString& socketPath) {
-        if (m_server)
+        if (m_server || m_listenNotifier)
             return false;
 
+        // Socket activation: clients that connected while the daemon started are already queued on it
+        if (const int inherited = takeActivationSocket(socketPath); inherited >= 0) {
+            return adopt(inherited);
+        }
+
         // Remove stale socket file
         if (QFile::exists(socketPath)) {
             QFile::remove(socketPath);
@@ -49,19 +57,61 @@ namespace bb {
         return true;
     }
 
+    bool IpcServer::adopt(int listenFd) {
+        if (m_server || m_listenNotifier || listenFd < 0)
+            return false;
+
+        // QLocalServer would unlink the service manager's socket file on close, so accept directly
+        const int flags = ::fcntl(listenFd, F_GETFL);
+        if (flags < 0 || ::fcntl(listenFd, F_SETFL, flags | O_NONBLOCK) != 0) {
+            ::close(listenFd);
+            return false;
+        }
+
+        m_listenFd       = listenFd;
+        m_listenNotifier = new QSocketNotifier(static_cast<qintptr>(listenFd), QSocketNotifier::Read, this);
+        connect(m_listenNotifier, &QSocketNotifier::activated, this, &IpcServer::onInheritedConnection);
+        return true;
+    }
+
+    bool IpcServer::isSocketActivated() const {
+        return m_listenNotifier != nullptr;
+    }
+
     void IpcServer::stop() {
-        if (!m_server)
+        if (!m_server && !m_listenNotifier)
             return;
 
+        // Hand queued output to the sockets before they drain and close
+        flushPending();
+
         // Disconnect all clients
-        for (auto* socket : m_buffers.keys()) {
+        QList<QLocalSocket*> sockets;
+        sockets.reserve(static_cast<qsizetype>(m_connections.size()));
+        for (const auto& [socket, connection] : m_connections) {
+            sockets.append(socket);
+        }
+        for (auto* socket : sockets) {
             socket->disconnectFromServer();
         }
-        m_buffers.clear();
+        for (auto& [socket, connection] : m_connections) {
+            discardOutbox(connection);
+        }
+        m_connections.clear();
 
-        m_server->close();
-        delete m_server;
-        m_server = nullptr;
+        if (m_server) {
+            m_server->close();
+            delete m_server;
+            m_server = nullptr;
+        }
+
+        // Only our copy; connections made until the next start queue on the service manager's
+        if (m_listenNotifier) {
+            delete m_listenNotifier;
+            m_listenNotifier = nullptr;
+            ::close(m_listenFd);
+            m_listenFd = -1;
+        }
     }
 
     void IpcServer::setMessageHandler(MessageHandler handler) {
@@ -72,30 +122,214 @@ namespace bb {
         if (!socket || socket->state() != QLocalSocket::ConnectedState)
             return;
 
-        QByteArray data = QJsonDocument(json).toJson(QJsonDocument::Compact);
-        data.append('\n');
+        // Correlate the reply with the request being handled
+        if (socket == m_dispatchSocket && !m_dispatchRequestId.isUndefined() && !json.contains(json::KEY_REQUEST_ID)) {
+            QJsonObject tagged = json;
+            tagged.insert(json::KEY_REQUEST_ID, m_dispatchRequestId);
+            enqueueFrame(socket, OutboundFrame{encodeFrame(tagged, encoding(socket)), false, secureWipe});
+            return;
+        }
+
+        enqueueFrame(socket, OutboundFrame{encodeFrame(json, encoding(socket)), false, secureWipe});
+    }
+
+    void IpcServer::sendReply(QLocalSocket* socket, const QJsonObject& json, bool secureWipe) {
+        if (!socket || socket->state() != QLocalSocket::ConnectedState)
+            return;
+
+        enqueueFrame(socket, OutboundFrame{encodeFrame(json, encoding(socket)), false, secureWipe});
+    }
+
+    void IpcServer::sendEvent(QLocalSocket* socket, const EncodedEvent& event, bool droppable) {
+        if (!socket || socket->state() != QLocalSocket::ConnectedState || event.isEmpty())
+            return;
+
+        enqueueFrame(socket, OutboundFrame{event.frame(encoding(socket)), droppable, false});
+    }
+
+    void IpcServer::setWatermarks(qint64 lowBytes, qint64 highBytes) {
+        m_lowWatermark  = qMin(lowBytes, highBytes);
+        m_highWatermark = highBytes;
+    }
+
+    void IpcServer::setOverflowPolicy(OverflowPolicy policy) {
+        m_overflowPolicy = policy;
+    }
 
-        socket->write(data);
-        socket->flush();
+    void IpcServer::setExemptionCheck(ExemptionCheck check) {
+        m_exemptionCheck = std::move(check);
+    }
+
+    qint64 IpcServer::queuedBytes(QLocalSocket* socket) const {
+        const auto it = m_connections.find(socket);
+        if (it == m_connections.end())
+            return 0;
+
+        return socket->bytesToWrite() + it->second.outboxBytes;
+    }
 
-        if (secureWipe) {
-            secureZero(data.data(), static_cast<std::size_t>(data.size()));
+    const IpcServer::WriteStats& IpcServer::writeStats() const {
+        return m_writeStats;
+    }
+
+    void IpcServer::setEncoding(QLocalSocket* socket, FrameEncoding encoding) {
+        const auto it = m_connections.find(socket);
+        if (it != m_connections.end()) {
+            it->second.encoding = encoding;
         }
     }
 
-    pid_t IpcServer::getPeerPid(QLocalSocket* socket) {
-        if (!socket)
-            return -1;
+    FrameEncoding IpcServer::encoding(QLocalSocket* socket) const {
+        const auto it = m_connections.find(socket);
+        return it != m_connections.end() ? it->second.encoding : FrameEncoding::Json;
+    }
+
+    void IpcServer::enqueueFrame(QLocalSocket* socket, OutboundFrame frame) {
+        const auto it = m_connections.find(socket);
+        if (it == m_connections.end() || it->second.closing) {
+            if (frame.secureWipe) {
+                secureZero(frame.data.data(), static_cast<std::size_t>(frame.data.size()));
+            }
+            return;
+        }
+
+        Connection& connection = it->second;
+        connection.outboxBytes += frame.data.size();
+        connection.outbox.append(std::move(frame));
+
+        if (!isExempt(socket)) {
+            enforceWatermark(socket, connection);
+        }
+
+        scheduleFlush();
+    }
+
+    void IpcServer::enforceWatermark(QLocalSocket* socket, Connection& connection) {
+        const qint64 socketBytes = socket->bytesToWrite();
+        if (socketBytes + connection.outboxBytes <= m_highWatermark)
+            return;
+
+        const auto disconnect = [this, &connection]() {
+            // Aborted from the flush, never from inside a caller's send loop
+            connection.closing = true;
+            discardOutbox(connection);
+            ++m_writeStats.overflowDisconnects;
+        };
+
+        if (m_overflowPolicy == OverflowPolicy::Disconnect) {
+            disconnect();
+            return;
+        }
+
+        // Hold further output until the reader drains to the low watermark
+        connection.congested = true;
+        for (qsizetype i = 0; i < connection.outbox.size() && socketBytes + connection.outboxBytes > m_lowWatermark;) {
+            if (!connection.outbox[i].droppable) {
+                ++i;
+                continue;
+            }
+
+            connection.outboxBytes -= connection.outbox[i].data.size();
+            connection.outbox.removeAt(i);
+            ++m_writeStats.droppedFrames;
+        }
+
+        // Only frames it cannot lose are left; a session it never hears closed would stay on its screen
+        if (socketBytes + connection.outboxBytes > m_highWatermark) {
+            disconnect();
+        }
+    }
+
+    void IpcServer::flushConnection(QLocalSocket* socket, Connection& connection) {
+        if (connection.outbox.isEmpty())
+            return;
+
+        const bool exempt = isExempt(socket);
+        if (connection.congested && !exempt) {
+            if (socket->bytesToWrite() > m_lowWatermark)
+                return;
+            connection.congested = false;
+        }
+
+        bool wipe = false;
+        for (const auto& frame : connection.outbox) {
+            wipe = wipe || frame.secureWipe;
+        }
+
+        // One write per socket per iteration; a lone frame is handed over without copying
+        QByteArray merged;
+        if (connection.outbox.size() == 1) {
+            merged = connection.outbox.first().data;
+        } else {
+            merged.reserve(connection.outboxBytes);
+            for (const auto& frame : connection.outbox) {
+                merged.append(frame.data);
+            }
+        }
+
+        // Secrets are copied into the socket buffer so the wiped bytes are the only other copy
+        if (wipe) {
+            socket->write(merged.constData(), merged.size());
+        } else {
+            socket->write(merged);
+        }
+        ++m_writeStats.writeCalls;
+
+        if (wipe && connection.outbox.size() > 1) {
+            secureZero(merged.data(), static_cast<std::size_t>(merged.size()));
+        }
+        merged.clear();
+        discardOutbox(connection);
+
+        if (!exempt && socket->bytesToWrite() > m_highWatermark) {
+            connection.congested = true;
+        }
+    }
+
+    void IpcServer::flushPending() {
+        m_flushScheduled = false;
 
-        struct ucred cred;
-        socklen_t    len = sizeof(cred);
+        QList<QLocalSocket*> overflowed;
+        for (auto& [socket, connection] : m_connections) {
+            if (connection.closing) {
+                overflowed.append(socket);
+                continue;
+            }
+            flushConnection(socket, connection);
+        }
 
-        const int    fd = static_cast<int>(socket->socketDescriptor());
-        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == -1) {
-            return -1;
+        for (auto* socket : overflowed) {
+            socket->abort();
         }
+    }
+
+    void IpcServer::scheduleFlush() {
+        if (m_flushScheduled)
+            return;
+
+        m_flushScheduled = true;
+        QMetaObject::invokeMethod(this, &IpcServer::flushPending, Qt::QueuedConnection);
+    }
+
+    bool IpcServer::isExempt(QLocalSocket* socket) const {
+        return m_exemptionCheck && m_exemptionCheck(socket);
+    }
+
+    void IpcServer::discardOutbox(Connection& connection) {
+        for (auto& frame : connection.outbox) {
+            if (frame.secureWipe) {
+                secureZero(frame.data.data(), static_cast<std::size_t>(frame.data.size()));
+            }
+        }
+        connection.outbox.clear();
+        connection.outboxBytes = 0;
+    }
+
+    const PeerCredentials& IpcServer::peerCredentials(QLocalSocket* socket) const {
+        static const PeerCredentials unknown;
 
-        return cred.pid;
+        const auto                   it = m_connections.find(socket);
+        return it != m_connections.end() ? it->second.peer : unknown;
     }
 
     void IpcServer::onNewConnection() {
@@ -104,37 +338,86 @@ namespace bb {
             if (!socket)
                 continue;
 
-            m_buffers[socket] = QByteArray();
+            // One getsockopt per client instead of one per request
+            addConnection(socket, PeerCredentials::fromSocketDescriptor(socket->socketDescriptor()));
+        }
+    }
 
-            connect(socket, &QLocalSocket::readyRead, this, &IpcServer::onReadyRead);
-            connect(socket, &QLocalSocket::disconnected, this, &IpcServer::onDisconnected);
+    void IpcServer::onInheritedConnection() {
+        while (m_listenNotifier) {
+            const int fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                return;
+            }
 
-            emit clientConnected(socket);
+            auto* socket = new QLocalSocket(m_listenNotifier);
+            if (!socket->setSocketDescriptor(fd)) {
+                ::close(fd);
+                delete socket;
+                continue;
+            }
+
+            addConnection(socket, PeerCredentials::fromSocketDescriptor(fd));
         }
     }
 
+    QLocalSocket* IpcServer::adoptConnection(int fd, const PeerCredentials& peer) {
+        // Parented like accepted clients, so stop() disposes of it the same way
+        QObject* owner  = m_server ? static_cast<QObject*>(m_server) : m_listenNotifier;
+        auto*    socket = new QLocalSocket(owner ? owner : this);
+        if (fd < 0 || !socket->setSocketDescriptor(fd)) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            delete socket;
+            return nullptr;
+        }
+
+        addConnection(socket, peer);
+        return socket;
+    }
+
+    void IpcServer::addConnection(QLocalSocket* socket, const PeerCredentials& peer) {
+        Connection connection{FrameReader(static_cast<qsizetype>(MAX_MESSAGE_SIZE))};
+        connection.peer = peer;
+        m_connections.insert_or_assign(socket, std::move(connection));
+
+        connect(socket, &QLocalSocket::readyRead, this, &IpcServer::onReadyRead);
+        connect(socket, &QLocalSocket::disconnected, this, &IpcServer::onDisconnected);
+        connect(socket, &QLocalSocket::bytesWritten, this, &IpcServer::onBytesWritten);
+
+        emit clientConnected(socket);
+    }
+
     void IpcServer::onReadyRead() {
         auto* socket = qobject_cast<QLocalSocket*>(sender());
         if (!socket)
             return;
 
-        QByteArray& buffer = m_buffers[socket];
-        buffer.append(socket->readAll());
-
-        // Enforce max message size
-        if (buffer.size() > static_cast<qsizetype>(MAX_MESSAGE_SIZE)) {
-            socket->disconnectFromServer();
+        auto it = m_connections.find(socket);
+        if (it == m_connections.end())
             return;
-        }
 
-        // Process complete lines
-        qsizetype idx;
-        while ((idx = buffer.indexOf('\n')) != -1) {
-            QByteArray line = buffer.left(idx).trimmed();
-            buffer.remove(0, static_cast<qsizetype>(idx + 1));
+        // Bounded reads keep the size check ahead of buffering the whole burst
+        FrameReader& reader = it->second.reader;
+        while (socket->bytesAvailable() > 0) {
+            if (reader.readFrom(*socket) <= 0)
+                return;
+
+            while (const auto frame = reader.nextFrame()) {
+                handleFrame(socket, *frame);
 
-            if (!line.isEmpty()) {
-                handleLine(socket, line);
+                // The handler may have dropped this client
+                if (!m_connections.contains(socket))
+                    return;
+            }
+
+            // Enforce max message size
+            if (reader.overflowed()) {
+                socket->disconnectFromServer();
+                return;
             }
         }
     }
@@ -144,26 +427,54 @@ namespace bb {
         if (!socket)
             return;
 
-        m_buffers.remove(socket);
+        if (const auto it = m_connections.find(socket); it != m_connections.end()) {
+            discardOutbox(it->second);
+            m_connections.erase(it);
+        }
         emit clientDisconnected(socket);
 
         socket->deleteLater();
     }
 
-    void IpcServer::handleLine(QLocalSocket* socket, const QByteArray& line) {
-        if (!m_handler)
+    void IpcServer::onBytesWritten() {
+        auto* socket = qobject_cast<QLocalSocket*>(sender());
+        if (!socket)
             return;
 
-        QJsonParseError parseError;
-        const auto      doc = QJsonDocument::fromJson(line, &parseError);
+        const auto it = m_connections.find(socket);
+        if (it == m_connections.end() || !it->second.congested)
+            return;
 
-        if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
-            sendJson(socket, QJsonObject{{"type", "error"}, {"message", "Invalid JSON"}});
+        // Hysteresis: resume only once the reader caught up to the low watermark
+        if (socket->bytesToWrite() <= m_lowWatermark) {
+            it->second.congested = false;
+            if (!it->second.outbox.isEmpty()) {
+                scheduleFlush();
+            }
+        }
+    }
+
+    void IpcServer::handleFrame(QLocalSocket* socket, const Frame& frame) {
+        if (!m_handler)
+            return;
+
+        // Parse straight out of the read buffer; no per-frame copy
+        const auto decoded = decodeFrame(frame.payload, frame.encoding);
+        if (!decoded) {
+            sendJson(socket, QJsonObject{{"type", "error"}, {"message", frame.encoding == FrameEncoding::Cbor ? "Invalid CBOR" : "Invalid JSON"}});
             return;
         }
 
-        const QJsonObject obj  = doc.object();
-        const QString     type = obj.value("type").toString();
+        const QJsonObject& obj  = *decoded;
+        const QString      type = obj.value("type").toString();
+
+        // Replies sent while this frame is handled echo its requestId
+        m_dispatchSocket    = socket;
+        m_dispatchRequestId = obj.value(json::KEY_REQUEST_ID);
+        const auto resetDispatch = qScopeGuard([this]() {
+            m_dispatchSocket    = nullptr;
+            m_dispatchRequestId = QJsonValue(QJsonValue::Undefined);
+        });
 
         if (type.isEmpty()) {
             sendJson(socket, QJsonObject{{"type", "error"}, {"message", "Missing type field"}});
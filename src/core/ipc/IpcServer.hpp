@@ -1,11 +1,20 @@
 #pragma once
 
+#include "EncodedEvent.hpp"
+#include "PeerCredentials.hpp"
+#include "../../common/Constants.hpp"
+#include "../../common/FrameReader.hpp"
+
+#include <QList>
 #include <QLocalServer>
 #include <QLocalSocket>
 #include <QJsonObject>
+#include <QJsonValue>
 #include <QObject>
+#include <QSocketNotifier>
 
 #include <functional>
+#include <unordered_map>
 
 namespace bb {
 
@@ -13,30 +22,76 @@ namespace bb {
     // Parameters: socket, message type, full JSON object
     using MessageHandler = std::function<void(QLocalSocket*, const QString&, const QJsonObject&)>;
 
+    // Returns true for clients that must never be throttled, dropped or disconnected
+    using ExemptionCheck = std::function<bool(QLocalSocket*)>;
+
     class IpcServer : public QObject {
         Q_OBJECT
 
       public:
+        // What happens to a client whose queued output exceeds the high watermark
+        enum class OverflowPolicy {
+            DropOldest, // discard its oldest droppable events down to the low watermark; disconnect if that is not enough
+            Disconnect
+        };
+
+        struct WriteStats {
+            quint64 writeCalls          = 0;
+            quint64 droppedFrames       = 0;
+            quint64 overflowDisconnects = 0;
+        };
+
         explicit IpcServer(QObject* parent = nullptr);
         ~IpcServer() override;
 
-        // Start listening on the given socket path
+        // Start listening on the given socket path, or on the socket a service manager passed for it
         // Returns false if binding fails
         bool start(const QString& socketPath);
 
+        // Serve an already-listening socket; takes ownership of the descriptor
+        // Its socket file is left in place on stop, since the service manager still listens on it
+        bool adopt(int listenFd);
+        bool isSocketActivated() const;
+
+        // Serve one end of a connected socket pair, as if peer had connected; takes ownership of the descriptor
+        // Returns nullptr, with the descriptor closed, if it cannot be used
+        QLocalSocket* adoptConnection(int fd, const PeerCredentials& peer);
+
         // Stop the server and disconnect all clients
         void stop();
 
         // Set the handler for incoming messages
         void setMessageHandler(MessageHandler handler);
 
-        // Send a JSON response to a specific socket
-        // If secureWipe is true, zeros the buffer after sending
+        // Queue a JSON response to a specific socket; replies are never dropped
+        // If secureWipe is true, zeros the buffer once it was handed to the socket
+        // Sent to the client whose request is being dispatched, it echoes that request's requestId
         void sendJson(QLocalSocket* socket, const QJsonObject& json, bool secureWipe = false);
 
-        // Get peer process ID for a connected socket
-        // Returns -1 on failure
-        static pid_t getPeerPid(QLocalSocket* socket);
+        // Queue the deferred reply to an earlier request; the reply carries its own requestId
+        void sendReply(QLocalSocket* socket, const QJsonObject& json, bool secureWipe = false);
+
+        // Queue a pre-encoded event; the frame is shared, not re-serialized
+        // Only droppable events, such as provider status a later one supersedes, give way to the overflow policy;
+        // a client that falls behind on the others is disconnected rather than left with a stale view
+        void sendEvent(QLocalSocket* socket, const EncodedEvent& event, bool droppable = false);
+
+        // Output backpressure; frames queued within one event-loop iteration
+        // are merged into a single write per socket
+        void              setWatermarks(qint64 lowBytes, qint64 highBytes);
+        void              setOverflowPolicy(OverflowPolicy policy);
+        void              setExemptionCheck(ExemptionCheck check);
+        qint64            queuedBytes(QLocalSocket* socket) const;
+        const WriteStats& writeStats() const;
+
+        // Outbound wire encoding for a client; JSON until negotiated
+        // Inbound frames are auto-detected regardless of this setting
+        void          setEncoding(QLocalSocket* socket, FrameEncoding encoding);
+        FrameEncoding encoding(QLocalSocket* socket) const;
+
+        // Credentials captured when the client connected
+        // Returns an invalid record for unknown sockets
+        const PeerCredentials& peerCredentials(QLocalSocket* socket) const;
 
       Q_SIGNALS:
         void clientConnected(QLocalSocket* socket);
@@ -44,15 +99,52 @@ namespace bb {
 
       private Q_SLOTS:
         void onNewConnection();
+        void onInheritedConnection();
         void onReadyRead();
         void onDisconnected();
+        void onBytesWritten();
 
       private:
-        void                             handleLine(QLocalSocket* socket, const QByteArray& line);
-
-        QLocalServer*                    m_server = nullptr;
-        MessageHandler                   m_handler;
-        QHash<QLocalSocket*, QByteArray> m_buffers;
+        struct OutboundFrame {
+            QByteArray data;
+            bool       droppable  = false;
+            bool       secureWipe = false;
+        };
+
+        // Per-client state; node-based map so references survive other clients disconnecting
+        struct Connection {
+            FrameReader          reader;
+            FrameEncoding        encoding = FrameEncoding::Json;
+            PeerCredentials      peer;
+            QList<OutboundFrame> outbox;
+            qint64               outboxBytes = 0;
+            bool                 congested   = false; // socket buffer above high watermark, hold the outbox
+            bool                 closing     = false; // overflowed under Disconnect, aborted on next flush
+        };
+
+        void                                          addConnection(QLocalSocket* socket, const PeerCredentials& peer);
+        void                                          handleFrame(QLocalSocket* socket, const Frame& frame);
+        void                                          enqueueFrame(QLocalSocket* socket, OutboundFrame frame);
+        void                                          enforceWatermark(QLocalSocket* socket, Connection& connection);
+        void                                          flushConnection(QLocalSocket* socket, Connection& connection);
+        void                                          flushPending();
+        void                                          scheduleFlush();
+        bool                                          isExempt(QLocalSocket* socket) const;
+        static void                                   discardOutbox(Connection& connection);
+
+        QLocalServer*                                 m_server         = nullptr;
+        QSocketNotifier*                              m_listenNotifier = nullptr; // adopted listener; parents its clients
+        int                                           m_listenFd       = -1;
+        MessageHandler                                m_handler;
+        ExemptionCheck                                m_exemptionCheck;
+        std::unordered_map<QLocalSocket*, Connection> m_connections;
+        OverflowPolicy                                m_overflowPolicy = OverflowPolicy::DropOldest;
+        qint64                                        m_lowWatermark   = static_cast<qint64>(IPC_WRITE_LOW_WATERMARK);
+        qint64                                        m_highWatermark  = static_cast<qint64>(IPC_WRITE_HIGH_WATERMARK);
+        WriteStats                                    m_writeStats;
+        QLocalSocket*                                 m_dispatchSocket = nullptr; // client whose frame is being handled
+        QJsonValue                                    m_dispatchRequestId;
+        bool                                          m_flushScheduled = false;
     };
 
 } // namespace bb
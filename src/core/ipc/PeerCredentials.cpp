@@ -0,0 +1,90 @@
+#include "PeerCredentials.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace bb {
+
+    namespace {
+
+        std::shared_ptr<const int> adoptPidfd(int fd) {
+            if (fd < 0) {
+                return {};
+            }
+
+            return std::shared_ptr<const int>(new int(fd), [](const int* owned) {
+                ::close(*owned);
+                delete owned;
+            });
+        }
+
+        int openPidfd(int socketFd, pid_t pid) {
+#ifdef SO_PEERPIDFD
+            // Kernel-resolved at connect time, immune to the accept-time pid race
+            int       fd  = -1;
+            socklen_t len = sizeof(fd);
+            if (getsockopt(socketFd, SOL_SOCKET, SO_PEERPIDFD, &fd, &len) == 0 && fd >= 0) {
+                return fd;
+            }
+#else
+            Q_UNUSED(socketFd)
+#endif
+
+#ifdef SYS_pidfd_open
+            return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+#else
+            Q_UNUSED(pid)
+            return -1;
+#endif
+        }
+
+    } // namespace
+
+    bool PeerCredentials::isValid() const {
+        return pid > 0;
+    }
+
+    int PeerCredentials::pidfdHandle() const {
+        return pidfd ? *pidfd : -1;
+    }
+
+    bool PeerCredentials::isAlive() const {
+        if (!isValid()) {
+            return false;
+        }
+
+        if (pidfd) {
+            // A pidfd polls readable once its process has exited
+            pollfd pfd{*pidfd, POLLIN, 0};
+            return ::poll(&pfd, 1, 0) == 0;
+        }
+
+        return ::kill(pid, 0) == 0 || errno == EPERM;
+    }
+
+    bool PeerCredentials::sameProcess(const PeerCredentials& other) const {
+        return isValid() && other.pid == pid && isAlive();
+    }
+
+    PeerCredentials PeerCredentials::fromSocketDescriptor(qintptr descriptor) {
+        PeerCredentials creds;
+
+        const int       fd = static_cast<int>(descriptor);
+        struct ucred    cred;
+        socklen_t       len = sizeof(cred);
+        if (fd < 0 || getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == -1) {
+            return creds;
+        }
+
+        creds.pid   = cred.pid;
+        creds.uid   = cred.uid;
+        creds.gid   = cred.gid;
+        creds.pidfd = adoptPidfd(openPidfd(fd, cred.pid));
+        return creds;
+    }
+
+} // namespace bb
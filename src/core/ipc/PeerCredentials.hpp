@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <memory>
+#include <sys/types.h>
+
+namespace bb {
+
+    // Identity of the process behind a client socket, captured once at accept time
+    struct PeerCredentials {
+        pid_t                      pid = -1;
+        uid_t                      uid = static_cast<uid_t>(-1);
+        gid_t                      gid = static_cast<gid_t>(-1);
+        std::shared_ptr<const int> pidfd; // closed with the last copy; null without kernel support
+
+        bool                       isValid() const;
+
+        // Raw pidfd for RequestContextHelper::readProc, -1 when unavailable
+        int                        pidfdHandle() const;
+
+        // False once the captured process exited; pidfd-backed, so a recycled pid never counts
+        bool                       isAlive() const;
+
+        // Same still-running process as other, even across separate connections
+        bool                       sameProcess(const PeerCredentials& other) const;
+
+        // SO_PEERCRED (plus SO_PEERPIDFD or pidfd_open) on a connected local socket
+        static PeerCredentials     fromSocketDescriptor(qintptr descriptor);
+    };
+
+} // namespace bb
@@ -0,0 +1,68 @@
+#include "SocketActivation.hpp"
+
+#include <QDir>
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace bb {
+
+    namespace {
+
+        bool isListenerFor(int fd, const QString& socketPath) {
+            int       value = 0;
+            socklen_t len   = sizeof(value);
+            if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &value, &len) != 0 || value != SOCK_STREAM) {
+                return false;
+            }
+
+            len = sizeof(value);
+            if (getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &value, &len) != 0 || value == 0) {
+                return false;
+            }
+
+            sockaddr_un address{};
+            len = sizeof(address);
+            if (getsockname(fd, reinterpret_cast<sockaddr*>(&address), &len) != 0 || address.sun_family != AF_UNIX) {
+                return false;
+            }
+
+            // Abstract addresses start with a NUL and never match a path
+            const QString bound = QString::fromLocal8Bit(address.sun_path, static_cast<qsizetype>(strnlen(address.sun_path, sizeof(address.sun_path))));
+            return !bound.isEmpty() && QDir::cleanPath(bound) == QDir::cleanPath(socketPath);
+        }
+
+    } // namespace
+
+    int takeActivationSocket(const QString& socketPath, int firstFd) {
+        const QByteArray listenPid = qgetenv("LISTEN_PID");
+        const QByteArray listenFds = qgetenv("LISTEN_FDS");
+        qunsetenv("LISTEN_PID");
+        qunsetenv("LISTEN_FDS");
+        qunsetenv("LISTEN_FDNAMES");
+
+        // Meant for this process only; a forked parent's variables are not ours
+        bool         pidOk   = false;
+        bool         countOk = false;
+        const qint64 pid     = listenPid.toLongLong(&pidOk);
+        const int    count   = listenFds.toInt(&countOk);
+        if (!pidOk || pid != ::getpid() || !countOk || count <= 0) {
+            return -1;
+        }
+
+        int taken = -1;
+        for (int fd = firstFd; fd < firstFd + count; ++fd) {
+            if (taken < 0 && isListenerFor(fd, socketPath)) {
+                ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+                taken = fd;
+                continue;
+            }
+            ::close(fd);
+        }
+        return taken;
+    }
+
+} // namespace bb
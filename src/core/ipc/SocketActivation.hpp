@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QString>
+
+namespace bb {
+
+    // First descriptor a service manager passes (sd_listen_fds(3))
+    inline constexpr int LISTEN_FDS_START = 3;
+
+    // Takes the listening AF_UNIX stream socket bound to socketPath from $LISTEN_PID/$LISTEN_FDS; -1 if there is none
+    // The variables are cleared either way, so launched providers never see them; other passed descriptors are closed
+    int takeActivationSocket(const QString& socketPath, int firstFd = LISTEN_FDS_START);
+
+} // namespace bb
@@ -1,23 +1,23 @@
 #include "KeyringManager.hpp"
 #include "../Agent.hpp"
 
-#include <QJsonDocument>
 #include <QUuid>
 
 namespace bb {
 
     KeyringManager::KeyringManager(QObject* parent) : QObject(parent) {}
 
-    void KeyringManager::handleRequest(const QJsonObject& msg, QLocalSocket* socket, pid_t peerPid) {
+    void KeyringManager::handleRequest(const QJsonObject& msg, QLocalSocket* socket, const PeerCredentials& peer) {
         QString cookie = msg.value("cookie").toString();
         if (cookie.isEmpty()) {
             cookie = QUuid::createUuid().toString(QUuid::WithoutBraces);
         }
 
         KeyringRequest request;
-        request.cookie  = cookie;
-        request.socket  = socket;
-        request.peerPid = peerPid;
+        request.cookie    = cookie;
+        request.socket    = socket;
+        request.peer      = peer;
+        request.requestId = msg.value(json::KEY_REQUEST_ID);
 
         if (msg.contains("title")) {
             request.title = msg.value("title").toString();
@@ -31,35 +31,20 @@ namespace bb {
 
         m_pendingRequests[cookie] = request;
 
-        // Resolve requestor
-        std::optional<ProcInfo> proc = RequestContextHelper::readProc(peerPid);
-        ActorInfo               actor;
-        if (proc) {
-            actor = RequestContextHelper::resolveRequestorFromSubject(*proc, getuid());
-        }
-
         bb::Session::Context ctx;
         ctx.message = request.title;
         ctx.keyringName = request.message; // Detailed message
-        ctx.requestor.name = actor.displayName;
-        ctx.requestor.icon = actor.iconName;
-        ctx.requestor.fallbackLetter = actor.fallbackLetter;
-        ctx.requestor.fallbackKey = actor.fallbackKey;
-        ctx.requestor.pid = peerPid;
+        ctx.requestor.pid = peer.pid; // Named once resolveSessionRequestor() finishes
 
         // Use centralized session management
         if (!g_pAgent->createSession(cookie, bb::Session::Source::Keyring, ctx)) {
             m_pendingRequests.remove(cookie);
 
-            QJsonObject error{{"type", "error"}, {"message", "Session ID collision"}};
-            QJsonDocument doc(error);
-            if (socket && socket->isOpen()) {
-                socket->write(doc.toJson(QJsonDocument::Compact) + "\n");
-                socket->flush();
-            }
+            g_pAgent->sendJson(socket, QJsonObject{{"type", "error"}, {"message", "Session ID collision"}});
             return;
         }
         g_pAgent->updateSessionPrompt(cookie, request.message, false);
+        g_pAgent->resolveSessionRequestor(cookie, peer.pid, peer.pidfd);
     }
 
     QJsonObject KeyringManager::handleResponse(const QString& cookie, const QString& response) {
@@ -68,12 +53,13 @@ namespace bb {
             return QJsonObject{{"type", "error"}, {"message", "Unknown cookie"}};
         }
 
+        const KeyringRequest request = it.value();
         m_pendingRequests.erase(it);
 
         // Close session via Agent
         g_pAgent->closeSession(cookie, bb::Session::Result::Success);
 
-        return QJsonObject{{"type", "keyring_response"}, {"id", cookie}, {"result", "ok"}, {"password", response}};
+        return request.tagReply(QJsonObject{{"type", "keyring_response"}, {"id", cookie}, {"result", "ok"}, {"password", response}});
     }
 
     QJsonObject KeyringManager::handleCancel(const QString& cookie) {
@@ -82,12 +68,13 @@ namespace bb {
             return QJsonObject{{"type", "error"}, {"message", "Unknown cookie"}};
         }
 
+        const KeyringRequest request = it.value();
         m_pendingRequests.erase(it);
 
         // Close session via Agent
         g_pAgent->closeSession(cookie, bb::Session::Result::Cancelled);
 
-        return QJsonObject{{"type", "keyring_response"}, {"result", "cancelled"}, {"id", cookie}};
+        return request.tagReply(QJsonObject{{"type", "keyring_response"}, {"result", "cancelled"}, {"id", cookie}});
     }
 
     bool KeyringManager::hasPendingRequest(const QString& cookie) const {
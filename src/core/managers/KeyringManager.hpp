@@ -17,7 +17,7 @@ namespace bb {
         explicit KeyringManager(QObject* parent = nullptr);
 
         // Process an incoming keyring request
-        void handleRequest(const QJsonObject& msg, QLocalSocket* socket, pid_t peerPid);
+        void handleRequest(const QJsonObject& msg, QLocalSocket* socket, const PeerCredentials& peer);
 
         // Process a response to a pending request
         // Returns responseJson to be sent to the socket
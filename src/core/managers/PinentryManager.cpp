@@ -4,22 +4,19 @@
 
 #include <QDebug>
 #include <QList>
-#include <QJsonDocument>
 #include <QRegularExpression>
 #include <QUuid>
 
-#include <optional>
-#include <unistd.h>
-
 namespace bb {
 
 namespace {
 
-PinentryRequest parsePinentryRequest(const QJsonObject& msg, QLocalSocket* socket, pid_t peerPid) {
+PinentryRequest parsePinentryRequest(const QJsonObject& msg, QLocalSocket* socket, const PeerCredentials& peer) {
     PinentryRequest request;
     request.cookie = msg.value("cookie").toString();
     request.socket = socket;
-    request.peerPid = peerPid;
+    request.peer = peer;
+    request.requestId = msg.value(json::KEY_REQUEST_ID);
 
     request.prompt = msg.value("prompt").toString();
     if (request.prompt.isEmpty()) {
@@ -39,36 +36,27 @@ PinentryRequest parsePinentryRequest(const QJsonObject& msg, QLocalSocket* socke
     return request;
 }
 
-ActorInfo resolveActorForPid(pid_t peerPid) {
-    std::optional<ProcInfo> proc = RequestContextHelper::readProc(peerPid);
-    if (!proc) {
-        return {};
-    }
-
-    return RequestContextHelper::resolveRequestorFromSubject(*proc, getuid());
-}
-
 } // namespace
 
 PinentryManager::PinentryManager(QObject* parent) : QObject(parent) {}
 
 PinentryManager::~PinentryManager() = default;
 
-void PinentryManager::handleRequest(const QJsonObject& msg, QLocalSocket* socket, pid_t peerPid) {
-    PinentryRequest request = parsePinentryRequest(msg, socket, peerPid);
+void PinentryManager::handleRequest(const QJsonObject& msg, QLocalSocket* socket, const PeerCredentials& peer) {
+    PinentryRequest request = parsePinentryRequest(msg, socket, peer);
     if (request.cookie.isEmpty()) {
         request.cookie = QUuid::createUuid().toString(QUuid::WithoutBraces);
     }
 
     const QString cookie = request.cookie;
 
-    if (m_flowOwners.contains(cookie) && m_flowOwners.value(cookie) != peerPid) {
+    if (m_flowOwners.contains(cookie) && !m_flowOwners.value(cookie).sameProcess(peer)) {
         qWarning() << "Pinentry owner mismatch for cookie" << cookie << "expected pid"
-                   << m_flowOwners.value(cookie) << "got" << peerPid;
+                   << m_flowOwners.value(cookie).pid << "got" << peer.pid;
         return;
     }
 
-    m_flowOwners[cookie] = peerPid;
+    m_flowOwners[cookie] = peer;
     if (!request.keyinfo.isEmpty()) {
         m_flowKeyinfos[cookie] = request.keyinfo;
     }
@@ -85,8 +73,6 @@ void PinentryManager::handleRequest(const QJsonObject& msg, QLocalSocket* socket
     m_pendingRequests[cookie] = request;
 
     if (!sessionExists) {
-        const ActorInfo actor = resolveActorForPid(peerPid);
-
         Session::Context ctx;
         ctx.message = request.prompt;
         ctx.description = request.description;
@@ -95,11 +81,7 @@ void PinentryManager::handleRequest(const QJsonObject& msg, QLocalSocket* socket
         ctx.maxRetries = maxRetries;
         ctx.confirmOnly = request.confirmOnly;
         ctx.repeat = request.repeat;
-        ctx.requestor.name = actor.displayName;
-        ctx.requestor.icon = actor.iconName;
-        ctx.requestor.fallbackLetter = actor.fallbackLetter;
-        ctx.requestor.fallbackKey = actor.fallbackKey;
-        ctx.requestor.pid = peerPid;
+        ctx.requestor.pid = peer.pid; // Named once resolveSessionRequestor() finishes
 
         if (!g_pAgent->createSession(cookie, Session::Source::Pinentry, ctx)) {
             // Should not happen as we checked !sessionExists earlier, but for safety:
@@ -109,14 +91,10 @@ void PinentryManager::handleRequest(const QJsonObject& msg, QLocalSocket* socket
             if (!request.keyinfo.isEmpty()) {
                 m_flowKeyinfos.remove(cookie);
             }
-            QJsonObject error{{"type", "error"}, {"message", "Session ID collision"}};
-            QJsonDocument doc(error);
-            if (socket && socket->isOpen()) {
-                socket->write(doc.toJson(QJsonDocument::Compact) + "\n");
-                socket->flush();
-            }
+            g_pAgent->sendJson(socket, QJsonObject{{"type", "error"}, {"message", "Session ID collision"}});
             return;
         }
+        g_pAgent->resolveSessionRequestor(cookie, peer.pid, peer.pidfd);
     } else {
         g_pAgent->updateSessionPinentryRetry(cookie, curRetry, maxRetries);
     }
@@ -172,16 +150,16 @@ PinentryManager::ResponseResult PinentryManager::handleResponse(const QString& c
     m_awaitingOutcome[cookie] = awaiting;
     timer->start(PINENTRY_RESULT_TIMEOUT_MS);
 
-    return {socketResponse};
+    return {request.tagReply(socketResponse)};
 }
 
-QJsonObject PinentryManager::handleResult(const QJsonObject& msg, pid_t peerPid) {
+QJsonObject PinentryManager::handleResult(const QJsonObject& msg, const PeerCredentials& peer) {
     const QString cookie = msg.value("id").toString();
     if (cookie.isEmpty()) {
         return QJsonObject{{"type", "error"}, {"message", "Missing id"}};
     }
 
-    if (!validateResultOwner(cookie, peerPid)) {
+    if (!validateResultOwner(cookie, peer)) {
         return QJsonObject{{"type", "error"}, {"message", "Result sender does not own session"}};
     }
 
@@ -223,14 +201,16 @@ QJsonObject PinentryManager::handleResult(const QJsonObject& msg, pid_t peerPid)
 QJsonObject PinentryManager::handleCancel(const QString& cookie) {
     Session* session = g_pAgent->getSession(cookie);
 
-    if (m_pendingRequests.contains(cookie)) {
+    if (auto it = m_pendingRequests.find(cookie); it != m_pendingRequests.end()) {
+        const PinentryRequest request = it.value();
         closeFlow(cookie, Session::Result::Cancelled);
-        return QJsonObject{{"type", "pinentry_response"}, {"id", cookie}, {"result", "cancelled"}};
+        return request.tagReply(QJsonObject{{"type", "pinentry_response"}, {"id", cookie}, {"result", "cancelled"}});
     }
 
-    if (m_awaitingOutcome.contains(cookie)) {
+    if (auto it = m_awaitingOutcome.find(cookie); it != m_awaitingOutcome.end()) {
+        const PinentryRequest request = it->request;
         closeFlow(cookie, Session::Result::Cancelled);
-        return QJsonObject{{"type", "pinentry_response"}, {"id", cookie}, {"result", "cancelled"}};
+        return request.tagReply(QJsonObject{{"type", "pinentry_response"}, {"id", cookie}, {"result", "cancelled"}});
     }
 
     if (session && session->source() == Session::Source::Pinentry) {
@@ -316,13 +296,14 @@ std::pair<int, int> PinentryManager::resolveRetryInfo(const PinentryRequest& req
     return {curRetry, maxRetries};
 }
 
-bool PinentryManager::validateResultOwner(const QString& cookie, pid_t peerPid) const {
+bool PinentryManager::validateResultOwner(const QString& cookie, const PeerCredentials& peer) const {
     auto ownerIt = m_flowOwners.find(cookie);
     if (ownerIt == m_flowOwners.end()) {
         return true;
     }
 
-    return ownerIt.value() == peerPid;
+    // The owner's pidfd keeps a recycled pid from passing as the original pinentry
+    return ownerIt.value().sameProcess(peer);
 }
 
 void PinentryManager::cleanupAwaiting(const QString& cookie) {
@@ -21,7 +21,7 @@ namespace bb {
         ~PinentryManager() override;
 
         // Process incoming pinentry request
-        void handleRequest(const QJsonObject& msg, QLocalSocket* socket, pid_t peerPid);
+        void handleRequest(const QJsonObject& msg, QLocalSocket* socket, const PeerCredentials& peer);
 
         // Process response for pending user input
         struct ResponseResult {
@@ -30,7 +30,7 @@ namespace bb {
         ResponseResult handleResponse(const QString& cookie, const QString& response);
 
         // Process terminal result from pinentry mode
-        QJsonObject handleResult(const QJsonObject& msg, pid_t peerPid);
+        QJsonObject handleResult(const QJsonObject& msg, const PeerCredentials& peer);
 
         // Process cancellation
         QJsonObject handleCancel(const QString& cookie);
@@ -51,7 +51,7 @@ namespace bb {
         };
 
         std::pair<int, int> resolveRetryInfo(const PinentryRequest& request);
-        bool                validateResultOwner(const QString& cookie, pid_t peerPid) const;
+        bool                validateResultOwner(const QString& cookie, const PeerCredentials& peer) const;
 
         void cleanupAwaiting(const QString& cookie);
         void closeFlow(const QString& cookie, Session::Result result, const QString& error = {});
@@ -59,7 +59,7 @@ namespace bb {
         QHash<QString, PinentryRequest>    m_pendingRequests;
         QHash<QString, AwaitingOutcome>    m_awaitingOutcome;
         QHash<QString, PinentryRetryInfo>  m_retryInfo;
-        QHash<QString, pid_t>              m_flowOwners;
+        QHash<QString, PeerCredentials>    m_flowOwners;
         QHash<QString, QString>            m_flowKeyinfos;
         QSet<QString>                      m_retryReported;
     };
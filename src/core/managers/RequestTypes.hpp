@@ -1,6 +1,10 @@
 #pragma once
 
+#include "../ipc/PeerCredentials.hpp"
+#include "../../common/Constants.hpp"
+
 #include <QJsonObject>
+#include <QJsonValue>
 #include <QLocalSocket>
 #include <QString>
 
@@ -8,9 +12,17 @@ namespace bb {
 
     // Base information common to all request types
     struct BaseRequest {
-        QString       cookie;
-        QLocalSocket* socket  = nullptr;
-        pid_t         peerPid = -1;
+        QString         cookie;
+        QLocalSocket*   socket = nullptr;
+        PeerCredentials peer;
+        QJsonValue      requestId = QJsonValue::Undefined; // client correlation id, echoed on the deferred reply
+
+        QJsonObject     tagReply(QJsonObject reply) const {
+            if (!requestId.isUndefined()) {
+                reply.insert(json::KEY_REQUEST_ID, requestId);
+            }
+            return reply;
+        }
     };
 
     struct KeyringRequest : BaseRequest {
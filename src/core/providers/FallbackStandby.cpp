@@ -0,0 +1,273 @@
+#include "FallbackStandby.hpp"
+
+#include <QDateTime>
+#include <QFile>
+#include <QProcess>
+#include <QSocketNotifier>
+
+#include <algorithm>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace bb::providers {
+
+    namespace {
+
+        // After a standby failed to start or died before registering
+        inline constexpr qint64 STANDBY_RETRY_MS        = 30000;
+        // A waiting standby does next to nothing, so it is measured when admitted and then rarely
+        inline constexpr qint64 STANDBY_BUDGET_CHECK_MS = 10 * 60 * 1000;
+
+        std::optional<qint64> readKbField(const QString& path, const QByteArray& field) {
+            QFile file(path);
+            if (!file.open(QIODevice::ReadOnly)) {
+                return std::nullopt;
+            }
+
+            for (const QByteArray& line : file.readAll().split('\n')) {
+                if (line.startsWith(field)) {
+                    bool         ok = false;
+                    const qint64 kb = line.mid(field.size()).trimmed().split(' ').first().toLongLong(&ok);
+                    return ok ? std::optional<qint64>(kb) : std::nullopt;
+                }
+            }
+            return std::nullopt;
+        }
+
+        int openPidfd(qint64 pid) {
+#ifdef SYS_pidfd_open
+            return pid > 0 ? static_cast<int>(::syscall(SYS_pidfd_open, static_cast<pid_t>(pid), 0)) : -1;
+#else
+            Q_UNUSED(pid)
+            return -1;
+#endif
+        }
+
+    } // namespace
+
+    FallbackStandby::FallbackStandby(NowFn nowFn, StartFn startFn, MemoryFn memoryFn, WatchFn watchFn) :
+        m_nowFn(nowFn ? std::move(nowFn) : defaultNowMs), m_startFn(startFn ? std::move(startFn) : startDetached), m_memoryFn(memoryFn ? std::move(memoryFn) : defaultMemoryKb) {
+        if (watchFn) {
+            m_watchFn = std::move(watchFn);
+        } else {
+            m_watchFn = [this](qint64 pid, std::function<void()> onExit) { return watchPidfd(pid, std::move(onExit)); };
+        }
+    }
+
+    FallbackStandby::~FallbackStandby() {
+        // The standby outlives the daemon; only the watch goes away
+        delete m_exitNotifier;
+        if (m_pidfd >= 0) {
+            ::close(m_pidfd);
+        }
+    }
+
+    void FallbackStandby::configure(bool enabled, qint64 memoryBudgetKb) {
+        m_enabled    = enabled;
+        m_budgetKb   = std::max<qint64>(0, memoryBudgetKb);
+        m_overBudget = false;
+    }
+
+    bool FallbackStandby::isEnabled() const {
+        return m_enabled && !m_overBudget;
+    }
+
+    bool FallbackStandby::ensureRunning(const QString& program, const QString& socketPath) {
+        if (!isEnabled()) {
+            return false;
+        }
+
+        const qint64 nowMs = m_nowFn();
+        if (m_pid != 0) {
+            // A watched standby is forgotten as it exits; /proc is only asked about one that could not be watched
+            if (m_watched || m_memoryFn(m_pid)) {
+                return false;
+            }
+            forgetProcess();
+        }
+
+        if (nowMs < m_nextAttemptMs) {
+            return false;
+        }
+
+        QStringList args{"--standby"};
+        if (!socketPath.isEmpty()) {
+            args << "--socket" << socketPath;
+        }
+
+        const qint64 pid = m_startFn(program, args);
+        if (pid <= 0) {
+            m_nextAttemptMs = nowMs + STANDBY_RETRY_MS;
+            return false;
+        }
+
+        m_pid        = pid;
+        m_launchedMs = nowMs;
+        watch(pid);
+        return true;
+    }
+
+    void FallbackStandby::setExitHandler(std::function<void()> exitFn) {
+        m_exitFn = std::move(exitFn);
+    }
+
+    bool FallbackStandby::needsPolling() const {
+        return m_pid != 0 && !m_watched;
+    }
+
+    std::optional<qint64> FallbackStandby::nextCheckMs() const {
+        if (!isEnabled()) {
+            return std::nullopt;
+        }
+        if (m_registered && m_budgetKb > 0) {
+            return m_nextBudgetMs;
+        }
+        if (m_pid != 0) {
+            return std::nullopt;
+        }
+        return m_nextAttemptMs;
+    }
+
+    FallbackStandby::Admission FallbackStandby::admit(qint64 pid) {
+        Admission admission;
+        admission.memoryKb = m_memoryFn(pid).value_or(-1);
+        if (pid == m_pid) {
+            admission.startupMs = m_nowFn() - m_launchedMs;
+        }
+
+        if (!isEnabled()) {
+            return admission;
+        }
+
+        // Unmeasurable is given the benefit of the doubt; withinBudget() keeps trying
+        if (m_budgetKb > 0 && admission.memoryKb > m_budgetKb) {
+            m_overBudget = true;
+            return admission;
+        }
+
+        admission.accepted = true;
+        m_nextBudgetMs     = m_nowFn() + STANDBY_BUDGET_CHECK_MS;
+        if (pid != m_pid) {
+            m_pid = pid;
+            watch(pid);
+        }
+        m_registered = true;
+        m_promoted   = false;
+        return admission;
+    }
+
+    bool FallbackStandby::withinBudget() {
+        const qint64 nowMs = m_nowFn();
+        if (!m_registered || m_budgetKb == 0 || nowMs < m_nextBudgetMs) {
+            return true;
+        }
+
+        m_nextBudgetMs      = nowMs + STANDBY_BUDGET_CHECK_MS;
+        const auto memoryKb = m_memoryFn(m_pid);
+        if (!memoryKb || *memoryKb <= m_budgetKb) {
+            return true;
+        }
+
+        m_overBudget = true;
+        m_registered = false;
+        return false;
+    }
+
+    void FallbackStandby::promoted() {
+        m_registered = false;
+        m_promoted   = true;
+        m_promotedMs = m_nowFn();
+    }
+
+    std::optional<qint64> FallbackStandby::promotionAcknowledged() {
+        if (!m_promotedMs) {
+            return std::nullopt;
+        }
+
+        const qint64 latencyMs = m_nowFn() - *m_promotedMs;
+        m_promotedMs.reset();
+        return latencyMs;
+    }
+
+    qint64 FallbackStandby::pid() const {
+        return m_pid;
+    }
+
+    bool FallbackStandby::isStandingBy() const {
+        return m_registered;
+    }
+
+    void FallbackStandby::watch(qint64 pid) {
+        // Checked against m_pid, so the exit of a process already replaced is ignored
+        m_watched = m_watchFn(pid, [this, pid] {
+            if (pid != m_pid) {
+                return;
+            }
+            forgetProcess();
+            if (m_exitFn) {
+                m_exitFn();
+            }
+        });
+    }
+
+    void FallbackStandby::forgetProcess() {
+        // Gone: done serving a prompt, or crashed; one that never registered is not restarted right away
+        if (!m_registered && !m_promoted) {
+            m_nextAttemptMs = m_nowFn() + STANDBY_RETRY_MS;
+        }
+        m_pid        = 0;
+        m_registered = false;
+        m_promoted   = false;
+        m_watched    = false;
+        m_promotedMs.reset();
+    }
+
+    bool FallbackStandby::watchPidfd(qint64 pid, std::function<void()> onExit) {
+        stopWatching();
+
+        const int pidfd = openPidfd(pid);
+        if (pidfd < 0) {
+            return false;
+        }
+
+        // A pidfd turns readable when its process exits, and never names a later process with the same pid
+        m_pidfd        = pidfd;
+        m_exitNotifier = new QSocketNotifier(pidfd, QSocketNotifier::Read);
+        QObject::connect(m_exitNotifier, &QSocketNotifier::activated, m_exitNotifier, [this, onExit = std::move(onExit)] {
+            stopWatching();
+            onExit();
+        });
+        return true;
+    }
+
+    void FallbackStandby::stopWatching() {
+        if (m_exitNotifier) {
+            m_exitNotifier->setEnabled(false);
+            m_exitNotifier->deleteLater();
+            m_exitNotifier = nullptr;
+        }
+        if (m_pidfd >= 0) {
+            ::close(m_pidfd);
+            m_pidfd = -1;
+        }
+    }
+
+    qint64 FallbackStandby::defaultNowMs() {
+        return QDateTime::currentMSecsSinceEpoch();
+    }
+
+    qint64 FallbackStandby::startDetached(const QString& program, const QStringList& args) {
+        qint64 pid = 0;
+        return QProcess::startDetached(program, args, QString(), &pid) ? pid : 0;
+    }
+
+    std::optional<qint64> FallbackStandby::defaultMemoryKb(qint64 pid) {
+        // Proportional set size: the Qt libraries it shares with other processes are only partly its cost
+        const QString dir = QStringLiteral("/proc/%1/").arg(pid);
+        if (const auto pss = readKbField(dir + "smaps_rollup", "Pss:")) {
+            return pss;
+        }
+        return readKbField(dir + "status", "VmRSS:");
+    }
+
+} // namespace bb::providers
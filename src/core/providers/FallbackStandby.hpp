@@ -0,0 +1,99 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+#include <optional>
+
+class QSocketNotifier;
+
+namespace bb::providers {
+
+    // Keeps one hidden bb-auth-fallback registered as a standby provider, so a prompt does not
+    // wait for Qt, the platform plugin and fonts to initialize. Opt-in; see configure()
+    class FallbackStandby {
+      public:
+        using NowFn    = std::function<qint64()>;
+        // Pid of the started process, 0 on failure
+        using StartFn  = std::function<qint64(const QString& program, const QStringList& args)>;
+        // Memory a process costs in KiB, nullopt once it is gone
+        using MemoryFn = std::function<std::optional<qint64>(qint64 pid)>;
+        // Calls onExit from the event loop once the process is gone; false if it cannot be watched
+        using WatchFn  = std::function<bool(qint64 pid, std::function<void()> onExit)>;
+
+        struct Admission {
+            bool   accepted  = false;
+            qint64 memoryKb  = -1;
+            qint64 startupMs = -1; // launch to registration; -1 if not started by us
+        };
+
+        // Without watchFn, the standby is watched through a pidfd
+        explicit FallbackStandby(NowFn nowFn = {}, StartFn startFn = {}, MemoryFn memoryFn = {}, WatchFn watchFn = {});
+        ~FallbackStandby();
+
+        FallbackStandby(const FallbackStandby&)            = delete;
+        FallbackStandby& operator=(const FallbackStandby&) = delete;
+
+        // memoryBudgetKb 0 means no limit
+        void                  configure(bool enabled, qint64 memoryBudgetKb);
+        bool                  isEnabled() const;
+
+        // Starts a standby unless one is alive (starting, waiting or promoted); true if it started one
+        bool                  ensureRunning(const QString& program, const QString& socketPath);
+        // Called once the watched standby exits, after it has been forgotten; ensureRunning() replaces it
+        void                  setExitHandler(std::function<void()> exitFn);
+        // Only a process that could not be watched needs a periodic check
+        bool                  needsPolling() const;
+        // When ensureRunning() may start one again, while none is running, or when withinBudget() next
+        // measures the registered standby
+        std::optional<qint64> nextCheckMs() const;
+
+        // A provider registered with "standby": whether it fits the memory budget. A standby that does
+        // not fit disables the mode until the next configure(), as every replacement would cost the same
+        Admission             admit(qint64 pid);
+
+        // Re-measures the registered standby once its check is due; false once it has grown past the budget
+        bool                  withinBudget();
+
+        // The standby took a session; the process is kept until it exits on its own
+        void                  promoted();
+        // First message from the promoted provider: milliseconds since promoted(), once
+        std::optional<qint64> promotionAcknowledged();
+
+        qint64                pid() const;
+        bool                  isStandingBy() const;
+
+      private:
+        static qint64                defaultNowMs();
+        static qint64                startDetached(const QString& program, const QStringList& args);
+        static std::optional<qint64> defaultMemoryKb(qint64 pid);
+        bool                         watchPidfd(qint64 pid, std::function<void()> onExit);
+        void                         stopWatching();
+        void                         watch(qint64 pid);
+        void                         forgetProcess();
+
+        NowFn                        m_nowFn;
+        StartFn                      m_startFn;
+        MemoryFn                     m_memoryFn;
+        WatchFn                      m_watchFn;
+        std::function<void()>        m_exitFn;
+
+        bool                         m_enabled    = false;
+        qint64                       m_budgetKb   = 0;
+        bool                         m_overBudget = false;
+
+        qint64                       m_pid           = 0;
+        qint64                       m_launchedMs    = 0;
+        qint64                       m_nextAttemptMs = 0;
+        qint64                       m_nextBudgetMs  = 0; // next measurement while registered
+        bool                         m_registered    = false;
+        bool                         m_promoted      = false;
+        bool                         m_watched       = false;
+        std::optional<qint64>        m_promotedMs; // until acknowledged
+
+        int                          m_pidfd        = -1;
+        QSocketNotifier*             m_exitNotifier = nullptr;
+    };
+
+} // namespace bb::providers
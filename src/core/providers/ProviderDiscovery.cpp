@@ -46,6 +46,10 @@ namespace bb::providers {
     }
 
     DiscoveryResult ProviderDiscovery::discover(const QStringList& searchDirs) {
+        return discover(searchDirs, readManifest);
+    }
+
+    DiscoveryResult ProviderDiscovery::discover(const QStringList& searchDirs, const ManifestReader& readManifest) {
         DiscoveryResult result;
 
         QSet<QString>   seenIds;
@@ -64,19 +68,18 @@ namespace bb::providers {
             const QFileInfoList manifests = dir.entryInfoList(QStringList{"*.json"}, QDir::Files | QDir::Readable, QDir::Name);
 
             for (const QFileInfo& manifestInfo : manifests) {
-                QFile file(manifestInfo.absoluteFilePath());
-                if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+                const auto parseResult = readManifest(manifestInfo);
+                if (!parseResult) {
                     result.warnings.push_back(QStringLiteral("Skipping manifest %1: cannot read file").arg(manifestInfo.absoluteFilePath()));
                     continue;
                 }
 
-                const auto parseResult = parseProviderManifest(file.readAll(), manifestInfo.absoluteFilePath());
-                if (!parseResult.ok) {
-                    result.warnings.push_back(QStringLiteral("Skipping manifest %1: %2").arg(manifestInfo.absoluteFilePath(), parseResult.error));
+                if (!parseResult->ok) {
+                    result.warnings.push_back(QStringLiteral("Skipping manifest %1: %2").arg(manifestInfo.absoluteFilePath(), parseResult->error));
                     continue;
                 }
 
-                const ProviderManifest& manifest = parseResult.manifest;
+                const ProviderManifest& manifest = parseResult->manifest;
                 if (seenIds.contains(manifest.id)) {
                     result.warnings.push_back(QStringLiteral("Skipping manifest %1: duplicate id '%2' already selected from higher precedence directory")
                                                   .arg(manifestInfo.absoluteFilePath(), manifest.id));
@@ -91,4 +94,13 @@ namespace bb::providers {
         return result;
     }
 
+    std::optional<ParseResult> ProviderDiscovery::readManifest(const QFileInfo& file) {
+        QFile manifestFile(file.absoluteFilePath());
+        if (!manifestFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            return std::nullopt;
+        }
+
+        return parseProviderManifest(manifestFile.readAll(), file.absoluteFilePath());
+    }
+
 } // namespace bb::providers
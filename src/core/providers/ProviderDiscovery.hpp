@@ -2,10 +2,14 @@
 
 #include "ProviderManifest.hpp"
 
+#include <QFileInfo>
 #include <QList>
 #include <QString>
 #include <QStringList>
 
+#include <functional>
+#include <optional>
+
 namespace bb::providers {
 
     struct DiscoveryResult {
@@ -15,8 +19,14 @@ namespace bb::providers {
 
     class ProviderDiscovery {
       public:
-        static QStringList     defaultSearchDirs(const QString& systemDir = QString());
-        static DiscoveryResult discover(const QStringList& searchDirs);
+        // Parses one listed manifest; nullopt when the file cannot be read
+        using ManifestReader = std::function<std::optional<ParseResult>(const QFileInfo& file)>;
+
+        static QStringList                defaultSearchDirs(const QString& systemDir = QString());
+        static DiscoveryResult            discover(const QStringList& searchDirs);
+        // Same precedence and warnings as discover(), with manifests supplied by readManifest
+        static DiscoveryResult            discover(const QStringList& searchDirs, const ManifestReader& readManifest);
+        static std::optional<ParseResult> readManifest(const QFileInfo& file);
     };
 
 } // namespace bb::providers
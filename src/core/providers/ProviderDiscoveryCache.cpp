@@ -0,0 +1,146 @@
+#include "ProviderDiscoveryCache.hpp"
+
+#include <QDir>
+#include <QFileInfo>
+
+namespace bb::providers {
+
+    namespace {
+
+        QString nearestExistingAncestor(const QString& path) {
+            QString ancestor = QFileInfo(path).absolutePath();
+            while (!QFileInfo(ancestor).isDir() && ancestor != QDir::rootPath()) {
+                ancestor = QFileInfo(ancestor).absolutePath();
+            }
+            return ancestor;
+        }
+
+        // First path component below ancestor on the way to target
+        QString childToward(const QString& ancestor, const QString& target) {
+            const qsizetype start = ancestor.endsWith(u'/') ? ancestor.size() : ancestor.size() + 1;
+            const qsizetype end   = target.indexOf(u'/', start);
+            return target.left(end < 0 ? target.size() : end);
+        }
+
+    } // namespace
+
+    ProviderDiscoveryCache::ProviderDiscoveryCache(QObject* parent) : QObject(parent) {
+        connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &ProviderDiscoveryCache::onDirectoryChanged);
+        connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &ProviderDiscoveryCache::onFileChanged);
+    }
+
+    void ProviderDiscoveryCache::setSearchDirs(const QStringList& searchDirs) {
+        m_searchDirs = searchDirs;
+        invalidate();
+    }
+
+    const QStringList& ProviderDiscoveryCache::searchDirs() const {
+        return m_searchDirs;
+    }
+
+    const DiscoveryResult& ProviderDiscoveryCache::result() {
+        if (m_stale) {
+            rebuild();
+        }
+        return m_result;
+    }
+
+    void ProviderDiscoveryCache::invalidate() {
+        m_manifests.clear();
+        m_stale = true;
+    }
+
+    bool ProviderDiscoveryCache::isStale() const {
+        return m_stale;
+    }
+
+    qsizetype ProviderDiscoveryCache::manifestReads() const {
+        return m_manifestReads;
+    }
+
+    void ProviderDiscoveryCache::rebuild() {
+        QHash<QString, CachedManifest> previous;
+        previous.swap(m_manifests);
+
+        m_result = ProviderDiscovery::discover(m_searchDirs, [&](const QFileInfo& file) -> std::optional<ParseResult> {
+            const QString path  = file.absoluteFilePath();
+            const qint64  mtime = file.lastModified().toMSecsSinceEpoch();
+            const qint64  size  = file.size();
+
+            if (const auto known = previous.constFind(path); known != previous.cend() && known->mtime == mtime && known->size == size) {
+                m_manifests.insert(path, *known);
+                return known->parsed;
+            }
+
+            ++m_manifestReads;
+            auto parsed = ProviderDiscovery::readManifest(file);
+            if (parsed) {
+                // Unreadable files are not remembered, so they are retried on the next change
+                m_manifests.insert(path, CachedManifest{mtime, size, *parsed});
+            }
+            return parsed;
+        });
+
+        m_stale = false;
+        watchSearchDirs();
+    }
+
+    void ProviderDiscoveryCache::watchSearchDirs() {
+        const QStringList watched = m_watcher.files() + m_watcher.directories();
+        if (!watched.isEmpty()) {
+            m_watcher.removePaths(watched);
+        }
+        m_watchedDirs.clear();
+        m_missingDirs.clear();
+
+        QStringList paths;
+        for (const QString& rawDir : m_searchDirs) {
+            const QString dir = QDir::cleanPath(QFileInfo(rawDir).absoluteFilePath());
+            if (QFileInfo(dir).isDir()) {
+                m_watchedDirs.insert(dir);
+                if (!paths.contains(dir)) {
+                    paths.append(dir);
+                }
+                continue;
+            }
+
+            // Wait for the directory to appear; a user's providers.d usually does not exist
+            const QString ancestor = nearestExistingAncestor(dir);
+            m_missingDirs.insert(ancestor, dir);
+            if (!paths.contains(ancestor)) {
+                paths.append(ancestor);
+            }
+        }
+
+        // Rewrites in place keep the directory untouched, so manifests are watched themselves
+        for (auto it = m_manifests.cbegin(); it != m_manifests.cend(); ++it) {
+            paths.append(it.key());
+        }
+
+        if (!paths.isEmpty()) {
+            m_watcher.addPaths(paths);
+        }
+    }
+
+    void ProviderDiscoveryCache::onDirectoryChanged(const QString& path) {
+        const auto missing = m_missingDirs.equal_range(path);
+        if (missing.first == missing.second || m_watchedDirs.contains(path)) {
+            m_stale = true;
+            return;
+        }
+
+        // Activity next to a missing search directory only matters once the path toward it grows
+        for (auto it = missing.first; it != missing.second; ++it) {
+            if (QFileInfo(childToward(path, *it)).isDir()) {
+                m_stale = true;
+                return;
+            }
+        }
+    }
+
+    void ProviderDiscoveryCache::onFileChanged(const QString& path) {
+        m_manifests.remove(path);
+        m_stale = true;
+    }
+
+} // namespace bb::providers
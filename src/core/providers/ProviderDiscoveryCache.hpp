@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ProviderDiscovery.hpp"
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QMultiHash>
+#include <QObject>
+#include <QSet>
+
+namespace bb::providers {
+
+    // ProviderDiscovery::discover() kept current through inotify
+    // Between changes result() touches no files; after one, only manifests whose mtime or size changed are parsed again
+    class ProviderDiscoveryCache : public QObject {
+        Q_OBJECT
+
+      public:
+        explicit ProviderDiscoveryCache(QObject* parent = nullptr);
+
+        void                   setSearchDirs(const QStringList& searchDirs);
+        const QStringList&     searchDirs() const;
+
+        // Manifests and warnings as discover() would return them now
+        const DiscoveryResult& result();
+
+        // Drops every parsed manifest; the next result() reads them all again
+        void                   invalidate();
+
+        bool                   isStale() const;
+        // Manifest files read so far, for tests
+        qsizetype              manifestReads() const;
+
+      private:
+        struct CachedManifest {
+            qint64      mtime = -1;
+            qint64      size  = -1;
+            ParseResult parsed;
+        };
+
+        void                           rebuild();
+        void                           watchSearchDirs();
+        void                           onDirectoryChanged(const QString& path);
+        void                           onFileChanged(const QString& path);
+
+        QStringList                    m_searchDirs;
+        QFileSystemWatcher             m_watcher;
+        QHash<QString, CachedManifest> m_manifests;
+        QSet<QString>                  m_watchedDirs;
+        // Nearest existing ancestor -> search directory below it that does not exist yet
+        QMultiHash<QString, QString>   m_missingDirs;
+        DiscoveryResult                m_result;
+        bool                           m_stale         = true;
+        qsizetype                      m_manifestReads = 0;
+    };
+
+} // namespace bb::providers
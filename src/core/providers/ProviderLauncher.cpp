@@ -1,14 +1,29 @@
 #include "ProviderLauncher.hpp"
+#include "../../common/Constants.hpp"
 
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
+#include <QJsonArray>
 #include <QProcess>
 #include <QRandomGenerator>
+#include <QSocketNotifier>
 #include <QStandardPaths>
 
 #include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
 
 namespace bb::providers {
 
@@ -20,7 +35,72 @@ namespace bb::providers {
         inline constexpr auto   LEGACY_ENV_ID     = "__legacy_env__";
         inline constexpr auto   LEGACY_DEFAULT_ID = "__legacy_default__";
 
-        qint64                  computeBackoffMs(int failures) {
+        // A launched provider has this long to send ui.register before the next candidate is tried
+        inline constexpr qint64 DEFAULT_REGISTER_DEADLINE_MS = 10000;
+        inline constexpr qint64 MIN_REGISTER_DEADLINE_MS     = 1000;
+        // Learned deadlines stay between these, so one quick start does not leave a cold start looking hung
+        inline constexpr qint64 MIN_LEARNED_DEADLINE_MS = 5000;
+        inline constexpr qint64 MAX_LEARNED_DEADLINE_MS = 120000;
+        // Headroom over a provider's slowest recent startup
+        inline constexpr qint64 REGISTER_DEADLINE_FACTOR = 4;
+        inline constexpr qint64 REGISTER_LATENCY_WEIGHT  = 4; // new samples count for 1/4
+        // How long a provider told to stop with SIGTERM has before it gets SIGKILL
+        inline constexpr qint64 TERMINATE_GRACE_MS = 2000;
+        // A provider that hung once is passed over long enough for failover to reach the built-in fallback
+        inline constexpr qint64 MISSED_DEADLINE_BACKOFF_MS = 60000;
+
+        // Manifest capability of providers that take their connection from PROVIDER_HANDOFF_FD
+        inline constexpr auto   PRECONNECTED_CAPABILITY = "preconnected";
+
+        QJsonObject             handoffRegistration(const QString& name, const QString& kind, int priority, bool quiescent) {
+            QJsonObject registration{{json::KEY_TYPE, "ui.register"}, {json::KEY_NAME, name}, {json::KEY_KIND, kind}, {json::KEY_PRIORITY, priority}};
+            if (quiescent) {
+                registration[json::KEY_CAPABILITIES] = QJsonArray{json::VAL_QUIESCENT};
+            }
+            return registration;
+        }
+
+        int                     openPidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+            return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+#else
+            Q_UNUSED(pid)
+            return -1;
+#endif
+        }
+
+        // Kernels before 5.3 have no pidfd; those keep the unsupervised startDetached() path
+        bool pidfdSupported() {
+            static const bool supported = [] {
+                const int fd = openPidfd(::getpid());
+                if (fd < 0) {
+                    return false;
+                }
+                ::close(fd);
+                return true;
+            }();
+            return supported;
+        }
+
+        QString nearestExistingAncestor(const QString& path) {
+            QString ancestor = QFileInfo(path).absolutePath();
+            while (!QFileInfo(ancestor).isDir() && ancestor != QDir::rootPath()) {
+                ancestor = QFileInfo(ancestor).absolutePath();
+            }
+            return ancestor;
+        }
+
+        QString describeWaitStatus(int status) {
+            if (WIFEXITED(status)) {
+                return QStringLiteral("exited with status %1").arg(WEXITSTATUS(status));
+            }
+            if (WIFSIGNALED(status)) {
+                return QStringLiteral("killed by signal %1").arg(WTERMSIG(status));
+            }
+            return QStringLiteral("ended with wait status %1").arg(status);
+        }
+
+        qint64 computeBackoffMs(int failures) {
             const qint64 exp    = BASE_BACKOFF_MS << std::min(failures, 8);
             const qint64 cap    = std::min(exp, MAX_BACKOFF_MS);
             const qint64 jitter = static_cast<qint64>(QRandomGenerator::global()->bounded(121));
@@ -29,8 +109,201 @@ namespace bb::providers {
 
     } // namespace
 
-    ProviderLauncher::ProviderLauncher(NowFn nowFn, StartProcessFn startProcessFn) :
-        m_nowFn(nowFn ? std::move(nowFn) : defaultNowMs), m_startProcessFn(startProcessFn ? std::move(startProcessFn) : defaultStartProcess) {}
+    ProviderLauncher::ProviderLauncher(NowFn nowFn, StartProcessFn startProcessFn, ProbeFn probeFn, FindExecutableFn findExecutableFn) :
+        m_nowFn(nowFn ? std::move(nowFn) : defaultNowMs), m_startProcessFn(std::move(startProcessFn)), m_probeFn(probeFn ? std::move(probeFn) : defaultProbe),
+        m_findExecutableFn(findExecutableFn ? std::move(findExecutableFn) : defaultFindExecutable), m_defaultRegisterDeadlineMs(DEFAULT_REGISTER_DEADLINE_MS) {
+        // Cached lookups are only checked again after inotify reports a change that could affect them
+        QObject::connect(&m_executableWatcher, &QFileSystemWatcher::directoryChanged, &m_executableWatcher, [this](const QString& dir) {
+            m_searchPathChanged = m_searchPathChanged || m_searchPath.contains(dir);
+            m_executablesStale  = true;
+        });
+        QObject::connect(&m_executableWatcher, &QFileSystemWatcher::fileChanged, &m_executableWatcher, [this] { m_executablesStale = true; });
+    }
+
+    ProviderLauncher::~ProviderLauncher() {
+        // Providers outlive the launcher; only the watches go away
+        for (auto& [pidfd, process] : m_supervised) {
+            delete process.notifier;
+            ::close(pidfd);
+        }
+    }
+
+    void ProviderLauncher::setExitHandler(ExitFn exitFn) {
+        m_exitFn = std::move(exitFn);
+    }
+
+    RegistrationOutcome ProviderLauncher::providerRegistered(qint64 pid) {
+        RegistrationOutcome outcome;
+        if (pid > 0 && m_supersededDeadlines.remove(pid) > 0) {
+            outcome.superseded = true;
+            return outcome;
+        }
+
+        // A supervised launch is only credited by its own process; a UI started by hand or a provider
+        // reconnecting leaves it, and its deadline, alone
+        const auto launchedAs = [pid](const std::optional<PendingRegistration>& launch) { return launch && launch->pid > 0 && launch->pid == pid; };
+        const bool supervised = (m_pendingRegistration && m_pendingRegistration->pid > 0) || (m_hedgeRegistration && m_hedgeRegistration->pid > 0);
+        if (supervised && !launchedAs(m_pendingRegistration) && !launchedAs(m_hedgeRegistration)) {
+            return outcome;
+        }
+
+        for (auto& [pidfd, process] : m_supervised) {
+            if (!process.registered && !process.superseded && (pid <= 0 || process.pid == pid)) {
+                process.registered = true;
+                markSuccess(process.providerId);
+            }
+        }
+
+        // First to register wins the race; anything else counts as the launch it was waiting for
+        const bool hedgeWon = m_hedgeRegistration && pid > 0 && m_hedgeRegistration->pid == pid;
+        const auto winner   = hedgeWon ? m_hedgeRegistration : m_pendingRegistration;
+        const auto loser    = hedgeWon ? m_pendingRegistration : m_hedgeRegistration;
+        m_pendingRegistration.reset();
+        m_hedgeRegistration.reset();
+        m_plannedHedge.reset();
+
+        if (loser) {
+            supersede(*loser);
+            outcome.supersededPid = loser->pid;
+        }
+        if (!winner) {
+            return outcome;
+        }
+
+        markSuccess(winner->providerId);
+
+        const qint64 latencyMs = std::max<qint64>(0, m_nowFn() - winner->launchedMs);
+        const auto   known     = m_registerLatencyMs.find(winner->providerId);
+        if (known == m_registerLatencyMs.end()) {
+            m_registerLatencyMs.insert(winner->providerId, latencyMs);
+        } else {
+            *known += (latencyMs - *known) / REGISTER_LATENCY_WEIGHT;
+        }
+        // A slow start counts in full; quicker ones only wear it down
+        qint64& peakMs = m_registerPeakMs[winner->providerId];
+        peakMs         = std::max(latencyMs, peakMs - (peakMs - latencyMs) / REGISTER_LATENCY_WEIGHT);
+
+        outcome.providerId = winner->providerId;
+        outcome.latencyMs  = latencyMs;
+        return outcome;
+    }
+
+    bool ProviderLauncher::awaitingRegistration() const {
+        return m_pendingRegistration.has_value() || m_hedgeRegistration.has_value();
+    }
+
+    std::optional<qint64> ProviderLauncher::nextDeadlineMs() const {
+        std::optional<qint64> next;
+        const auto            consider = [&next](qint64 atMs) { next = next ? std::min(*next, atMs) : atMs; };
+
+        if (m_pendingRegistration) {
+            consider(m_pendingRegistration->deadlineMs);
+        }
+        if (m_plannedHedge) {
+            consider(m_plannedHedge->atMs);
+        }
+        if (m_hedgeRegistration) {
+            consider(m_hedgeRegistration->deadlineMs);
+        }
+        for (const qint64 deadlineMs : m_supersededDeadlines) {
+            consider(deadlineMs);
+        }
+        for (const qint64 killAtMs : m_killDeadlines) {
+            consider(killAtMs);
+        }
+        return next;
+    }
+
+    std::optional<LaunchAttemptResult> ProviderLauncher::startHedge() {
+        const qint64 nowMs = m_nowFn();
+        if (!m_plannedHedge || nowMs < m_plannedHedge->atMs) {
+            return std::nullopt;
+        }
+
+        const PlannedHedge hedge = *m_plannedHedge;
+        m_plannedHedge.reset();
+        if (!m_pendingRegistration) {
+            return std::nullopt;
+        }
+
+        LaunchAttemptResult result;
+        result.attempted  = true;
+        result.providerId = hedge.candidate.id;
+        result.executable = hedge.candidate.exec;
+
+        QString startError;
+        if (!startCandidate(hedge.candidate, result.pid, result.handoffFd, startError)) {
+            markFailure(hedge.candidate.id, hedge.candidate.exec, nowMs);
+            result.detail = QStringLiteral("hedge launch failed for '%1'").arg(hedge.candidate.displayName);
+            if (!startError.isEmpty()) {
+                result.detail += QStringLiteral(": ") + startError;
+            }
+            return result;
+        }
+
+        result.launched           = true;
+        result.registerDeadlineMs = nowMs + registerDeadlineFor(hedge.candidate.id, hedge.candidate.registerTimeoutMs);
+        if (result.handoffFd >= 0) {
+            result.handoffRegistration = hedge.candidate.handoffRegistration;
+        }
+        result.detail             = QStringLiteral("hedged '%1' after %2 ms").arg(hedge.candidate.displayName).arg(nowMs - m_pendingRegistration->launchedMs);
+        m_hedgeRegistration       = PendingRegistration{hedge.candidate.id, hedge.candidate.exec, result.pid, nowMs, result.registerDeadlineMs};
+        return result;
+    }
+
+    std::optional<RegistrationTimeout> ProviderLauncher::expireRegistration() {
+        const qint64 nowMs = m_nowFn();
+
+        // Still running after SIGTERM; entries go when the process is reaped, so the pid is still its own
+        for (auto it = m_killDeadlines.begin(); it != m_killDeadlines.end();) {
+            if (nowMs >= it.value()) {
+                ::kill(static_cast<pid_t>(it.key()), SIGKILL);
+                it = m_killDeadlines.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // Losers that never got far enough to be told are stopped instead
+        for (auto it = m_supersededDeadlines.begin(); it != m_supersededDeadlines.end();) {
+            if (nowMs >= it.value()) {
+                terminate(it.key(), nowMs);
+                it = m_supersededDeadlines.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        if (m_hedgeRegistration && nowMs >= m_hedgeRegistration->deadlineMs) {
+            const PendingRegistration pending = *m_hedgeRegistration;
+            m_hedgeRegistration.reset();
+            return expire(pending, nowMs);
+        }
+
+        if (m_pendingRegistration && nowMs >= m_pendingRegistration->deadlineMs) {
+            const PendingRegistration pending = *m_pendingRegistration;
+            forgetPrimary();
+            return expire(pending, nowMs);
+        }
+
+        return std::nullopt;
+    }
+
+    void ProviderLauncher::setDefaultRegisterDeadline(qint64 deadlineMs) {
+        m_defaultRegisterDeadlineMs = std::max(deadlineMs, MIN_REGISTER_DEADLINE_MS);
+    }
+
+    std::optional<qint64> ProviderLauncher::registerLatencyMs(const QString& providerId) const {
+        const auto it = m_registerLatencyMs.constFind(providerId);
+        if (it == m_registerLatencyMs.cend()) {
+            return std::nullopt;
+        }
+        return *it;
+    }
+
+    void ProviderLauncher::setHedgeDelay(qint64 delayMs) {
+        m_hedgeDelayMs = std::max<qint64>(0, delayMs);
+    }
 
     LaunchAttemptResult ProviderLauncher::tryLaunch(const QList<ProviderManifest>& manifests, const QString& socketPath, const QString& reason, bool hasActiveProvider,
                                                     bool hasPendingSessions, const QString& legacyFallbackPath, const QString& defaultFallbackPath) {
@@ -41,16 +314,16 @@ namespace bb::providers {
             return result;
         }
 
-        QString    selectionError;
-        const auto candidate = selectCandidate(manifests, legacyFallbackPath, defaultFallbackPath, socketPath, selectionError);
+        const qint64 nowMs = m_nowFn();
+
+        QString      selectionError;
+        const auto   candidate = selectCandidate(manifests, legacyFallbackPath, defaultFallbackPath, socketPath, nowMs, selectionError);
         if (candidate.id.isEmpty()) {
             result.detail = selectionError;
             return result;
         }
 
-        const qint64 nowMs = m_nowFn();
-
-        QString      throttleReason;
+        QString throttleReason;
         if (!canAttempt(candidate.id, nowMs, throttleReason)) {
             result.providerId = candidate.id;
             result.executable = candidate.exec;
@@ -62,24 +335,56 @@ namespace bb::providers {
         result.providerId = candidate.id;
         result.executable = candidate.exec;
 
-        if (!m_startProcessFn(candidate.exec, candidate.args, candidate.env)) {
-            markFailure(candidate.id, nowMs);
-            result.detail   = QStringLiteral("launch failed for '%1' (%2)").arg(candidate.displayName, reason);
+        QString startError;
+        if (!startCandidate(candidate, result.pid, result.handoffFd, startError)) {
+            markFailure(candidate.id, candidate.exec, nowMs);
+            result.detail = QStringLiteral("launch failed for '%1' (%2)").arg(candidate.displayName, reason);
+            if (!startError.isEmpty()) {
+                result.detail += QStringLiteral(": ") + startError;
+            }
             result.launched = false;
             return result;
         }
 
-        markSuccess(candidate.id);
-        result.launched = true;
-        result.detail   = QStringLiteral("launched '%1' (%2)").arg(candidate.displayName, reason);
+        // Only counts as started once it registers; see providerRegistered() and expireRegistration()
+        result.launched           = true;
+        result.registerDeadlineMs = nowMs + registerDeadlineFor(candidate.id, candidate.registerTimeoutMs);
+        result.detail             = QStringLiteral("launched '%1' (%2)").arg(candidate.displayName, reason);
+        if (result.handoffFd >= 0) {
+            result.handoffRegistration = candidate.handoffRegistration;
+        }
+        m_pendingRegistration     = PendingRegistration{candidate.id, candidate.exec, result.pid, nowMs, result.registerDeadlineMs};
+        m_hedgeRegistration.reset();
+        m_plannedHedge.reset();
+
+        // Racing needs pids to tell the two apart at registration, and something else to race against
+        const QString fallbackPath = defaultFallbackPath.trimmed();
+        const bool    hedgeable    = m_hedgeDelayMs > 0 && result.pid > 0 && candidate.id != LEGACY_ENV_ID && candidate.id != LEGACY_DEFAULT_ID;
+        QString       throttled;
+        const QString resolvedFallback = hedgeable && !fallbackPath.isEmpty() ? resolveExecutable(fallbackPath) : QString();
+        if (!resolvedFallback.isEmpty() && canAttempt(LEGACY_DEFAULT_ID, nowMs, throttled)) {
+            result.hedgeAtMs = nowMs + m_hedgeDelayMs;
+            m_plannedHedge   = PlannedHedge{legacyCandidate(LEGACY_DEFAULT_ID, QStringLiteral("legacy-default"), resolvedFallback, socketPath, baseEnvironment()), result.hedgeAtMs};
+        }
         return result;
     }
 
+    bool ProviderLauncher::startCandidate(const SelectedCandidate& candidate, qint64& pid, int& handoffFd, QString& error) {
+        if (m_startProcessFn) {
+            return m_startProcessFn(candidate.exec, candidate.args, candidate.env);
+        }
+        if (pidfdSupported()) {
+            pid = startSupervised(candidate, handoffFd, error);
+            return pid > 0;
+        }
+        return startDetached(candidate.exec, candidate.args, candidate.env);
+    }
+
     qint64 ProviderLauncher::defaultNowMs() {
         return QDateTime::currentMSecsSinceEpoch();
     }
 
-    bool ProviderLauncher::defaultStartProcess(const QString& program, const QStringList& args, const QProcessEnvironment& env) {
+    bool ProviderLauncher::startDetached(const QString& program, const QStringList& args, const QProcessEnvironment& env) {
         QProcess process;
         process.setProgram(program);
         process.setArguments(args);
@@ -87,47 +392,123 @@ namespace bb::providers {
         return process.startDetached();
     }
 
+    ProviderLauncher::FileProbe ProviderLauncher::defaultProbe(const QString& path) {
+        const QFileInfo info(path);
+        if (!info.exists()) {
+            return FileProbe{};
+        }
+
+        return FileProbe{info.lastModified().toMSecsSinceEpoch(), info.isFile() && info.isExecutable()};
+    }
+
+    QString ProviderLauncher::defaultFindExecutable(const QString& exec) {
+        return QStandardPaths::findExecutable(exec);
+    }
+
+    void ProviderLauncher::invalidateExecutables() {
+        m_searchPathChanged = true;
+        m_executablesStale  = true;
+    }
+
     QString ProviderLauncher::resolveExecutable(const QString& exec) {
+        if (!m_searchPathWatched) {
+            // A binary added to or removed from any PATH directory may change what a bare name resolves to
+            m_searchPathWatched = true;
+            m_searchPath        = qEnvironmentVariable("PATH").split(':', Qt::SkipEmptyParts);
+            for (const QString& dir : std::as_const(m_searchPath)) {
+                watchPath(dir);
+            }
+        }
+        if (m_executablesStale) {
+            revalidateExecutables();
+        }
+
+        if (const auto cached = m_executables.constFind(exec); cached != m_executables.cend()) {
+            return cached->path;
+        }
+
+        ResolvedExecutable resolved;
+        const QString      path  = exec.contains('/') ? exec : m_findExecutableFn(exec);
+        const FileProbe    probe = path.isEmpty() ? FileProbe{} : m_probeFn(path);
+        if (probe.executable) {
+            resolved.path = path;
+        }
+        resolved.mtimeMs = probe.mtimeMs;
+
+        // The binary itself for replacement and chmod; for an absolute exec, where it would be installed
+        if (!resolved.path.isEmpty()) {
+            watchPath(resolved.path);
+        }
         if (exec.contains('/')) {
-            return exec;
+            watchPath(nearestExistingAncestor(exec));
         }
 
-        return QStandardPaths::findExecutable(exec);
+        m_executables.insert(exec, resolved);
+        return resolved.path;
     }
 
-    bool ProviderLauncher::isExecutableFile(const QString& path) {
-        const QFileInfo info(path);
-        return info.exists() && info.isFile() && info.isExecutable();
+    void ProviderLauncher::watchPath(const QString& path) {
+        // Already watched, or gone; a removed path is dropped from the watcher by itself
+        if (m_executableWatcher.files().contains(path) || m_executableWatcher.directories().contains(path) || !QFileInfo::exists(path)) {
+            return;
+        }
+        m_executableWatcher.addPath(path);
     }
 
-    QProcessEnvironment ProviderLauncher::mergeEnvironment(const QJsonObject& envObject) {
-        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    void ProviderLauncher::revalidateExecutables() {
+        m_executablesStale     = false;
+        const bool pathChanged = std::exchange(m_searchPathChanged, false);
+
+        for (auto it = m_executables.begin(); it != m_executables.end();) {
+            const bool    bareName = !it.key().contains('/');
+            const QString probed   = bareName ? it->path : it.key();
+            bool          stale    = bareName && pathChanged;
+            if (!stale && !probed.isEmpty()) {
+                // chmod leaves the mtime alone, so the executable bit is compared as well
+                const FileProbe probe = m_probeFn(probed);
+                stale                 = probe.mtimeMs != it->mtimeMs || probe.executable == it->path.isEmpty();
+            }
+            it = stale ? m_executables.erase(it) : std::next(it);
+        }
+    }
+
+    const QProcessEnvironment& ProviderLauncher::baseEnvironment() {
+        // The daemon never changes its own environment, so one copy serves every launch
+        if (!m_baseEnvironment) {
+            m_baseEnvironment = QProcessEnvironment::systemEnvironment();
+        }
+        return *m_baseEnvironment;
+    }
+
+    QProcessEnvironment ProviderLauncher::mergeEnvironment(const ProviderManifest& manifest) {
+        if (manifest.env.isEmpty()) {
+            return baseEnvironment();
+        }
 
-        for (auto it = envObject.begin(); it != envObject.end(); ++it) {
-            env.insert(it.key(), it.value().toString());
+        auto overlay = m_environmentByProvider.find(manifest.id);
+        if (overlay == m_environmentByProvider.end() || overlay->env != manifest.env) {
+            QProcessEnvironment env = baseEnvironment();
+            for (auto it = manifest.env.begin(); it != manifest.env.end(); ++it) {
+                env.insert(it.key(), it.value().toString());
+            }
+            overlay = m_environmentByProvider.insert(manifest.id, EnvironmentOverlay{manifest.env, env});
         }
 
-        return env;
+        return overlay->merged;
     }
 
     ProviderLauncher::SelectedCandidate ProviderLauncher::selectCandidate(const QList<ProviderManifest>& manifests, const QString& legacyFallbackPath,
-                                                                          const QString& defaultFallbackPath, const QString& socketPath, QString& selectionError) const {
+                                                                          const QString& defaultFallbackPath, const QString& socketPath, qint64 nowMs, QString& selectionError) {
         const QString legacyEnvPath = legacyFallbackPath.trimmed();
         if (!legacyEnvPath.isEmpty()) {
-            if (!isExecutableFile(legacyEnvPath)) {
+            // posix_spawn does not search PATH, so a bare name is launched by the path it resolved to
+            const QString resolvedExec = resolveExecutable(legacyEnvPath);
+            if (resolvedExec.isEmpty()) {
                 selectionError = QStringLiteral("skip: BB_AUTH_FALLBACK_PATH is not executable: %1").arg(legacyEnvPath);
                 return SelectedCandidate{};
             }
 
-            SelectedCandidate candidate;
-            candidate.id          = LEGACY_ENV_ID;
-            candidate.displayName = QStringLiteral("legacy-env");
-            candidate.exec        = legacyEnvPath;
-            if (!socketPath.isEmpty()) {
-                candidate.args << "--socket" << socketPath;
-            }
-            candidate.env = QProcessEnvironment::systemEnvironment();
-            return candidate;
+            return legacyCandidate(LEGACY_ENV_ID, QStringLiteral("legacy-env"), resolvedExec, socketPath, baseEnvironment());
         }
 
         QList<ProviderManifest> autostart;
@@ -145,9 +526,15 @@ namespace bb::providers {
             return a.id < b.id;
         });
 
+        QString throttled;
         for (const auto& manifest : autostart) {
             const QString resolvedExec = resolveExecutable(manifest.exec);
-            if (resolvedExec.isEmpty() || !isExecutableFile(resolvedExec)) {
+            if (resolvedExec.isEmpty()) {
+                continue;
+            }
+
+            // A provider that just failed yields to the next one rather than holding up the prompt
+            if (!canAttempt(manifest.id, nowMs, throttled)) {
                 continue;
             }
 
@@ -159,27 +546,180 @@ namespace bb::providers {
             if (!socketPath.isEmpty()) {
                 candidate.args << "--socket" << socketPath;
             }
-            candidate.env = mergeEnvironment(manifest.env);
+            candidate.env               = mergeEnvironment(manifest);
+            candidate.registerTimeoutMs = manifest.registerTimeoutMs;
+            if (manifest.capabilities.contains(PRECONNECTED_CAPABILITY)) {
+                candidate.handoffRegistration = handoffRegistration(manifest.name, manifest.kind, manifest.priority, manifest.capabilities.contains(json::VAL_QUIESCENT));
+            }
             return candidate;
         }
 
+        // Also where failover ends once every manifest provider failed to come up
         const QString fallbackPath = defaultFallbackPath.trimmed();
-        if (fallbackPath.isEmpty() || !isExecutableFile(fallbackPath)) {
-            selectionError = QStringLiteral("skip: no launchable provider candidate");
+        const QString resolvedExec = fallbackPath.isEmpty() ? QString() : resolveExecutable(fallbackPath);
+        if (resolvedExec.isEmpty()) {
+            selectionError = throttled.isEmpty() ? QStringLiteral("skip: no launchable provider candidate") : throttled;
             return SelectedCandidate{};
         }
 
+        return legacyCandidate(LEGACY_DEFAULT_ID, QStringLiteral("legacy-default"), resolvedExec, socketPath, baseEnvironment());
+    }
+
+    ProviderLauncher::SelectedCandidate ProviderLauncher::legacyCandidate(const QString& id, const QString& displayName, const QString& exec, const QString& socketPath,
+                                                                          const QProcessEnvironment& env) {
         SelectedCandidate candidate;
-        candidate.id          = LEGACY_DEFAULT_ID;
-        candidate.displayName = QStringLiteral("legacy-default");
-        candidate.exec        = fallbackPath;
+        candidate.id          = id;
+        candidate.displayName = displayName;
+        candidate.exec        = exec;
         if (!socketPath.isEmpty()) {
             candidate.args << "--socket" << socketPath;
         }
-        candidate.env = QProcessEnvironment::systemEnvironment();
+        candidate.env = env;
+        // The bundled bb-auth-fallback, which registers as this when it connects on its own; whatever
+        // BB_AUTH_FALLBACK_PATH names may ignore the descriptor, so it connects by itself like a plain manifest
+        if (id == LEGACY_DEFAULT_ID) {
+            candidate.handoffRegistration = handoffRegistration(QStringLiteral("bb-auth-fallback"), QStringLiteral("fallback"), 10, true);
+        }
         return candidate;
     }
 
+    qint64 ProviderLauncher::startSupervised(const SelectedCandidate& candidate, int& handoffFd, QString& error) {
+        // A connection made here is registered before the provider runs; it then skips connect and ui.register
+        int pair[2] = {-1, -1};
+        if (!candidate.handoffRegistration.isEmpty() && ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) == 0 && pair[1] == PROVIDER_HANDOFF_FD) {
+            // dup2() onto itself would leave close-on-exec set
+            const int moved = ::fcntl(pair[1], F_DUPFD_CLOEXEC, PROVIDER_HANDOFF_FD + 1);
+            ::close(pair[1]);
+            pair[1] = moved;
+            if (moved < 0) {
+                ::close(pair[0]);
+                pair[0] = -1;
+            }
+        }
+        const bool          handoff = pair[0] >= 0;
+
+        QProcessEnvironment env     = candidate.env;
+        env.remove(PROVIDER_HANDOFF_ENV);
+        if (handoff) {
+            env.insert(PROVIDER_HANDOFF_ENV, QString::number(PROVIDER_HANDOFF_FD));
+        }
+
+        QList<QByteArray> argStorage{QFile::encodeName(candidate.exec)};
+        for (const QString& arg : candidate.args) {
+            argStorage.append(arg.toLocal8Bit());
+        }
+        QList<QByteArray> envStorage;
+        for (const QString& entry : env.toStringList()) {
+            envStorage.append(entry.toLocal8Bit());
+        }
+
+        std::vector<char*> argv;
+        std::vector<char*> envp;
+        for (QByteArray& arg : argStorage) {
+            argv.push_back(arg.data());
+        }
+        for (QByteArray& entry : envStorage) {
+            envp.push_back(entry.data());
+        }
+        argv.push_back(nullptr);
+        envp.push_back(nullptr);
+
+        // The daemon's signal mask and dispositions must not leak into the provider
+        posix_spawnattr_t attr;
+        posix_spawnattr_init(&attr);
+        sigset_t mask;
+        sigemptyset(&mask);
+        posix_spawnattr_setsigmask(&attr, &mask);
+        sigset_t defaults;
+        sigemptyset(&defaults);
+        sigaddset(&defaults, SIGPIPE);
+        sigaddset(&defaults, SIGCHLD);
+        posix_spawnattr_setsigdefault(&attr, &defaults);
+        short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+#ifdef POSIX_SPAWN_SETSID
+        // Its own session, as startDetached() gave it
+        flags |= POSIX_SPAWN_SETSID;
+#endif
+        posix_spawnattr_setflags(&attr, flags);
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        if (handoff) {
+            posix_spawn_file_actions_adddup2(&actions, pair[1], PROVIDER_HANDOFF_FD);
+        }
+
+        pid_t     pid = -1;
+        const int rc  = ::posix_spawn(&pid, argv.front(), &actions, &attr, argv.data(), envp.data());
+        posix_spawn_file_actions_destroy(&actions);
+        posix_spawnattr_destroy(&attr);
+        if (handoff) {
+            ::close(pair[1]);
+        }
+        if (rc != 0) {
+            if (handoff) {
+                ::close(pair[0]);
+            }
+            error = qt_error_string(rc);
+            return 0;
+        }
+        if (handoff) {
+            handoffFd = pair[0];
+        }
+
+        const int pidfd = openPidfd(pid);
+        if (pidfd < 0) {
+            // Still our child, so it must be reaped; it just goes unwatched
+            std::thread([pid] { ::waitpid(pid, nullptr, 0); }).detach();
+            return pid;
+        }
+
+        // A pidfd turns readable when its process exits
+        auto* notifier = new QSocketNotifier(pidfd, QSocketNotifier::Read);
+        QObject::connect(notifier, &QSocketNotifier::activated, notifier, [this, pidfd] { onProcessExited(pidfd); });
+        m_supervised.emplace(pidfd, SupervisedProcess{.providerId = candidate.id, .exec = candidate.exec, .pid = pid, .pidfd = pidfd, .notifier = notifier});
+        return pid;
+    }
+
+    void ProviderLauncher::onProcessExited(int pidfd) {
+        const auto it = m_supervised.find(pidfd);
+        if (it == m_supervised.end()) {
+            return;
+        }
+
+        const SupervisedProcess process = it->second;
+        m_supervised.erase(it);
+        process.notifier->setEnabled(false);
+        process.notifier->deleteLater();
+
+        // Already exited, so this only collects the status
+        int status = 0;
+        while (::waitpid(static_cast<pid_t>(process.pid), &status, 0) < 0 && errno == EINTR) {}
+        ::close(pidfd);
+
+        ProviderExit exit;
+        exit.providerId         = process.providerId;
+        exit.pid                = process.pid;
+        exit.status             = describeWaitStatus(status);
+        exit.beforeRegistration = !process.registered;
+        exit.timedOut           = process.timedOut;
+        exit.superseded         = process.superseded;
+        if (exit.beforeRegistration && !exit.timedOut && !exit.superseded) {
+            markFailure(process.providerId, process.exec, m_nowFn());
+        }
+        m_supersededDeadlines.remove(process.pid);
+        m_killDeadlines.remove(process.pid);
+        if (m_hedgeRegistration && m_hedgeRegistration->pid == process.pid) {
+            m_hedgeRegistration.reset();
+        }
+        if (m_pendingRegistration && m_pendingRegistration->pid == process.pid) {
+            forgetPrimary();
+        }
+
+        if (m_exitFn) {
+            m_exitFn(exit);
+        }
+    }
+
     bool ProviderLauncher::canAttempt(const QString& id, qint64 nowMs, QString& detail) const {
         const auto it = m_retryByProvider.constFind(id);
         if (it == m_retryByProvider.constEnd()) {
@@ -194,11 +734,80 @@ namespace bb::providers {
         return true;
     }
 
+    RegistrationTimeout ProviderLauncher::expire(const PendingRegistration& pending, qint64 nowMs) {
+        markFailure(pending.providerId, pending.exec, nowMs);
+        auto& retry          = m_retryByProvider[pending.providerId];
+        retry.nextEligibleMs = std::max(retry.nextEligibleMs, nowMs + MISSED_DEADLINE_BACKOFF_MS);
+
+        RegistrationTimeout timeout;
+        timeout.providerId = pending.providerId;
+        timeout.waitedMs   = nowMs - pending.launchedMs;
+
+        // It took at least this long, so the next launch is given more time rather than less
+        qint64& peakMs = m_registerPeakMs[pending.providerId];
+        peakMs         = std::max(peakMs, timeout.waitedMs);
+
+        // Left running, it could still register and compete with the provider started in its place
+        for (auto& [pidfd, process] : m_supervised) {
+            if (process.pid == pending.pid && !process.registered) {
+                process.timedOut = true;
+                terminate(process.pid, nowMs);
+                timeout.terminated = true;
+            }
+        }
+        return timeout;
+    }
+
+    void ProviderLauncher::terminate(qint64 pid, qint64 nowMs) {
+        ::kill(static_cast<pid_t>(pid), SIGTERM);
+        m_killDeadlines.insert(pid, nowMs + TERMINATE_GRACE_MS);
+    }
+
+    void ProviderLauncher::supersede(const PendingRegistration& loser) {
+        for (auto& [pidfd, process] : m_supervised) {
+            if (process.pid == loser.pid) {
+                process.superseded = true;
+                // Told to shut down if it registers; stopped at its own deadline if it never does
+                m_supersededDeadlines.insert(process.pid, loser.deadlineMs);
+            }
+        }
+    }
+
+    void ProviderLauncher::forgetPrimary() {
+        m_pendingRegistration.reset();
+        m_plannedHedge.reset();
+
+        // A hedge already running carries on as the launch being waited for
+        if (m_hedgeRegistration) {
+            m_pendingRegistration = m_hedgeRegistration;
+            m_hedgeRegistration.reset();
+        }
+    }
+
+    qint64 ProviderLauncher::registerDeadlineFor(const QString& id, int manifestTimeoutMs) const {
+        if (manifestTimeoutMs > 0) {
+            return manifestTimeoutMs;
+        }
+
+        const auto peak = m_registerPeakMs.constFind(id);
+        if (peak == m_registerPeakMs.cend()) {
+            return m_defaultRegisterDeadlineMs;
+        }
+        // A shorter configured default also lowers the floor
+        const qint64 floorMs = std::min(MIN_LEARNED_DEADLINE_MS, m_defaultRegisterDeadlineMs);
+        return std::clamp(*peak * REGISTER_DEADLINE_FACTOR, floorMs, MAX_LEARNED_DEADLINE_MS);
+    }
+
     void ProviderLauncher::markSuccess(const QString& id) {
         m_retryByProvider.remove(id);
     }
 
-    void ProviderLauncher::markFailure(const QString& id, qint64 nowMs) {
+    void ProviderLauncher::markFailure(const QString& id, const QString& exec, qint64 nowMs) {
+        // Resolve afresh next time, in case the binary moved
+        for (auto it = m_executables.begin(); it != m_executables.end();) {
+            it = it->path == exec ? m_executables.erase(it) : std::next(it);
+        }
+
         auto& state = m_retryByProvider[id];
         state.failures += 1;
         state.nextEligibleMs = nowMs + computeBackoffMs(state.failures);
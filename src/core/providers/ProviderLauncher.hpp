@@ -2,30 +2,113 @@
 
 #include "ProviderManifest.hpp"
 
+#include <QFileSystemWatcher>
 #include <QHash>
+#include <QJsonObject>
 #include <QProcessEnvironment>
 
 #include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+class QSocketNotifier;
 
 namespace bb::providers {
 
     struct LaunchAttemptResult {
-        bool    attempted = false;
-        bool    launched  = false;
+        bool        attempted = false;
+        bool        launched  = false;
+        QString     providerId;
+        QString     executable;
+        QString     detail;
+        qint64      pid                = 0;  // 0 unless the launcher supervises the process
+        qint64      registerDeadlineMs = 0;  // by the launcher's clock; 0 unless launched
+        qint64      hedgeAtMs          = 0;  // when startHedge() races the built-in fallback; 0 if it won't
+        int         handoffFd          = -1; // daemon end of the provider's pre-connected socket; the caller owns it
+        QJsonObject handoffRegistration;     // the ui.register that connection stands for
+    };
+
+    // A supervised provider process that exited
+    struct ProviderExit {
+        QString providerId;
+        qint64  pid = 0;
+        QString status;                     // "exited with status 1", "killed by signal 11"
+        bool    beforeRegistration = false; // counted as a failed launch
+        bool    timedOut           = false; // stopped by expireRegistration(), which counted it already
+        bool    superseded         = false; // lost a hedged launch; never a failure
+    };
+
+    // A launch that did not register before its deadline
+    struct RegistrationTimeout {
         QString providerId;
-        QString executable;
-        QString detail;
+        qint64  waitedMs   = 0;
+        bool    terminated = false; // its exit still comes through the exit handler
+    };
+
+    struct RegistrationOutcome {
+        QString               providerId; // the launch that registered, if any
+        std::optional<qint64> latencyMs;
+        bool                  superseded    = false; // lost a hedged launch: it should be told to shut down
+        qint64                supersededPid = 0;     // the launch this one beat, if any
     };
 
     class ProviderLauncher {
       public:
-        using NowFn          = std::function<qint64()>;
-        using StartProcessFn = std::function<bool(const QString&, const QStringList&, const QProcessEnvironment&)>;
+        // What launching needs to know about a path; mtimeMs is -1 when it does not exist
+        struct FileProbe {
+            qint64 mtimeMs    = -1;
+            bool   executable = false;
+        };
+
+        using NowFn            = std::function<qint64()>;
+        using StartProcessFn   = std::function<bool(const QString&, const QStringList&, const QProcessEnvironment&)>;
+        using ProbeFn          = std::function<FileProbe(const QString&)>;
+        using FindExecutableFn = std::function<QString(const QString&)>;
+        using ExitFn           = std::function<void(const ProviderExit&)>;
+
+        // Without startProcessFn, providers are spawned directly and watched through a pidfd
+        explicit ProviderLauncher(NowFn nowFn = {}, StartProcessFn startProcessFn = {}, ProbeFn probeFn = {}, FindExecutableFn findExecutableFn = {});
+        ~ProviderLauncher();
+
+        ProviderLauncher(const ProviderLauncher&)            = delete;
+        ProviderLauncher& operator=(const ProviderLauncher&) = delete;
+
+        LaunchAttemptResult                tryLaunch(const QList<ProviderManifest>& manifests, const QString& socketPath, const QString& reason, bool hasActiveProvider,
+                                                     bool hasPendingSessions, const QString& legacyFallbackPath, const QString& defaultFallbackPath);
+
+        // Called from the event loop when a supervised provider exits; an exit before registration
+        // has already been recorded as a failure, so calling tryLaunch() again moves on to the next candidate
+        void                               setExitHandler(ExitFn exitFn);
+
+        // A provider registered; pid tells hedged launches apart. A supervised launch is only credited by
+        // its own pid; one started without a pid is credited by whichever provider registers first.
+        // The latency reported tunes that provider's next deadline. With a hedge in flight, the other
+        // launch is superseded and reported as such if it registers later
+        RegistrationOutcome                providerRegistered(qint64 pid = 0);
+
+        // While a launch awaits registration, launching again would only start a second copy
+        bool                               awaitingRegistration() const;
+
+        // When startHedge() or expireRegistration() next has something to do
+        std::optional<qint64>              nextDeadlineMs() const;
+
+        // Once the hedge delay has passed without a registration, starts the built-in fallback alongside
+        std::optional<LaunchAttemptResult> startHedge();
+
+        // Once a deadline has passed: counts the launch as failed and stops it if supervised (SIGTERM, then
+        // SIGKILL after a grace period), so the next tryLaunch() moves on to the next candidate. Call until it returns nothing
+        std::optional<RegistrationTimeout> expireRegistration();
 
-        explicit ProviderLauncher(NowFn nowFn = {}, StartProcessFn startProcessFn = {});
+        // Used when the manifest sets no registerTimeoutMs and the provider has no startup history
+        void                               setDefaultRegisterDeadline(qint64 deadlineMs);
+        std::optional<qint64>              registerLatencyMs(const QString& providerId) const;
 
-        LaunchAttemptResult tryLaunch(const QList<ProviderManifest>& manifests, const QString& socketPath, const QString& reason, bool hasActiveProvider, bool hasPendingSessions,
-                                      const QString& legacyFallbackPath, const QString& defaultFallbackPath);
+        // 0 disables hedging, which only applies to supervised manifest providers
+        void                               setHedgeDelay(qint64 delayMs);
+
+        // Checks every cached executable lookup again on the next launch; the inotify watch does this on its own
+        void                               invalidateExecutables();
 
       private:
         struct RetryState {
@@ -39,24 +122,113 @@ namespace bb::providers {
             QString             exec;
             QStringList         args;
             QProcessEnvironment env;
+            int                 registerTimeoutMs = 0;
+            // Pre-connected over PROVIDER_HANDOFF_FD and registered as this, when non-empty
+            QJsonObject         handoffRegistration;
+        };
+
+        // Outcome of resolving a manifest exec, kept until revalidation finds it changed
+        struct ResolvedExecutable {
+            QString path; // empty when nothing launchable was found
+            qint64  mtimeMs = -1;
+        };
+
+        // Manifest env applied over the base environment
+        struct EnvironmentOverlay {
+            QJsonObject         env;
+            QProcessEnvironment merged;
+        };
+
+        struct SupervisedProcess {
+            QString          providerId;
+            QString          exec;
+            qint64           pid        = 0;
+            int              pidfd      = -1;
+            bool             registered = false;
+            bool             timedOut   = false;
+            bool             superseded = false;
+            QSocketNotifier* notifier   = nullptr;
+        };
+
+        struct PendingRegistration {
+            QString providerId;
+            QString exec;
+            qint64  pid        = 0;
+            qint64  launchedMs = 0;
+            qint64  deadlineMs = 0;
         };
 
-        static qint64              defaultNowMs();
-        static bool                defaultStartProcess(const QString& program, const QStringList& args, const QProcessEnvironment& env);
-        static QString             resolveExecutable(const QString& exec);
-        static bool                isExecutableFile(const QString& path);
-        static QProcessEnvironment mergeEnvironment(const QJsonObject& envObject);
+        struct PlannedHedge {
+            SelectedCandidate candidate;
+            qint64            atMs = 0;
+        };
+
+        static qint64                      defaultNowMs();
+        static bool                        startDetached(const QString& program, const QStringList& args, const QProcessEnvironment& env);
+        static FileProbe                   defaultProbe(const QString& path);
+        static QString                     defaultFindExecutable(const QString& exec);
+
+        QString                            resolveExecutable(const QString& exec);
+        void                               revalidateExecutables();
+        void                               watchPath(const QString& path);
+        const QProcessEnvironment&         baseEnvironment();
+        QProcessEnvironment                mergeEnvironment(const ProviderManifest& manifest);
+
+        SelectedCandidate                  selectCandidate(const QList<ProviderManifest>& manifests, const QString& legacyFallbackPath, const QString& defaultFallbackPath,
+                                                           const QString& socketPath, qint64 nowMs, QString& selectionError);
+
+        bool                               canAttempt(const QString& id, qint64 nowMs, QString& detail) const;
+        void                               markSuccess(const QString& id);
+        void                               markFailure(const QString& id, const QString& exec, qint64 nowMs);
+        qint64                             registerDeadlineFor(const QString& id, int manifestTimeoutMs) const;
+        RegistrationTimeout                expire(const PendingRegistration& pending, qint64 nowMs);
+        void                               terminate(qint64 pid, qint64 nowMs);
+        void                               supersede(const PendingRegistration& loser);
+        void                               forgetPrimary();
+
+        static SelectedCandidate           legacyCandidate(const QString& id, const QString& displayName, const QString& exec, const QString& socketPath,
+                                                           const QProcessEnvironment& env);
+        bool                               startCandidate(const SelectedCandidate& candidate, qint64& pid, int& handoffFd, QString& error);
+
+        qint64                             startSupervised(const SelectedCandidate& candidate, int& handoffFd, QString& error);
+        void                               onProcessExited(int pidfd);
+
+        NowFn                              m_nowFn;
+        StartProcessFn                     m_startProcessFn;
+        ProbeFn                            m_probeFn;
+        FindExecutableFn                   m_findExecutableFn;
+        QHash<QString, RetryState>         m_retryByProvider;
+
+        // Keyed by the exec string as written in the manifest or override
+        QHash<QString, ResolvedExecutable> m_executables;
+        // PATH directories, resolved binaries and where absolute execs would appear
+        QFileSystemWatcher                 m_executableWatcher;
+        QStringList                        m_searchPath;
+        bool                               m_searchPathWatched = false;
+        bool                               m_searchPathChanged = false;
+        bool                               m_executablesStale  = false;
+        std::optional<QProcessEnvironment> m_baseEnvironment;
+        QHash<QString, EnvironmentOverlay> m_environmentByProvider;
 
-        SelectedCandidate          selectCandidate(const QList<ProviderManifest>& manifests, const QString& legacyFallbackPath, const QString& defaultFallbackPath,
-                                                   const QString& socketPath, QString& selectionError) const;
+        // Keyed by pidfd
+        std::unordered_map<int, SupervisedProcess> m_supervised;
+        ExitFn                                     m_exitFn;
 
-        bool                       canAttempt(const QString& id, qint64 nowMs, QString& detail) const;
-        void                       markSuccess(const QString& id);
-        void                       markFailure(const QString& id, qint64 nowMs);
+        std::optional<PendingRegistration>         m_pendingRegistration;
+        qint64                                     m_defaultRegisterDeadlineMs;
 
-        NowFn                      m_nowFn;
-        StartProcessFn             m_startProcessFn;
-        QHash<QString, RetryState> m_retryByProvider;
+        // The built-in fallback racing a slow preferred provider
+        qint64                                     m_hedgeDelayMs = 0;
+        std::optional<PlannedHedge>                m_plannedHedge;
+        std::optional<PendingRegistration>         m_hedgeRegistration;
+        // Pid of a launch that lost the race, and when to stop it if it never registers
+        QHash<qint64, qint64>                      m_supersededDeadlines;
+        // Pid sent SIGTERM, and when SIGKILL follows if it is still running
+        QHash<qint64, qint64>                      m_killDeadlines;
+        // Smoothed launch-to-register time per provider
+        QHash<QString, qint64>                     m_registerLatencyMs;
+        // Slowest recent one, raised by a missed deadline; sets that provider's next deadline
+        QHash<QString, qint64>                     m_registerPeakMs;
     };
 
 } // namespace bb::providers
@@ -10,8 +10,10 @@ namespace bb::providers {
 
     namespace {
 
-        inline constexpr int      PRIORITY_MIN = -1000;
-        inline constexpr int      PRIORITY_MAX = 1000;
+        inline constexpr int      PRIORITY_MIN            = -1000;
+        inline constexpr int      PRIORITY_MAX            = 1000;
+        inline constexpr int      REGISTER_TIMEOUT_MIN_MS = 100;
+        inline constexpr int      REGISTER_TIMEOUT_MAX_MS = 120000;
 
         [[nodiscard]] ParseResult failure(const QString& error) {
             ParseResult result;
@@ -133,6 +135,14 @@ namespace bb::providers {
         }
         manifest.autostart = json.contains("autostart") ? json.value("autostart").toBool() : true;
 
+        if (json.contains("registerTimeoutMs")) {
+            const QJsonValue timeout = json.value("registerTimeoutMs");
+            if (!timeout.isDouble() || timeout.toInt() < REGISTER_TIMEOUT_MIN_MS || timeout.toInt() > REGISTER_TIMEOUT_MAX_MS) {
+                return failure(QStringLiteral("registerTimeoutMs must be an integer within [100, 120000]"));
+            }
+            manifest.registerTimeoutMs = timeout.toInt();
+        }
+
         QString parseError;
         if (!parseStringArray(json.value("args"), manifest.args, QStringLiteral("args"), parseError)) {
             return failure(parseError);
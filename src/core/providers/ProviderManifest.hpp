@@ -18,6 +18,8 @@ namespace bb::providers {
         bool               autostart = true;
         QStringList        capabilities;
         QString            sourcePath;
+        // How long a launch may take to send ui.register; 0 leaves it to the daemon
+        int                registerTimeoutMs = 0;
 
         [[nodiscard]] bool isValid() const;
     };
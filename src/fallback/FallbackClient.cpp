@@ -1,37 +1,25 @@
 #include "FallbackClient.hpp"
+#include "../common/Constants.hpp"
 
 #include <QDateTime>
-#include <QJsonDocument>
-#include <QJsonParseError>
+#include <QJsonArray>
 
 namespace bb {
 
-    FallbackClient::FallbackClient(const QString& socketPath, QObject* parent) : QObject(parent), m_socketPath(socketPath) {
+    FallbackClient::FallbackClient(const QString& socketPath, QObject* parent) : QObject(parent), m_socketPath(socketPath), m_reader(static_cast<qsizetype>(MAX_MESSAGE_SIZE)) {
 
-        connect(&m_socket, &QLocalSocket::connected, this, [this]() {
-            m_reconnectDelayMs = 200;
-            m_subscribed       = false;
-            m_registered       = false;
-            m_providerId.clear();
-            m_pendingProviderActiveKnown = false;
-            m_pendingProviderActive      = false;
-            m_pendingProviderId.clear();
-            setProviderActive(false);
-
-            emit connectionStateChanged(true);
-            emit statusMessage("Connected to auth daemon");
-
-            registerProvider();
-            subscribe();
-        });
+        connect(&m_socket, &QLocalSocket::connected, this, &FallbackClient::onConnected);
 
         connect(&m_socket, &QLocalSocket::disconnected, this, [this]() {
-            m_subscribed = false;
-            m_registered = false;
+            m_subscribed    = false;
+            m_registered    = false;
+            m_preRegistered = false;
             m_providerId.clear();
             m_pendingProviderActiveKnown = false;
             m_pendingProviderActive      = false;
             m_pendingProviderId.clear();
+            m_subscribeWatchdog.stop();
+            m_heartbeatTimer.stop();
             setProviderActive(false);
 
             emit connectionStateChanged(false);
@@ -44,25 +32,26 @@ namespace bb {
         });
 
         connect(&m_socket, &QLocalSocket::readyRead, this, [this]() {
-            m_buffer.append(m_socket.readAll());
+            while (m_socket.bytesAvailable() > 0) {
+                if (m_reader.readFrom(m_socket) <= 0) {
+                    return;
+                }
 
- qsizetype newline = -1;
-            while ((newline = m_buffer.indexOf('\n')) != -1) {
-                QByteArray line = m_buffer.left(newline).trimmed();
-                m_buffer.remove(0, static_cast<qsizetype>(newline + 1));
+                while (const auto frame = m_reader.nextFrame()) {
+                    const auto msg = decodeFrame(frame->payload, frame->encoding);
+                    if (!msg) {
+                        emit statusMessage("Invalid daemon payload");
+                        continue;
+                    }
 
-                if (line.isEmpty()) {
-                    continue;
+                    handleMessage(*msg);
                 }
 
-                QJsonParseError     parseError;
-                const QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
-                if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
-                    emit statusMessage("Invalid daemon payload");
-                    continue;
+                if (m_reader.overflowed()) {
+                    emit statusMessage("Oversized daemon payload");
+                    m_socket.disconnectFromServer();
+                    return;
                 }
-
-                handleMessage(doc.object());
             }
         });
 
@@ -76,8 +65,9 @@ namespace bb {
         m_reconnectTimer.setSingleShot(true);
         connect(&m_reconnectTimer, &QTimer::timeout, this, [this]() { ensureConnected(); });
 
+        // Only armed between connecting and the daemon confirming both; an idle client has no timers
         m_subscribeWatchdog.setInterval(1200);
-        m_subscribeWatchdog.setSingleShot(false);
+        m_subscribeWatchdog.setSingleShot(true);
         connect(&m_subscribeWatchdog, &QTimer::timeout, this, [this]() {
             if (!isConnected()) {
                 return;
@@ -90,8 +80,10 @@ namespace bb {
             if (!m_subscribed) {
                 subscribe();
             }
+            m_subscribeWatchdog.start();
         });
 
+        // Started by ui.registered, and only when the daemon did not accept "quiescent"
         m_heartbeatTimer.setInterval(4000);
         m_heartbeatTimer.setSingleShot(false);
         connect(&m_heartbeatTimer, &QTimer::timeout, this, [this]() {
@@ -104,10 +96,15 @@ namespace bb {
         });
     }
 
+    void FallbackClient::setTimerIntervals(int heartbeatMs, int subscribeWatchdogMs) {
+        m_heartbeatTimer.setInterval(heartbeatMs);
+        m_subscribeWatchdog.setInterval(subscribeWatchdogMs);
+    }
+
     void FallbackClient::start() {
-        m_subscribeWatchdog.start();
-        m_heartbeatTimer.start();
-        ensureConnected();
+        if (!adoptHandoff()) {
+            ensureConnected();
+        }
     }
 
     bool FallbackClient::isConnected() const {
@@ -118,6 +115,14 @@ namespace bb {
         return m_providerActive;
     }
 
+    void FallbackClient::setStandby(bool standby) {
+        m_standby = standby;
+    }
+
+    bool FallbackClient::isStandby() const {
+        return m_standby;
+    }
+
     void FallbackClient::sendResponse(const QString& id, const QString& response) {
         QJsonObject req{{"type", "session.respond"}, {"id", id}, {"response", response}};
         sendJson(req);
@@ -136,19 +141,61 @@ namespace bb {
         m_socket.connectToServer(m_socketPath);
     }
 
+    bool FallbackClient::adoptHandoff() {
+        bool      ok = false;
+        const int fd = qEnvironmentVariableIntValue(PROVIDER_HANDOFF_ENV, &ok);
+        qunsetenv(PROVIDER_HANDOFF_ENV);
+        if (!ok || fd < 0) {
+            return false;
+        }
+
+        // Launched by the daemon over a connection it already registered; ui.registered is waiting on it
+        if (!m_socket.setSocketDescriptor(fd)) {
+            emit statusMessage("Inherited daemon connection unusable, connecting instead");
+            return false;
+        }
+
+        m_preRegistered = true;
+        onConnected();
+        return true;
+    }
+
+    void FallbackClient::onConnected() {
+        m_reconnectDelayMs = 200;
+        m_reader.clear();
+        m_encoding         = FrameEncoding::Json;
+        m_subscribed       = false;
+        m_registered       = false;
+        m_providerId.clear();
+        m_pendingProviderActiveKnown = false;
+        m_pendingProviderActive      = false;
+        m_pendingProviderId.clear();
+        setProviderActive(false);
+
+        emit connectionStateChanged(true);
+        emit statusMessage("Connected to auth daemon");
+
+        if (!m_preRegistered) {
+            registerProvider();
+        }
+        subscribe();
+        m_subscribeWatchdog.start();
+    }
+
     void FallbackClient::sendJson(const QJsonObject& json) {
         if (!isConnected()) {
             return;
         }
 
-        QByteArray payload = QJsonDocument(json).toJson(QJsonDocument::Compact);
-        payload.append('\n');
-        m_socket.write(payload);
+        m_socket.write(encodeFrame(json, m_encoding));
         m_socket.flush();
     }
 
     void FallbackClient::registerProvider() {
-        QJsonObject reg{{"type", "ui.register"}, {"name", "bb-auth-fallback"}, {"kind", "fallback"}, {"priority", 10}};
+        QJsonObject reg{{"type", "ui.register"}, {"name", "bb-auth-fallback"}, {"kind", "fallback"}, {"priority", 10}, {"capabilities", QJsonArray{json::VAL_CBOR, json::VAL_QUIESCENT}}};
+        if (m_standby) {
+            reg["standby"] = true;
+        }
         sendJson(reg);
     }
 
@@ -156,6 +203,12 @@ namespace bb {
         sendJson(QJsonObject{{"type", "subscribe"}});
     }
 
+    void FallbackClient::settleWatchdog() {
+        if (m_registered && m_subscribed) {
+            m_subscribeWatchdog.stop();
+        }
+    }
+
     void FallbackClient::setProviderActive(bool active) {
         const bool changed = (active != m_providerActive);
         if (!changed) {
@@ -163,6 +216,10 @@ namespace bb {
         }
 
         m_providerActive = active;
+        if (m_providerActive) {
+            // Promoted: from here on an ordinary provider, including when it registers again
+            m_standby = false;
+        }
         emit providerStateChanged(m_providerActive);
 
         if (m_providerActive && isConnected() && m_registered) {
@@ -193,6 +250,7 @@ namespace bb {
 
         if (type == "subscribed") {
             m_subscribed = true;
+            settleWatchdog();
             if (msg.contains("active")) {
                 setProviderActive(msg.value("active").toBool());
             }
@@ -202,6 +260,14 @@ namespace bb {
         if (type == "ui.registered") {
             m_registered = true;
             m_providerId = msg.value("id").toString();
+            m_encoding   = msg.value("encoding").toString() == "cbor" ? FrameEncoding::Cbor : FrameEncoding::Json;
+            settleWatchdog();
+            // A daemon that accepted "quiescent" watches the connection instead; older ones still prune without heartbeats
+            if (msg.value(json::KEY_QUIESCENT).toBool()) {
+                m_heartbeatTimer.stop();
+            } else if (!m_heartbeatTimer.isActive()) {
+                m_heartbeatTimer.start();
+            }
             if (msg.contains("active")) {
                 const bool active = msg.value("active").toBool();
                 setProviderActive(active);
@@ -246,10 +312,27 @@ namespace bb {
             return;
         }
 
+        if (type == "ui.shutdown") {
+            if (m_registered) {
+                sendJson(QJsonObject{{"type", "ui.unregister"}, {"id", m_providerId}});
+            }
+            emit statusMessage("Auth daemon asked this provider to exit");
+            emit shutdownRequested();
+            return;
+        }
+
         if (type == "pong") {
             return;
         }
 
+        // The daemon checking a quiescent provider is still responsive before it shows a prompt
+        if (type == json::VAL_UI_PING) {
+            if (m_registered) {
+                sendJson(QJsonObject{{"type", "ui.heartbeat"}, {"id", m_providerId}});
+            }
+            return;
+        }
+
         if (type == "ok") {
             return;
         }
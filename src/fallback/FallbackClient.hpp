@@ -1,6 +1,7 @@
 #pragma once
 
-#include <QByteArray>
+#include "../common/FrameReader.hpp"
+
 #include <QJsonObject>
 #include <QLocalSocket>
 #include <QObject>
@@ -19,6 +20,14 @@ class FallbackClient : public QObject {
     bool isConnected() const;
     bool isActiveProvider() const;
 
+    // How often heartbeats go to a daemon that did not accept "quiescent", and how long the client waits
+    // for ui.registered and subscribed before sending them again
+    void setTimerIntervals(int heartbeatMs, int subscribeWatchdogMs);
+
+    // Registers as a standby provider until the daemon first makes it active
+    void setStandby(bool standby);
+    bool isStandby() const;
+
     void sendResponse(const QString& id, const QString& response);
     void sendCancel(const QString& id);
 
@@ -26,6 +35,8 @@ class FallbackClient : public QObject {
     void connectionStateChanged(bool connected);
     void providerStateChanged(bool active);
     void statusMessage(const QString& status);
+    // The daemon no longer needs this provider, e.g. another one won a hedged launch
+    void shutdownRequested();
 
     void sessionCreated(const QJsonObject& event);
     void sessionUpdated(const QJsonObject& event);
@@ -33,16 +44,20 @@ class FallbackClient : public QObject {
 
   private:
     void ensureConnected();
+    bool adoptHandoff();
+    void onConnected();
     void sendJson(const QJsonObject& json);
     void registerProvider();
     void subscribe();
+    void settleWatchdog();
     void setProviderActive(bool active);
     void applyPendingProviderState();
     void handleMessage(const QJsonObject& msg);
 
     QString      m_socketPath;
     QLocalSocket m_socket;
-    QByteArray   m_buffer;
+    FrameReader  m_reader;
+    FrameEncoding m_encoding = FrameEncoding::Json;
 
     QTimer       m_reconnectTimer;
     QTimer       m_subscribeWatchdog;
@@ -52,6 +67,8 @@ class FallbackClient : public QObject {
     bool         m_subscribed = false;
     bool         m_registered = false;
     bool         m_providerActive = false;
+    bool         m_standby = false;
+    bool         m_preRegistered = false; // connection handed over by the daemon, registered already
     QString      m_providerId;
     bool         m_pendingProviderActiveKnown = false;
     bool         m_pendingProviderActive = false;
@@ -396,6 +396,24 @@ namespace bb {
                 return;
             }
 
+            // The daemon names the requestor after announcing the session. Only the labels derived from it
+            // change; a submit in flight, the error shown and the input state are left alone
+            if (event.contains("requestor")) {
+                m_currentContext.insert("requestor", event.value("requestor"));
+                QJsonObject named{{"source", m_currentSource}, {"context", m_currentContext}};
+                if (const QString prompt = event.value("prompt").toString(); !prompt.isEmpty()) {
+                    named.insert("prompt", prompt);
+                }
+                const PromptDisplayModel model = buildDisplayModel(named);
+                m_titleLabel->setText(model.title);
+                m_summaryLabel->setText(model.summary);
+                m_summaryLabel->setVisible(!model.summary.isEmpty());
+                m_requestorLabel->setText(model.requestor);
+                m_requestorLabel->setVisible(!model.requestor.isEmpty());
+                scheduleEnsureContentFits(0);
+                return;
+            }
+
             const QString prompt = event.value("prompt").toString();
             const QString info   = event.value("info").toString().trimmed();
             const QString source = m_currentSource.isEmpty() ? event.value("source").toString() : m_currentSource;
@@ -821,8 +839,8 @@ namespace bb {
     }
 
     void FallbackWindow::startIdleExitTimer() {
-        // Start countdown to exit when hidden with no active session
-        if (m_idleExitTimer && m_currentSessionId.isEmpty() && !isVisible()) {
+        // Start countdown to exit when hidden with no active session; a standby waits to be promoted
+        if (m_idleExitTimer && m_currentSessionId.isEmpty() && !isVisible() && !(m_client && m_client->isStandby())) {
             m_idleExitTimer->start();
         }
     }
@@ -31,6 +31,8 @@ int main(int argc, char* argv[]) {
 
     QCommandLineOption socketOpt(QStringList{"socket", "s"}, "Override socket path", "path");
     parser.addOption(socketOpt);
+    QCommandLineOption standbyOpt("standby", "Start hidden and wait to be promoted by the daemon");
+    parser.addOption(standbyOpt);
     parser.process(app);
 
     const QString runtimeDir    = qEnvironmentVariable("XDG_RUNTIME_DIR");
@@ -48,7 +50,14 @@ int main(int argc, char* argv[]) {
     }
 
     bb::FallbackClient client(socketPath);
+    client.setStandby(parser.isSet(standbyOpt));
     bb::FallbackWindow window(&client);
+    if (client.isStandby()) {
+        // Pay for style, fonts and the native window now rather than when the prompt is due
+        window.ensurePolished();
+        window.winId();
+    }
+    QObject::connect(&client, &bb::FallbackClient::shutdownRequested, &app, &QCoreApplication::quit, Qt::QueuedConnection);
     client.start();
     const int rc = app.exec();
     fallbackLock.unlock();
@@ -176,32 +176,19 @@ generate_cookie (BbAuthPrompt *self)
                             self->cookie_counter);
 }
 
-/* Thread function for async password prompt */
+/* Completion of the daemon password request */
 static void
-password_request_thread (GTask        *task,
-                         gpointer      source_object,
-                         gpointer      task_data,
-                         GCancellable *cancellable)
+on_password_reply (GObject      *source G_GNUC_UNUSED,
+                   GAsyncResult *result,
+                   gpointer      user_data)
 {
-    BbAuthPrompt *self = BB_AUTH_PROMPT (source_object);
-    (void) task_data;
-    (void) cancellable;
+    g_autoptr(GTask) task = user_data;
+    BbAuthPrompt *self = BB_AUTH_PROMPT (g_task_get_source_object (task));
+    g_autoptr(GError) error = NULL;
     gchar *password = NULL;
     gboolean success;
 
-    g_message ("Thread: Sending keyring password request: cookie=%s",
-               self->request_cookie);
-
-    /* Send request to bb-auth - this blocks until user responds */
-    success = bb_auth_ipc_send_keyring_request (
-        self->request_cookie,
-        self->title ? self->title : "Unlock Keyring",
-        self->message ? self->message : "Password required",
-        self->description,
-        self->warning,
-        self->password_new,
-        &password
-    );
+    success = bb_auth_ipc_send_keyring_request_finish (result, &password, &error);
 
     if (g_task_return_error_if_cancelled (task)) {
         g_free (password);
@@ -212,12 +199,13 @@ password_request_thread (GTask        *task,
         g_free (self->password);
         self->password = password;
         self->cancelled = FALSE;
-        g_message ("Thread: Keyring request successful");
+        g_message ("Async: Keyring request successful");
         g_task_return_pointer (task, (gpointer)self->password, NULL);
     } else {
         self->cancelled = TRUE;
         g_free (password);
-        g_message ("Thread: Keyring request cancelled or failed");
+        g_message ("Async: Keyring request cancelled or failed%s%s",
+                   error ? ": " : "", error ? error->message : "");
         g_task_return_pointer (task, NULL, NULL);
     }
 }
@@ -244,9 +232,18 @@ bb_auth_prompt_password_async (GcrPrompt          *prompt,
                self->message ? self->message : "(null)",
                self->warning ? self->warning : "(null)");
 
-    /* Run the blocking IPC in a thread to not block the main loop */
-    g_task_run_in_thread (task, password_request_thread);
-    g_object_unref (task);
+    /* Completes from the main loop once the user answered; task is released by the callback */
+    bb_auth_ipc_send_keyring_request_async (
+        self->request_cookie,
+        self->title ? self->title : "Unlock Keyring",
+        self->message ? self->message : "Password required",
+        self->description,
+        self->warning,
+        self->password_new,
+        cancellable,
+        on_password_reply,
+        task
+    );
 }
 
 static const gchar *
@@ -259,28 +256,16 @@ bb_auth_prompt_password_finish (GcrPrompt    *prompt,
     return g_task_propagate_pointer (G_TASK (result), error);
 }
 
-/* Thread function for async confirm prompt */
+/* Completion of the daemon confirm request */
 static void
-confirm_request_thread (GTask        *task,
-                        gpointer      source_object,
-                        gpointer      task_data,
-                        GCancellable *cancellable)
+on_confirm_reply (GObject      *source G_GNUC_UNUSED,
+                  GAsyncResult *result,
+                  gpointer      user_data)
 {
-    BbAuthPrompt *self = BB_AUTH_PROMPT (source_object);
-    (void) task_data;
-    (void) cancellable;
+    g_autoptr(GTask) task = user_data;
     gboolean confirmed;
 
-    g_message ("Thread: Sending keyring confirm request: cookie=%s",
-               self->request_cookie);
-
-    /* Send confirm request to bb-auth */
-    confirmed = bb_auth_ipc_send_confirm_request (
-        self->request_cookie,
-        self->title ? self->title : "Confirm",
-        self->message ? self->message : "Please confirm",
-        self->description
-    );
+    confirmed = bb_auth_ipc_send_confirm_request_finish (result, NULL);
 
     if (g_task_return_error_if_cancelled (task))
         return;
@@ -308,9 +293,15 @@ bb_auth_prompt_confirm_async (GcrPrompt          *prompt,
                self->request_cookie,
                self->title ? self->title : "(null)");
 
-    /* Run the blocking IPC in a thread to not block the main loop */
-    g_task_run_in_thread (task, confirm_request_thread);
-    g_object_unref (task);
+    bb_auth_ipc_send_confirm_request_async (
+        self->request_cookie,
+        self->title ? self->title : "Confirm",
+        self->message ? self->message : "Please confirm",
+        self->description,
+        cancellable,
+        on_confirm_reply,
+        task
+    );
 }
 
 static GcrPromptReply
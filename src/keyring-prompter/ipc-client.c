@@ -1,12 +1,39 @@
 #include "ipc-client.h"
 
-#include <gio/gio.h>
 #include <gio/gunixsocketaddress.h>
 #include <json-glib/json-glib.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+/* A request waiting for its reply; task is NULL when nobody waits for it */
+typedef struct {
+    gint64  request_id;
+    gchar  *cookie;
+    GTask  *task;
+} PendingRequest;
+
+/* One queued line being written; owns its bytes until the write finished */
+typedef struct {
+    guint   generation;
+    GBytes *bytes;
+} WriteOp;
+
+static struct {
+    GSocketConnection *connection;
+    GDataInputStream  *input;
+    GCancellable      *read_cancellable;
+    guint              generation;   /* bumped per connection; stale callbacks compare against it */
+    gboolean           reading;
+    gboolean           writing;
+    GQueue             write_queue;  /* GBytes, one line each */
+    GQueue             pending;      /* PendingRequest, oldest first */
+    gint64             next_request_id;
+} ipc = { .next_request_id = 1 };
+
+static void read_next_line (void);
+static void write_next_line (void);
+
 static gchar *
 get_socket_path (void)
 {
@@ -28,6 +55,7 @@ connect_to_socket (void)
     client = g_socket_client_new ();
     address = g_unix_socket_address_new (socket_path);
 
+    /* A local socket connects or fails at once; no need to go async here */
     connection = g_socket_client_connect (client,
                                           G_SOCKET_CONNECTABLE (address),
                                           NULL, &error);
@@ -41,69 +69,318 @@ connect_to_socket (void)
     return connection;
 }
 
-static gchar *
-send_json_command (const gchar *json_request)
+static void
+pending_request_free (PendingRequest *request)
 {
-    g_autoptr(GSocketConnection) connection = NULL;
-    GOutputStream *output;
-    GInputStream *input;
-    g_autoptr(GDataInputStream) data_input = NULL;
-    GError *error = NULL;
-    g_autofree gchar *request = NULL;
-    gchar *line = NULL;
+    g_free (request->cookie);
+    g_clear_object (&request->task);
+    g_free (request);
+}
+
+static void
+close_connection (const gchar *reason)
+{
+    GQueue failed = ipc.pending;
+    PendingRequest *request;
+
+    if (ipc.read_cancellable) {
+        g_cancellable_cancel (ipc.read_cancellable);
+        g_clear_object (&ipc.read_cancellable);
+    }
+
+    if (ipc.connection) {
+        g_debug ("Closing daemon connection: %s", reason);
+        g_socket_close (g_socket_connection_get_socket (ipc.connection), NULL);
+    }
+
+    g_clear_object (&ipc.input);
+    g_clear_object (&ipc.connection);
+    g_queue_clear_full (&ipc.write_queue, (GDestroyNotify) g_bytes_unref);
+    ipc.generation++;
+    ipc.reading = FALSE;
+    ipc.writing = FALSE;
+
+    /* Detached first; a callback may already send a new request */
+    g_queue_init (&ipc.pending);
+    while ((request = g_queue_pop_head (&failed)) != NULL) {
+        if (request->task)
+            g_task_return_new_error (request->task, G_IO_ERROR, G_IO_ERROR_CLOSED, "%s", reason);
+        pending_request_free (request);
+    }
+}
+
+static gboolean
+ensure_connection (void)
+{
+    if (ipc.connection && !ipc.reading) {
+        /* Idle since the last exchange; notice a daemon that went away meanwhile */
+        GSocket *socket = g_socket_connection_get_socket (ipc.connection);
+        if (g_socket_condition_check (socket, G_IO_IN | G_IO_HUP | G_IO_ERR) != 0)
+            close_connection ("daemon hung up");
+    }
+
+    if (ipc.connection)
+        return TRUE;
 
-    connection = connect_to_socket ();
-    if (!connection)
+    ipc.connection = connect_to_socket ();
+    if (!ipc.connection)
+        return FALSE;
+
+    ipc.input = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM (ipc.connection)));
+    g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (ipc.input), FALSE);
+    ipc.read_cancellable = g_cancellable_new ();
+    ipc.generation++;
+
+    return TRUE;
+}
+
+/* Match by the echoed requestId, else by cookie; a daemon without
+ * requestId support answers a connection's requests in order */
+static PendingRequest *
+take_pending_for_reply (JsonObject *reply)
+{
+    GList *link = NULL;
+
+    if (json_object_has_member (reply, "requestId")) {
+        gint64 request_id = json_object_get_int_member (reply, "requestId");
+
+        for (GList *l = ipc.pending.head; l != NULL; l = l->next) {
+            if (((PendingRequest *) l->data)->request_id == request_id) {
+                link = l;
+                break;
+            }
+        }
+    } else {
+        const gchar *cookie = json_object_get_string_member_with_default (reply, "id", NULL);
+
+        for (GList *l = ipc.pending.head; cookie && l != NULL; l = l->next) {
+            if (g_strcmp0 (((PendingRequest *) l->data)->cookie, cookie) == 0) {
+                link = l;
+                break;
+            }
+        }
+
+        if (!link)
+            link = ipc.pending.head;
+    }
+
+    if (!link)
         return NULL;
 
-    output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
-    input = g_io_stream_get_input_stream (G_IO_STREAM (connection));
-    data_input = g_data_input_stream_new (input);
+    PendingRequest *request = link->data;
+    g_queue_delete_link (&ipc.pending, link);
+    return request;
+}
 
-    request = g_strdup_printf ("%s\n", json_request);
+static void
+dispatch_reply (const gchar *line)
+{
+    g_autoptr(JsonParser) parser = NULL;
+    GError *error = NULL;
 
-    if (!g_output_stream_write_all (output, request, strlen (request),
-                                    NULL, NULL, &error)) {
-        g_debug ("Failed to write command: %s", error->message);
+    parser = json_parser_new ();
+    if (!json_parser_load_from_data (parser, line, -1, &error)) {
+        g_warning ("Failed to parse daemon reply: %s", error->message);
         g_error_free (error);
-        return NULL;
+        return;
+    }
+
+    JsonNode *root = json_parser_get_root (parser);
+    if (!JSON_NODE_HOLDS_OBJECT (root))
+        return;
+
+    JsonObject *reply = json_node_get_object (root);
+    PendingRequest *request = take_pending_for_reply (reply);
+    if (!request) {
+        g_debug ("Dropping reply that matches no request");
+        return;
     }
 
-    line = g_data_input_stream_read_line (data_input, NULL, NULL, &error);
+    if (request->task)
+        g_task_return_pointer (request->task, json_object_ref (reply), (GDestroyNotify) json_object_unref);
+    pending_request_free (request);
+}
+
+static void
+on_line_read (GObject      *source,
+              GAsyncResult *result,
+              gpointer      user_data)
+{
+    g_autoptr(GError) error = NULL;
+    g_autofree gchar *line = NULL;
+
+    line = g_data_input_stream_read_line_finish (G_DATA_INPUT_STREAM (source), result, NULL, &error);
+
+    /* The connection was replaced while this read was outstanding */
+    if (GPOINTER_TO_UINT (user_data) != ipc.generation)
+        return;
+
+    ipc.reading = FALSE;
+
     if (!line) {
-        g_debug ("Failed to read response: %s", error->message);
-        g_error_free (error);
-        return NULL;
+        close_connection (error ? error->message : "bb-auth daemon closed the connection");
+        return;
+    }
+
+    dispatch_reply (line);
+    read_next_line ();
+}
+
+static void
+read_next_line (void)
+{
+    if (ipc.reading || !ipc.input)
+        return;
+
+    /* Kept outstanding while connected, so a daemon hangup is noticed at once */
+    ipc.reading = TRUE;
+    g_data_input_stream_read_line_async (ipc.input, G_PRIORITY_DEFAULT, ipc.read_cancellable,
+                                         on_line_read, GUINT_TO_POINTER (ipc.generation));
+}
+
+static void
+on_line_written (GObject      *source,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+    WriteOp *op = user_data;
+    g_autoptr(GError) error = NULL;
+    gboolean stale = op->generation != ipc.generation;
+
+    g_output_stream_write_all_finish (G_OUTPUT_STREAM (source), result, NULL, &error);
+    g_bytes_unref (op->bytes);
+    g_free (op);
+
+    if (stale)
+        return;
+
+    ipc.writing = FALSE;
+
+    if (error) {
+        close_connection (error->message);
+        return;
     }
 
-    return line;
+    write_next_line ();
+}
+
+static void
+write_next_line (void)
+{
+    WriteOp *op;
+    gsize size;
+    gconstpointer data;
+
+    if (ipc.writing || !ipc.connection || g_queue_is_empty (&ipc.write_queue))
+        return;
+
+    op = g_new0 (WriteOp, 1);
+    op->generation = ipc.generation;
+    op->bytes = g_queue_pop_head (&ipc.write_queue);
+    data = g_bytes_get_data (op->bytes, &size);
+
+    ipc.writing = TRUE;
+    g_output_stream_write_all_async (g_io_stream_get_output_stream (G_IO_STREAM (ipc.connection)),
+                                     data, size, G_PRIORITY_DEFAULT, NULL,
+                                     on_line_written, op);
+}
+
+static JsonBuilder *
+begin_request (const gchar *type)
+{
+    JsonBuilder *builder = json_builder_new ();
+
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "type");
+    json_builder_add_string_value (builder, type);
+
+    return builder;
+}
+
+static gchar *
+end_request (JsonBuilder *builder)
+{
+    g_autoptr(JsonGenerator) generator = NULL;
+    g_autoptr(JsonNode) root = NULL;
+
+    json_builder_end_object (builder);
+
+    root = json_builder_get_root (builder);
+    generator = json_generator_new ();
+    json_generator_set_root (generator, root);
+    return json_generator_to_data (generator, NULL);
+}
+
+/* Tag the request, queue it on the shared connection and make sure its reply gets read */
+static void
+send_request (JsonBuilder *builder,
+              const gchar *cookie,
+              GTask       *task)
+{
+    g_autofree gchar *json_str = NULL;
+    PendingRequest *request;
+    gchar *line;
+
+    if (!ensure_connection ()) {
+        if (task)
+            g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_CONNECTED, "Failed to connect to bb-auth.socket");
+        return;
+    }
+
+    request = g_new0 (PendingRequest, 1);
+    request->request_id = ipc.next_request_id++;
+    request->cookie = g_strdup (cookie);
+    request->task = task ? g_object_ref (task) : NULL;
+    g_queue_push_tail (&ipc.pending, request);
+
+    json_builder_set_member_name (builder, "requestId");
+    json_builder_add_int_value (builder, request->request_id);
+    json_str = end_request (builder);
+
+    line = g_strconcat (json_str, "\n", NULL);
+    g_queue_push_tail (&ipc.write_queue, g_bytes_new_take (line, strlen (line)));
+
+    write_next_line ();
+    read_next_line ();
 }
 
 gboolean
 bb_auth_ipc_ping (void)
 {
     g_autoptr(JsonBuilder) builder = NULL;
-    g_autoptr(JsonGenerator) generator = NULL;
-    g_autoptr(JsonNode) root = NULL;
     g_autofree gchar *json_str = NULL;
+    g_autofree gchar *request = NULL;
     g_autofree gchar *response = NULL;
     g_autoptr(JsonParser) parser = NULL;
     GError *error = NULL;
 
-    builder = json_builder_new ();
-    json_builder_begin_object (builder);
-    json_builder_set_member_name (builder, "type");
-    json_builder_add_string_value (builder, "ping");
-    json_builder_end_object (builder);
+    /* A live connection with reads outstanding already proves the daemon is there */
+    if (ipc.reading)
+        return TRUE;
 
-    root = json_builder_get_root (builder);
-    generator = json_generator_new ();
-    json_generator_set_root (generator, root);
-    json_str = json_generator_to_data (generator, NULL);
+    if (!ensure_connection ())
+        return FALSE;
 
-    response = send_json_command (json_str);
-    if (!response)
+    builder = begin_request ("ping");
+    json_str = end_request (builder);
+    request = g_strdup_printf ("%s\n", json_str);
+
+    /* Runs before the main loop; the connection is kept for the prompts that follow */
+    if (!g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (ipc.connection)),
+                                    request, strlen (request), NULL, NULL, &error)) {
+        g_debug ("Failed to write command: %s", error->message);
+        close_connection (error->message);
+        g_error_free (error);
+        return FALSE;
+    }
+
+    response = g_data_input_stream_read_line (ipc.input, NULL, NULL, &error);
+    if (!response) {
+        g_debug ("Failed to read response: %s", error ? error->message : "end of stream");
+        close_connection ("no ping response");
+        g_clear_error (&error);
         return FALSE;
+    }
 
     parser = json_parser_new ();
     if (!json_parser_load_from_data (parser, response, -1, &error)) {
@@ -124,31 +401,25 @@ bb_auth_ipc_ping (void)
     return type && g_strcmp0 (type, "pong") == 0;
 }
 
-gboolean
-bb_auth_ipc_send_keyring_request (const gchar *cookie,
-                                   const gchar *title,
-                                   const gchar *message,
-                                   const gchar *description,
-                                   const gchar *warning,
-                                   gboolean     password_new,
-                                   gchar      **out_password)
+void
+bb_auth_ipc_send_keyring_request_async (const gchar        *cookie,
+                                        const gchar        *title,
+                                        const gchar        *message,
+                                        const gchar        *description,
+                                        const gchar        *warning,
+                                        gboolean            password_new,
+                                        GCancellable       *cancellable,
+                                        GAsyncReadyCallback callback,
+                                        gpointer            user_data)
 {
-    GError *error = NULL;
     g_autoptr(JsonBuilder) builder = NULL;
-    g_autoptr(JsonGenerator) generator = NULL;
-    g_autoptr(JsonNode) root = NULL;
-    g_autofree gchar *json_str = NULL;
-    g_autofree gchar *response = NULL;
-    g_autoptr(JsonParser) parser = NULL;
+    g_autoptr(GTask) task = NULL;
 
-    *out_password = NULL;
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, bb_auth_ipc_send_keyring_request_async);
 
     /* Build JSON payload */
-    builder = json_builder_new ();
-    json_builder_begin_object (builder);
-
-    json_builder_set_member_name (builder, "type");
-    json_builder_add_string_value (builder, "keyring_request");
+    builder = begin_request ("keyring_request");
 
     json_builder_set_member_name (builder, "cookie");
     json_builder_add_string_value (builder, cookie);
@@ -175,31 +446,24 @@ bb_auth_ipc_send_keyring_request (const gchar *cookie,
     json_builder_set_member_name (builder, "confirm_only");
     json_builder_add_boolean_value (builder, FALSE);
 
-    json_builder_end_object (builder);
+    send_request (builder, cookie, task);
+}
 
-    root = json_builder_get_root (builder);
-    generator = json_generator_new ();
-    json_generator_set_root (generator, root);
-    json_str = json_generator_to_data (generator, NULL);
+gboolean
+bb_auth_ipc_send_keyring_request_finish (GAsyncResult *result,
+                                         gchar       **out_password,
+                                         GError      **error)
+{
+    g_autoptr(JsonObject) resp_obj = NULL;
 
-    response = send_json_command (json_str);
-    if (!response) {
-        g_warning ("Failed to connect to bb-auth.socket");
-        return FALSE;
-    }
+    *out_password = NULL;
 
-    parser = json_parser_new ();
-    if (!json_parser_load_from_data (parser, response, -1, &error)) {
-        g_warning ("Failed to parse keyring response: %s", error->message);
-        g_error_free (error);
-        return FALSE;
-    }
+    g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
 
-    JsonNode *resp_root = json_parser_get_root (parser);
-    if (!JSON_NODE_HOLDS_OBJECT (resp_root))
+    resp_obj = g_task_propagate_pointer (G_TASK (result), error);
+    if (!resp_obj)
         return FALSE;
 
-    JsonObject *resp_obj = json_node_get_object (resp_root);
     if (!json_object_has_member (resp_obj, "type"))
         return FALSE;
 
@@ -210,8 +474,8 @@ bb_auth_ipc_send_keyring_request (const gchar *cookie,
     if (!json_object_has_member (resp_obj, "result"))
         return FALSE;
 
-    const gchar *result = json_object_get_string_member (resp_obj, "result");
-    if (result && g_strcmp0 (result, "ok") == 0) {
+    const gchar *result_str = json_object_get_string_member (resp_obj, "result");
+    if (result_str && g_strcmp0 (result_str, "ok") == 0) {
         if (!json_object_has_member (resp_obj, "password"))
             return FALSE;
 
@@ -223,35 +487,32 @@ bb_auth_ipc_send_keyring_request (const gchar *cookie,
         return FALSE;
     }
 
-    if (result && g_strcmp0 (result, "cancelled") == 0) {
+    if (result_str && g_strcmp0 (result_str, "cancelled") == 0) {
         g_debug ("Keyring request cancelled by user");
         return FALSE;
     }
 
-    g_warning ("Unexpected response from bb-auth: %s", response);
+    g_warning ("Unexpected keyring result from bb-auth: %s", result_str ? result_str : "(null)");
     return FALSE;
 }
 
-gboolean
-bb_auth_ipc_send_confirm_request (const gchar *cookie,
-                                   const gchar *title,
-                                   const gchar *message,
-                                   const gchar *description)
+void
+bb_auth_ipc_send_confirm_request_async (const gchar        *cookie,
+                                        const gchar        *title,
+                                        const gchar        *message,
+                                        const gchar        *description,
+                                        GCancellable       *cancellable,
+                                        GAsyncReadyCallback callback,
+                                        gpointer            user_data)
 {
-    GError *error = NULL;
     g_autoptr(JsonBuilder) builder = NULL;
-    g_autoptr(JsonGenerator) generator = NULL;
-    g_autoptr(JsonNode) root = NULL;
-    g_autofree gchar *json_str = NULL;
-    g_autofree gchar *response = NULL;
-    g_autoptr(JsonParser) parser = NULL;
+    g_autoptr(GTask) task = NULL;
 
-    /* Build JSON payload */
-    builder = json_builder_new ();
-    json_builder_begin_object (builder);
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, bb_auth_ipc_send_confirm_request_async);
 
-    json_builder_set_member_name (builder, "type");
-    json_builder_add_string_value (builder, "keyring_request");
+    /* Build JSON payload */
+    builder = begin_request ("keyring_request");
 
     json_builder_set_member_name (builder, "cookie");
     json_builder_add_string_value (builder, cookie);
@@ -270,29 +531,21 @@ bb_auth_ipc_send_confirm_request (const gchar *cookie,
     json_builder_set_member_name (builder, "confirm_only");
     json_builder_add_boolean_value (builder, TRUE);
 
-    json_builder_end_object (builder);
-
-    root = json_builder_get_root (builder);
-    generator = json_generator_new ();
-    json_generator_set_root (generator, root);
-    json_str = json_generator_to_data (generator, NULL);
+    send_request (builder, cookie, task);
+}
 
-    response = send_json_command (json_str);
-    if (!response)
-        return FALSE;
+gboolean
+bb_auth_ipc_send_confirm_request_finish (GAsyncResult *result,
+                                         GError      **error)
+{
+    g_autoptr(JsonObject) resp_obj = NULL;
 
-    parser = json_parser_new ();
-    if (!json_parser_load_from_data (parser, response, -1, &error)) {
-        g_warning ("Failed to parse confirm response: %s", error->message);
-        g_error_free (error);
-        return FALSE;
-    }
+    g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
 
-    JsonNode *resp_root = json_parser_get_root (parser);
-    if (!JSON_NODE_HOLDS_OBJECT (resp_root))
+    resp_obj = g_task_propagate_pointer (G_TASK (result), error);
+    if (!resp_obj)
         return FALSE;
 
-    JsonObject *resp_obj = json_node_get_object (resp_root);
     if (!json_object_has_member (resp_obj, "type"))
         return FALSE;
 
@@ -303,32 +556,25 @@ bb_auth_ipc_send_confirm_request (const gchar *cookie,
     if (!json_object_has_member (resp_obj, "result"))
         return FALSE;
 
-    const gchar *result = json_object_get_string_member (resp_obj, "result");
-    return result && g_strcmp0 (result, "confirmed") == 0;
+    const gchar *result_str = json_object_get_string_member (resp_obj, "result");
+    return result_str && g_strcmp0 (result_str, "confirmed") == 0;
 }
 
 void
 bb_auth_ipc_send_cancel (const gchar *cookie)
 {
     g_autoptr(JsonBuilder) builder = NULL;
-    g_autoptr(JsonGenerator) generator = NULL;
-    g_autoptr(JsonNode) root = NULL;
-    g_autofree gchar *json_str = NULL;
-    g_autofree gchar *response = NULL;
 
-    builder = json_builder_new ();
-    json_builder_begin_object (builder);
-    json_builder_set_member_name (builder, "type");
-    json_builder_add_string_value (builder, "session.cancel");
+    builder = begin_request ("session.cancel");
     json_builder_set_member_name (builder, "id");
     json_builder_add_string_value (builder, cookie);
-    json_builder_end_object (builder);
 
-    root = json_builder_get_root (builder);
-    generator = json_generator_new ();
-    json_generator_set_root (generator, root);
-    json_str = json_generator_to_data (generator, NULL);
+    /* Best effort; the reply is read and dropped */
+    send_request (builder, cookie, NULL);
+}
 
-    response = send_json_command (json_str);
-    /* Ignore response - best effort cancel */
+void
+bb_auth_ipc_shutdown (void)
+{
+    close_connection ("shutting down");
 }
@@ -1,34 +1,55 @@
 #ifndef __IPC_CLIENT_H__
 #define __IPC_CLIENT_H__
 
-#include <glib.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
-/* Check if bb-auth socket is available */
+/* All calls share one daemon connection, opened on first use and
+ * reopened after the daemon went away. Requests are written and replies
+ * read asynchronously from the main loop, so it stays responsive while a
+ * prompt is open. */
+
+/* Check if bb-auth socket is available
+ * Blocks; call before the main loop runs */
 gboolean bb_auth_ipc_ping (void);
 
-/* Send a keyring password request, blocks until response received
- * Returns TRUE on success with password in out_password (caller must free)
+/* Send a keyring password request; callback runs once the user answered */
+void bb_auth_ipc_send_keyring_request_async (const gchar        *cookie,
+                                             const gchar        *title,
+                                             const gchar        *message,
+                                             const gchar        *description,
+                                             const gchar        *warning,
+                                             gboolean            password_new,
+                                             GCancellable       *cancellable,
+                                             GAsyncReadyCallback callback,
+                                             gpointer            user_data);
+
+/* Returns TRUE on success with password in out_password (caller must free)
  * Returns FALSE on cancel or error */
-gboolean bb_auth_ipc_send_keyring_request (const gchar *cookie,
-                                            const gchar *title,
-                                            const gchar *message,
-                                            const gchar *description,
-                                            const gchar *warning,
-                                            gboolean     password_new,
-                                            gchar      **out_password);
-
-/* Send a confirm request, blocks until response
- * Returns TRUE if confirmed, FALSE if cancelled */
-gboolean bb_auth_ipc_send_confirm_request (const gchar *cookie,
-                                            const gchar *title,
-                                            const gchar *message,
-                                            const gchar *description);
-
-/* Send cancel for a pending request */
+gboolean bb_auth_ipc_send_keyring_request_finish (GAsyncResult *result,
+                                                  gchar       **out_password,
+                                                  GError      **error);
+
+/* Send a confirm request; callback runs once the user answered */
+void bb_auth_ipc_send_confirm_request_async (const gchar        *cookie,
+                                             const gchar        *title,
+                                             const gchar        *message,
+                                             const gchar        *description,
+                                             GCancellable       *cancellable,
+                                             GAsyncReadyCallback callback,
+                                             gpointer            user_data);
+
+/* Returns TRUE if confirmed, FALSE if cancelled */
+gboolean bb_auth_ipc_send_confirm_request_finish (GAsyncResult *result,
+                                                  GError      **error);
+
+/* Send cancel for a pending request; does not wait for the reply */
 void bb_auth_ipc_send_cancel (const gchar *cookie);
 
+/* Close the connection; pending requests fail with G_IO_ERROR_CLOSED */
+void bb_auth_ipc_shutdown (void);
+
 G_END_DECLS
 
 #endif /* __IPC_CLIENT_H__ */
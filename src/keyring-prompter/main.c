@@ -164,6 +164,9 @@ int bb_auth_keyring_main(int argc G_GNUC_UNUSED, char* argv[]) {
     if (registered)
         gcr_system_prompter_unregister(the_prompter, TRUE);
 
+    /* After unregistering, which may still send cancels for open prompts */
+    bb_auth_ipc_shutdown();
+
     g_object_unref(the_prompter);
     g_main_loop_unref(main_loop);
 
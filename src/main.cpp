@@ -83,15 +83,15 @@ namespace {
             return modes::runPinentry();
         }
 
-        // CLI commands for interacting with daemon
+        // CLI commands for interacting with daemon; the connection is opened on first use
+        bb::IpcClient client(socketPath);
+
         if (parser.isSet(optPing)) {
-            bb::IpcClient client(socketPath);
             return client.ping() ? 0 : 1;
         }
 
         if (parser.isSet(optNext)) {
-            bb::IpcClient client(socketPath);
-            auto          response = client.sendRequest(QJsonObject{{"type", "next"}}, 1000);
+            auto response = client.sendRequest(QJsonObject{{"type", "next"}}, 1000);
             if (response) {
                 const auto out = QJsonDocument(*response).toJson(QJsonDocument::Compact);
                 fprintf(stdout, "%s\n", out.constData());
@@ -104,16 +104,14 @@ namespace {
             QTextStream   stdinStream(stdin);
             const QString password = stdinStream.readLine();
 
-            bb::IpcClient client(socketPath);
-            auto          response = client.sendRequest(QJsonObject{{"type", "session.respond"}, {"id", cookie}, {"response", password}}, 1000);
+            auto response = client.sendRequest(QJsonObject{{"type", "session.respond"}, {"id", cookie}, {"response", password}}, 1000);
             return (response && response->value("type").toString() == "ok") ? 0 : 1;
         }
 
         if (parser.isSet(optCancel)) {
             const QString cookie = parser.value(optCancel);
 
-            bb::IpcClient client(socketPath);
-            auto          response = client.sendRequest(QJsonObject{{"type", "session.cancel"}, {"id", cookie}}, 1000);
+            auto response = client.sendRequest(QJsonObject{{"type", "session.cancel"}, {"id", cookie}}, 1000);
             return (response && response->value("type").toString() == "ok") ? 0 : 1;
         }
 
@@ -100,6 +100,7 @@ namespace {
 
       private:
         PinentryState state;
+        bb::IpcClient client{bb::socketPath()}; // one daemon connection for the whole Assuan session
         QString       flowCookie;
         bool          awaitingTerminalResult = false;
 
@@ -143,8 +144,7 @@ namespace {
                 return;
             }
 
-            bb::IpcClient client(bb::socketPath());
-            QJsonObject   request;
+            QJsonObject request;
             request["type"]   = "pinentry_result";
             request["id"]     = flowCookie;
             request["result"] = result;
@@ -361,8 +361,6 @@ namespace {
         }
 
         bool requestPasswordFromDaemon(QString& password) {
-            bb::IpcClient client(bb::socketPath());
-
             const QString cookie = ensureFlowCookie();
 
             // Build request JSON
@@ -414,8 +412,6 @@ namespace {
         }
 
         bool requestConfirmFromDaemon() {
-            bb::IpcClient client(bb::socketPath());
-
             const QString cookie = ensureFlowCookie();
 
             QJsonObject   request;
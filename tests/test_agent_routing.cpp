@@ -4,6 +4,8 @@
 
 #include <QtTest/QtTest>
 
+#include <QJsonArray>
+#include <QJsonDocument>
 #include <QLocalServer>
 #include <QLocalSocket>
 #include <QTemporaryDir>
@@ -88,8 +90,8 @@ namespace bb {
             QString       type;
         };
 
-        inline QJsonObject makeEvent(const QString& type) {
-            return QJsonObject{{"type", type}};
+        inline EncodedEvent makeEvent(const QString& type) {
+            return EncodedEvent(QJsonObject{{"type", type}});
         }
 
     } // namespace
@@ -103,6 +105,10 @@ namespace bb {
         void providerRegistry_unregActiveRecomputes();
         void providerRegistry_heartbeatUnknownReturnsFalse();
         void providerRegistry_prunesStaleAndDisconnected();
+        void providerRegistry_standbyWaitsForPromotion();
+        void providerRegistry_nextExpiryTracksOldestHeartbeat();
+        void providerRegistry_quiescentProviderExpiresOnlyOnMissedProbe();
+        void providerRegistry_launchSlotWaitsForConfirmation();
 
         void eventQueue_dropsOldestAtCapacity();
         void eventQueue_drainsWaitersInFifoOrder();
@@ -111,6 +117,7 @@ namespace bb {
         void eventRouter_routesSessionEventsToActiveProviderOnly();
         void eventRouter_broadcastsSessionEventsWhenNoActiveProvider();
         void eventRouter_broadcastsNonSessionEventsEvenWithActiveProvider();
+        void eventRouter_fanOutSharesSingleEncoding();
     };
 
     void AgentRoutingTest::providerRegistry_selectsHighestPriority() {
@@ -255,6 +262,144 @@ namespace bb {
         QCOMPARE(registry.activeProvider(), nullptr);
     }
 
+    void AgentRoutingTest::providerRegistry_standbyWaitsForPromotion() {
+        LocalSocketFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+
+        qint64                  nowMs = 1000;
+        agent::ProviderRegistry registry([&nowMs] { return nowMs; });
+
+        ConnectedSocket         standby = fixture.connect();
+        QVERIFY(standby.server != nullptr);
+
+        const auto info = registry.registerProvider(standby.server.get(), QJsonObject{{"name", "bb-auth-fallback"}, {"kind", "fallback"}, {"standby", true}});
+        QVERIFY(info.standby);
+        QVERIFY(!registry.recomputeActiveProvider());
+        QVERIFY(!registry.hasActiveProvider());
+        QVERIFY(registry.contains(standby.server.get()));
+
+        QCOMPARE(registry.promoteStandby(), standby.server.get());
+        QVERIFY(registry.recomputeActiveProvider());
+        QCOMPARE(registry.activeProvider(), standby.server.get());
+
+        // Only one standby to promote
+        QCOMPARE(registry.promoteStandby(), nullptr);
+    }
+
+    void AgentRoutingTest::providerRegistry_nextExpiryTracksOldestHeartbeat() {
+        LocalSocketFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+
+        qint64                  nowMs = 1000;
+        agent::ProviderRegistry registry([&nowMs] { return nowMs; });
+        QVERIFY(!registry.nextExpiryMs());
+
+        ConnectedSocket a = fixture.connect();
+        QVERIFY(a.server != nullptr);
+        ConnectedSocket b = fixture.connect();
+        QVERIFY(b.server != nullptr);
+
+        registry.registerProvider(a.server.get(), QJsonObject{{"name", "a"}, {"kind", "a"}, {"priority", 50}});
+        nowMs = 4000;
+        registry.registerProvider(b.server.get(), QJsonObject{{"name", "b"}, {"kind", "b"}, {"priority", 60}});
+        QCOMPARE(registry.nextExpiryMs(), std::optional<qint64>(16001));
+
+        // A heartbeat moves its deadline; the one it replaced is skipped
+        nowMs = 8000;
+        QVERIFY(registry.heartbeat(a.server.get()));
+        QCOMPARE(registry.nextExpiryMs(), std::optional<qint64>(19001));
+
+        // Stale exactly at the deadline, not a maintenance tick later
+        nowMs = 19000;
+        registry.recomputeActiveProvider();
+        QVERIFY(registry.contains(b.server.get()));
+        nowMs = 19001;
+        registry.recomputeActiveProvider();
+        QVERIFY(!registry.contains(b.server.get()));
+        QCOMPARE(registry.nextExpiryMs(), std::optional<qint64>(23001));
+
+        QVERIFY(registry.unregisterProvider(a.server.get()));
+        QVERIFY(!registry.nextExpiryMs());
+    }
+
+    void AgentRoutingTest::providerRegistry_quiescentProviderExpiresOnlyOnMissedProbe() {
+        LocalSocketFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+
+        qint64                  nowMs = 1000;
+        agent::ProviderRegistry registry([&nowMs] { return nowMs; });
+
+        ConnectedSocket         a = fixture.connect();
+        QVERIFY(a.server != nullptr);
+
+        const auto provider = registry.registerProvider(a.server.get(), QJsonObject{{"name", "a"}, {"kind", "a"}, {"capabilities", QJsonArray{"cbor", "quiescent"}}});
+        QVERIFY(provider.quiescent);
+        QVERIFY(!registry.nextExpiryMs());
+
+        // Kept by its connection alone, however long it stays silent
+        nowMs = 1000 + 3600 * 1000;
+        registry.recomputeActiveProvider();
+        QCOMPARE(registry.activeProvider(), a.server.get());
+
+        // Registering again without the capability puts it back on heartbeats
+        registry.registerProvider(a.server.get(), QJsonObject{{"name", "a"}, {"kind", "a"}});
+        QCOMPARE(registry.nextExpiryMs(), std::optional<qint64>(nowMs + 15001));
+        registry.registerProvider(a.server.get(), QJsonObject{{"name", "a"}, {"kind", "a"}, {"capabilities", QJsonArray{"quiescent"}}});
+        QVERIFY(!registry.nextExpiryMs());
+
+        // Probed before a prompt: a heartbeat in time clears the deadline
+        QVERIFY(registry.probe(a.server.get()));
+        QVERIFY(!registry.probe(a.server.get()));
+        QCOMPARE(registry.nextExpiryMs(), std::optional<qint64>(nowMs + 5000));
+        nowMs += 4999;
+        QVERIFY(registry.heartbeat(a.server.get()));
+        QVERIFY(!registry.nextExpiryMs());
+
+        // A hung provider misses it and is pruned at the deadline
+        QVERIFY(registry.probe(a.server.get()));
+        nowMs += 4999;
+        registry.recomputeActiveProvider();
+        QVERIFY(registry.contains(a.server.get()));
+        nowMs += 1;
+        QVERIFY(registry.recomputeActiveProvider());
+        QVERIFY(!registry.contains(a.server.get()));
+        QVERIFY(!registry.nextExpiryMs());
+
+        // Otherwise only its connection closing removes it
+        registry.registerProvider(a.server.get(), QJsonObject{{"name", "a"}, {"kind", "a"}, {"capabilities", QJsonArray{"quiescent"}}});
+        a.server->abort();
+        registry.recomputeActiveProvider();
+        QVERIFY(!registry.contains(a.server.get()));
+    }
+
+    void AgentRoutingTest::providerRegistry_launchSlotWaitsForConfirmation() {
+        LocalSocketFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+
+        qint64                  nowMs = 1000;
+        agent::ProviderRegistry registry([&nowMs] { return nowMs; });
+
+        ConnectedSocket         preferred = fixture.connect();
+        QVERIFY(preferred.server != nullptr);
+        ConnectedSocket hedge = fixture.connect();
+        QVERIFY(hedge.server != nullptr);
+
+        // A pre-registered launch slot outranks nothing until its provider speaks
+        QVERIFY(registry.registerProvider(preferred.server.get(), QJsonObject{{"name", "preferred"}, {"priority", 100}}, true).awaitingLaunch);
+        QVERIFY(!registry.recomputeActiveProvider());
+        QVERIFY(!registry.hasActiveProvider());
+
+        registry.registerProvider(hedge.server.get(), QJsonObject{{"name", "bb-auth-fallback"}, {"kind", "fallback"}, {"priority", 10}}, true);
+        QVERIFY(registry.confirmLaunch(hedge.server.get()));
+        QVERIFY(!registry.confirmLaunch(hedge.server.get()));
+        QVERIFY(registry.recomputeActiveProvider());
+        QCOMPARE(registry.activeProvider(), hedge.server.get());
+
+        QVERIFY(registry.confirmLaunch(preferred.server.get()));
+        QVERIFY(registry.recomputeActiveProvider());
+        QCOMPARE(registry.activeProvider(), preferred.server.get());
+    }
+
     void AgentRoutingTest::eventQueue_dropsOldestAtCapacity() {
         agent::EventQueue queue(2);
 
@@ -262,8 +407,8 @@ namespace bb {
         queue.enqueue(makeEvent("e2"));
         queue.enqueue(makeEvent("e3"));
 
-        QCOMPARE(queue.takeNext().value("type").toString(), QString("e2"));
-        QCOMPARE(queue.takeNext().value("type").toString(), QString("e3"));
+        QCOMPARE(queue.takeNext().type(), QString("e2"));
+        QCOMPARE(queue.takeNext().type(), QString("e3"));
         QVERIFY(queue.takeNext().isEmpty());
     }
 
@@ -285,7 +430,7 @@ namespace bb {
         queue.enqueue(makeEvent("e2"));
 
         std::vector<SentEvent> sent;
-        queue.drainToWaiters([&sent](QLocalSocket* socket, const QJsonObject& event) { sent.push_back(SentEvent{socket, event.value("type").toString()}); });
+        queue.drainToWaiters([&sent](QLocalSocket* socket, const EncodedEvent& event) { sent.push_back(SentEvent{socket, event.type()}); });
 
         QCOMPARE(sent.size(), static_cast<size_t>(2));
         QCOMPARE(sent[0].socket, w1.server.get());
@@ -303,7 +448,7 @@ namespace bb {
 
         queue.enqueue(makeEvent("e3"));
         sent.clear();
-        queue.drainToWaiters([&sent](QLocalSocket* socket, const QJsonObject& event) { sent.push_back(SentEvent{socket, event.value("type").toString()}); });
+        queue.drainToWaiters([&sent](QLocalSocket* socket, const EncodedEvent& event) { sent.push_back(SentEvent{socket, event.type()}); });
 
         QCOMPARE(sent.size(), static_cast<size_t>(1));
         QCOMPARE(sent[0].socket, w3.server.get());
@@ -311,7 +456,7 @@ namespace bb {
 
         queue.enqueue(makeEvent("e4"));
         sent.clear();
-        queue.drainToWaiters([&sent](QLocalSocket* socket, const QJsonObject& event) { sent.push_back(SentEvent{socket, event.value("type").toString()}); });
+        queue.drainToWaiters([&sent](QLocalSocket* socket, const EncodedEvent& event) { sent.push_back(SentEvent{socket, event.type()}); });
 
         QCOMPARE(sent.size(), static_cast<size_t>(1));
         QCOMPARE(sent[0].socket, w2.server.get());
@@ -332,7 +477,7 @@ namespace bb {
         queue.enqueue(makeEvent("e1"));
 
         std::vector<SentEvent> sent;
-        queue.drainToWaiters([&sent](QLocalSocket* socket, const QJsonObject& event) { sent.push_back(SentEvent{socket, event.value("type").toString()}); });
+        queue.drainToWaiters([&sent](QLocalSocket* socket, const EncodedEvent& event) { sent.push_back(SentEvent{socket, event.type()}); });
 
         QVERIFY(sent.empty());
     }
@@ -370,7 +515,7 @@ namespace bb {
         std::vector<SentEvent>     sent;
         const QList<QLocalSocket*> subscribers{sub1.server.get(), sub2.server.get()};
         router.route(makeEvent("session.created"), subscribers,
-                     [&sent](QLocalSocket* socket, const QJsonObject& event) { sent.push_back(SentEvent{socket, event.value("type").toString()}); });
+                     [&sent](QLocalSocket* socket, const EncodedEvent& event) { sent.push_back(SentEvent{socket, event.type()}); });
 
         QCOMPARE(sent.size(), static_cast<size_t>(2));
         QCOMPARE(sent[0].socket, provider.server.get());
@@ -402,7 +547,7 @@ namespace bb {
         std::vector<SentEvent>     sent;
         const QList<QLocalSocket*> subscribers{sub1.server.get(), sub2.server.get()};
         router.route(makeEvent("session.updated"), subscribers,
-                     [&sent](QLocalSocket* socket, const QJsonObject& event) { sent.push_back(SentEvent{socket, event.value("type").toString()}); });
+                     [&sent](QLocalSocket* socket, const EncodedEvent& event) { sent.push_back(SentEvent{socket, event.type()}); });
 
         QCOMPARE(sent.size(), static_cast<size_t>(3));
         QCOMPARE(sent[0].socket, sub1.server.get());
@@ -442,7 +587,7 @@ namespace bb {
         std::vector<SentEvent>     sent;
         const QList<QLocalSocket*> subscribers{sub1.server.get(), sub2.server.get()};
         router.route(makeEvent("ui.active"), subscribers,
-                     [&sent](QLocalSocket* socket, const QJsonObject& event) { sent.push_back(SentEvent{socket, event.value("type").toString()}); });
+                     [&sent](QLocalSocket* socket, const EncodedEvent& event) { sent.push_back(SentEvent{socket, event.type()}); });
 
         QCOMPARE(sent.size(), static_cast<size_t>(3));
         QCOMPARE(sent[0].socket, sub1.server.get());
@@ -453,6 +598,38 @@ namespace bb {
         QVERIFY(std::none_of(sent.begin(), sent.end(), [&](const SentEvent& e) { return e.socket == provider.server.get(); }));
     }
 
+    void AgentRoutingTest::eventRouter_fanOutSharesSingleEncoding() {
+        LocalSocketFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+
+        qint64                  nowMs = 0;
+        agent::ProviderRegistry registry([&nowMs] { return nowMs; });
+        agent::EventQueue       queue(10);
+        agent::EventRouter      router(registry, queue);
+
+        ConnectedSocket         sub1 = fixture.connect();
+        QVERIFY(sub1.server != nullptr);
+
+        ConnectedSocket sub2 = fixture.connect();
+        QVERIFY(sub2.server != nullptr);
+
+        ConnectedSocket waiter = fixture.connect();
+        QVERIFY(waiter.server != nullptr);
+
+        queue.subscribeNext(waiter.server.get());
+
+        const EncodedEvent         event(QJsonObject{{"type", "session.updated"}, {"id", "cookie-1"}, {"prompt", "Password:"}});
+        QList<QByteArray>          frames;
+        const QList<QLocalSocket*> subscribers{sub1.server.get(), sub2.server.get()};
+        router.route(event, subscribers, [&frames](QLocalSocket*, const EncodedEvent& routed) { frames.push_back(routed.frame()); });
+
+        QCOMPARE(frames.size(), 3);
+        QCOMPARE(frames[0], QJsonDocument(event.json()).toJson(QJsonDocument::Compact) + '\n');
+        for (const QByteArray& frame : frames) {
+            QVERIFY(frame.isSharedWith(event.frame()));
+        }
+    }
+
 } // namespace bb
 
 int runAgentRoutingTests(int argc, char** argv) {
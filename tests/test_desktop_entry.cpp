@@ -0,0 +1,286 @@
+#include "../src/core/DesktopEntry.hpp"
+#include "../src/core/DesktopIndex.hpp"
+
+#include <QtTest/QtTest>
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QTemporaryDir>
+
+namespace bb {
+
+    namespace {
+
+        inline constexpr int SYNTHETIC_FILE_COUNT = 5000;
+
+        // Shapes of files shipped by distributions, Flatpak, Steam and hand-written launchers
+        const QList<std::pair<const char*, QByteArray>>& corpus() {
+            static const QList<std::pair<const char*, QByteArray>> files{
+                {"firefox.desktop",
+                 "[Desktop Entry]\n"
+                 "Version=1.0\n"
+                 "Name=Firefox\n"
+                 "Name[de]=Firefox Webbrowser\n"
+                 "GenericName=Web Browser\n"
+                 "Comment=Browse the World Wide Web\n"
+                 "Keywords=Internet;WWW;Browser;Web;Explorer;\n"
+                 "Exec=firefox %u\n"
+                 "Icon=firefox\n"
+                 "Terminal=false\n"
+                 "Type=Application\n"
+                 "MimeType=text/html;text/xml;application/xhtml+xml;x-scheme-handler/http;x-scheme-handler/https;\n"
+                 "StartupNotify=true\n"
+                 "Categories=Network;WebBrowser;\n"
+                 "Actions=new-window;new-private-window;\n"
+                 "\n"
+                 "[Desktop Action new-window]\n"
+                 "Name=New Window\n"
+                 "Exec=firefox --new-window %u\n"
+                 "\n"
+                 "[Desktop Action new-private-window]\n"
+                 "Name=New Private Window\n"
+                 "Exec=firefox --private-window %u\n"},
+                {"code.desktop",
+                 "[Desktop Entry]\n"
+                 "Name=Visual Studio Code\n"
+                 "Comment=Code Editing. Redefined.\n"
+                 "GenericName=Text Editor\n"
+                 "Exec=/usr/share/code/code --unity-launch %F\n"
+                 "Icon=vscode\n"
+                 "Type=Application\n"
+                 "StartupNotify=false\n"
+                 "StartupWMClass=Code\n"
+                 "Categories=TextEditor;Development;IDE;\n"
+                 "MimeType=text/plain;inode/directory;application/x-code-workspace;\n"
+                 "Keywords=vscode;\n"},
+                {"steam.desktop",
+                 "[Desktop Entry]\n"
+                 "Name=Steam\n"
+                 "Comment=Application for managing and playing games on Steam\n"
+                 "Exec=/usr/bin/steam %U\n"
+                 "Icon=steam\n"
+                 "Terminal=false\n"
+                 "Type=Application\n"
+                 "Categories=Network;FileTransfer;Game;\n"
+                 "MimeType=x-scheme-handler/steam;x-scheme-handler/steamlink;\n"
+                 "PrefersNonDefaultGPU=true\n"
+                 "X-KDE-RunOnDiscreteGpu=true\n"},
+                {"com.spotify.Client.desktop",
+                 "[Desktop Entry]\n"
+                 "Type=Application\n"
+                 "Name=Spotify\n"
+                 "GenericName=Music Player\n"
+                 "Icon=com.spotify.Client\n"
+                 "TryExec=spotify\n"
+                 "Exec=/usr/bin/flatpak run --branch=stable --arch=x86_64 --command=spotify --file-forwarding com.spotify.Client @@u %U @@\n"
+                 "Terminal=false\n"
+                 "MimeType=x-scheme-handler/spotify;\n"
+                 "Categories=Audio;Music;Player;AudioVideo;\n"
+                 "StartupWMClass=spotify\n"
+                 "X-Flatpak=com.spotify.Client\n"},
+                {"my-app.desktop",
+                 "#!/usr/bin/env xdg-open\n"
+                 "# Written by hand\n"
+                 "[Desktop Entry]\n"
+                 "Name = My App\n"
+                 "Exec=\"/opt/My App/bin/my-app\" --flag %U\n"
+                 "Icon=/opt/My App/share/icon.png\n"
+                 "Type=Application\n"},
+                {"org.gnome.Terminal.desktop",
+                 "[Desktop Entry]\n"
+                 "Name=Terminal\n"
+                 "Comment=Use the command line\n"
+                 "TryExec=gnome-terminal\n"
+                 "Exec=gnome-terminal --window\n"
+                 "Icon=org.gnome.Terminal\n"
+                 "Type=Application\n"
+                 "NoDisplay=false\n"
+                 "DBusActivatable=true\n"},
+                {"xdg-handler.desktop",
+                 "[Desktop Entry]\n"
+                 "Name=URL Handler\n"
+                 "Exec=xdg-handler %u\n"
+                 "Type=Application\n"
+                 "NoDisplay=true\n"
+                 "MimeType=x-scheme-handler/example;\n"},
+                {"mimeinfo-helper.desktop",
+                 "[Desktop Entry]\n"
+                 "Name=Helper\n"
+                 "Exec=helper\n"
+                 "NoDisplay=True\n"},
+                {"windows.desktop",
+                 "\xEF\xBB\xBF[Desktop Entry]\r\n"
+                 "Name=Notepad\r\n"
+                 "Exec=env WINEPREFIX=/home/user/.wine wine notepad.exe\r\n"
+                 "Icon=wine-notepad\r\n"
+                 "Type=Application\r\n"},
+                {"localized-only.desktop",
+                 "[Desktop Entry]\n"
+                 "Name[fr]=Seulement localisé\n"
+                 "Exec=localized\n"
+                 "Type=Application\n"},
+                {"website.desktop",
+                 "[Desktop Entry]\n"
+                 "Type=Link\n"
+                 "Name=Project Website\n"
+                 "URL=https://example.org/\n"
+                 "Icon=text-html\n"},
+                {"no-group.desktop", "Name=Outside\nExec=outside\n"},
+            };
+            return files;
+        }
+
+        // Previous DesktopIndex reader, kept as the parity reference and benchmark baseline
+        std::optional<DesktopInfo> readWithQSettings(const QString& file) {
+            QSettings settings(file, QSettings::IniFormat);
+            settings.beginGroup("Desktop Entry");
+
+            if (settings.value("NoDisplay", false).toBool())
+                return std::nullopt;
+
+            DesktopInfo d;
+            d.desktopId = QFileInfo(file).fileName();
+            d.name      = settings.value("Name").toString();
+            d.iconName  = settings.value("Icon").toString();
+            d.exec      = settings.value("Exec").toString().split(' ').first().remove('"');
+            d.tryExec   = settings.value("TryExec").toString();
+
+            if (d.name.isEmpty())
+                return std::nullopt;
+            return d;
+        }
+
+        bool writeFile(const QString& path, const QByteArray& contents) {
+            QFile file(path);
+            return file.open(QIODevice::WriteOnly) && file.write(contents) == contents.size();
+        }
+
+        bool writeSyntheticTree(const QString& dir) {
+            for (int i = 0; i < SYNTHETIC_FILE_COUNT; ++i) {
+                const auto& [name, contents] = corpus().at(i % corpus().size());
+                if (!writeFile(dir + "/" + QString::number(i) + "-" + QString::fromLatin1(name), contents))
+                    return false;
+            }
+            return true;
+        }
+
+    } // namespace
+
+    class DesktopEntryTest : public QObject {
+        Q_OBJECT
+
+      private slots:
+        void matchesQSettingsOnCorpus();
+        void readsOnlyTheDesktopEntryGroup();
+        void decodesSpecEscapes();
+        void keepsCommasInValues();
+        void rejectsOversizedAndMissingFiles();
+        void benchmark_scanWithParser();
+        void benchmark_scanWithQSettings();
+    };
+
+    void DesktopEntryTest::matchesQSettingsOnCorpus() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        for (const auto& [name, contents] : corpus()) {
+            const QString path = dir.filePath(QString::fromLatin1(name));
+            QVERIFY(writeFile(path, contents));
+
+            const auto expected = readWithQSettings(path);
+            const auto actual   = readDesktopEntry(path);
+            QVERIFY2(actual.has_value() == expected.has_value(), name);
+            if (!expected)
+                continue;
+
+            QCOMPARE(actual->desktopId, expected->desktopId);
+            QCOMPARE(actual->name, expected->name);
+            QCOMPARE(actual->iconName, expected->iconName);
+            QCOMPARE(actual->exec, expected->exec);
+            QCOMPARE(actual->tryExec, expected->tryExec);
+        }
+    }
+
+    void DesktopEntryTest::readsOnlyTheDesktopEntryGroup() {
+        const auto entry = parseDesktopEntry("[Desktop Entry]\nName=Files\nExec=nautilus --new-window %U\n\n"
+                                             "[Desktop Action new-window]\nName=New Window\nExec=nautilus-other\nTryExec=other\n",
+                                             "org.gnome.Nautilus.desktop");
+        QVERIFY(entry.has_value());
+        QCOMPARE(entry->desktopId, QStringLiteral("org.gnome.Nautilus.desktop"));
+        QCOMPARE(entry->name, QStringLiteral("Files"));
+        QCOMPARE(entry->exec, QStringLiteral("nautilus"));
+        QVERIFY(entry->tryExec.isEmpty());
+
+        QVERIFY(!parseDesktopEntry("[Other Group]\nName=Elsewhere\n", "other.desktop").has_value());
+    }
+
+    void DesktopEntryTest::decodesSpecEscapes() {
+        const auto entry = parseDesktopEntry("[Desktop Entry]\nName=Tab\\tSeparated\\sName\\\\\nIcon=icon\\s\n", "escaped.desktop");
+        QVERIFY(entry.has_value());
+        QCOMPARE(entry->name, QStringLiteral("Tab\tSeparated Name\\"));
+        QCOMPARE(entry->iconName, QStringLiteral("icon "));
+    }
+
+    void DesktopEntryTest::keepsCommasInValues() {
+        // QSettings read this as a list and returned an empty Name, dropping the entry
+        const auto entry = parseDesktopEntry("[Desktop Entry]\nName=Photos, Videos and Music\nExec=media\n", "media.desktop");
+        QVERIFY(entry.has_value());
+        QCOMPARE(entry->name, QStringLiteral("Photos, Videos and Music"));
+    }
+
+    void DesktopEntryTest::rejectsOversizedAndMissingFiles() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        QVERIFY(writeFile(dir.filePath("huge.desktop"), "[Desktop Entry]\nName=Huge\n" + QByteArray(2 * 1024 * 1024, '#')));
+        QVERIFY(!readDesktopEntry(dir.filePath("huge.desktop")).has_value());
+        QVERIFY(!readDesktopEntry(dir.filePath("missing.desktop")).has_value());
+
+        QVERIFY(writeFile(dir.filePath("empty.desktop"), {}));
+        QVERIFY(!readDesktopEntry(dir.filePath("empty.desktop")).has_value());
+    }
+
+    void DesktopEntryTest::benchmark_scanWithParser() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QVERIFY(writeSyntheticTree(dir.path()));
+
+        qsizetype entries = 0;
+        QBENCHMARK {
+            entries = DesktopIndex::scan({dir.path()}).size();
+        }
+
+        QVERIFY(entries > 0);
+    }
+
+    void DesktopEntryTest::benchmark_scanWithQSettings() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QVERIFY(writeSyntheticTree(dir.path()));
+
+        qsizetype entries = 0;
+        QBENCHMARK {
+            QList<DesktopInfo> list;
+            QDirIterator       it(dir.path(), QStringList() << "*.desktop", QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                if (auto d = readWithQSettings(it.next())) {
+                    list << *d;
+                }
+            }
+            entries = DesktopIndex(std::move(list)).size();
+        }
+
+        QVERIFY(entries > 0);
+    }
+
+} // namespace bb
+
+int runDesktopEntryTests(int argc, char** argv) {
+    bb::DesktopEntryTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "test_desktop_entry.moc"
@@ -0,0 +1,403 @@
+#include "../src/core/DesktopIndex.hpp"
+#include "../src/core/DesktopIndexWatcher.hpp"
+
+#include <QtTest/QtTest>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+namespace bb {
+
+    namespace {
+
+        inline constexpr int SYNTHETIC_ENTRY_COUNT = 5000;
+
+        DesktopInfo          entry(const QString& id, const QString& name, const QString& exec = {}, const QString& tryExec = {}) {
+            DesktopInfo d;
+            d.desktopId = id;
+            d.name      = name;
+            d.exec      = exec;
+            d.tryExec   = tryExec;
+            return d;
+        }
+
+        DesktopInfo syntheticEntry(int i) {
+            const QString n = QString::number(i);
+            return entry("org.example.App" + n + ".desktop", "Example App " + n, "/usr/bin/example-app-" + n, "/usr/libexec/example-helper-" + n);
+        }
+
+        bool writeDesktopFile(const QString& path, const QByteArray& body) {
+            QFile file(path);
+            if (!file.open(QIODevice::WriteOnly))
+                return false;
+            return file.write("[Desktop Entry]\n" + body) != -1;
+        }
+
+        bool setModificationTime(const QString& path, const QDateTime& time) {
+            QFile file(path);
+            return file.open(QIODevice::ReadWrite) && file.setFileTime(time, QFileDevice::FileModificationTime);
+        }
+
+        // One query per match tier plus a miss, spread over the whole entry range
+        QStringList benchmarkQueries() {
+            QStringList queries;
+            for (int i = 0; i < SYNTHETIC_ENTRY_COUNT; i += 97) {
+                const QString n = QString::number(i);
+                queries << "/usr/bin/org.example.App" + n << "ORG.EXAMPLE.APP" + n << "/opt/x/example-app-" + n << "example-helper-" + n << "example app " + n
+                        << "/usr/bin/unknown-" + n;
+            }
+            return queries;
+        }
+
+        // Previous RequestContextHelper::findDesktopForExe, kept as the comparison baseline
+        DesktopInfo linearFind(const QList<DesktopInfo>& index, const QString& exePath) {
+            QString base = QFileInfo(exePath).fileName();
+            for (const auto& d : index) {
+                if (d.desktopId == base + ".desktop")
+                    return d;
+            }
+            for (const auto& d : index) {
+                if (d.desktopId.compare(base + ".desktop", Qt::CaseInsensitive) == 0)
+                    return d;
+            }
+            for (const auto& d : index) {
+                if (!d.exec.isEmpty() && QFileInfo(d.exec).fileName() == base)
+                    return d;
+            }
+            for (const auto& d : index) {
+                if (!d.tryExec.isEmpty() && QFileInfo(d.tryExec).fileName() == base)
+                    return d;
+            }
+            for (const auto& d : index) {
+                if (d.name.compare(base, Qt::CaseInsensitive) == 0)
+                    return d;
+            }
+            return {};
+        }
+
+    } // namespace
+
+    class DesktopIndexTest : public QObject {
+        Q_OBJECT
+
+      private slots:
+        void exactIdWinsOverCaseInsensitiveId();
+        void idWinsOverExecAndName();
+        void execWinsOverTryExec();
+        void nameMatchesCaseInsensitively();
+        void firstEntryWinsWithinTier();
+        void unknownExeReturnsEmpty();
+        void matchesLinearScanOnSyntheticEntries();
+        void scanSkipsHiddenAndNamelessEntries();
+        void snapshotRoundTripsEntriesAndStamps();
+        void snapshotRejectsCorruptFiles();
+        void stampsTrackNewDirectories();
+        void updateRereadsOnlyChangedFiles();
+        void updateLeavesOtherDirectoriesAlone();
+        void watcherCoalescesBurst();
+        void watcherPicksUpLateRootAndSubdirectories();
+        void benchmark_lookupFiveThousandEntries();
+        void benchmark_linearScanFiveThousandEntries();
+    };
+
+    void DesktopIndexTest::exactIdWinsOverCaseInsensitiveId() {
+        const DesktopIndex index({entry("Foo.desktop", "Upper"), entry("foo.desktop", "Lower")});
+
+        QCOMPARE(index.find(u"/usr/bin/foo").name, QStringLiteral("Lower"));
+        QCOMPARE(index.find(u"/usr/bin/Foo").name, QStringLiteral("Upper"));
+        QCOMPARE(index.find(u"/usr/bin/FOO").name, QStringLiteral("Upper"));
+    }
+
+    void DesktopIndexTest::idWinsOverExecAndName() {
+        const DesktopIndex index({entry("other.desktop", "editor", "/usr/bin/editor"), entry("editor.desktop", "Editor by id")});
+
+        QCOMPARE(index.find(u"/usr/bin/editor").desktopId, QStringLiteral("editor.desktop"));
+    }
+
+    void DesktopIndexTest::execWinsOverTryExec() {
+        const DesktopIndex index({entry("a.desktop", "By TryExec", {}, "/usr/bin/tool"), entry("b.desktop", "By Exec", "tool")});
+
+        QCOMPARE(index.find(u"/opt/tool").name, QStringLiteral("By Exec"));
+    }
+
+    void DesktopIndexTest::nameMatchesCaseInsensitively() {
+        const DesktopIndex index({entry("org.gnome.Files.desktop", "Nautilus", "/usr/bin/nautilus-wrapper")});
+
+        QCOMPARE(index.find(u"nautilus").desktopId, QStringLiteral("org.gnome.Files.desktop"));
+    }
+
+    void DesktopIndexTest::firstEntryWinsWithinTier() {
+        const DesktopIndex index({entry("first.desktop", "First", "/usr/bin/shared"), entry("second.desktop", "Second", "/usr/local/bin/shared")});
+
+        QCOMPARE(index.find(u"shared").desktopId, QStringLiteral("first.desktop"));
+    }
+
+    void DesktopIndexTest::unknownExeReturnsEmpty() {
+        const DesktopIndex index({entry("foo.desktop", "Foo", "/usr/bin/foo")});
+
+        QVERIFY(index.find(u"/usr/bin/bar").desktopId.isEmpty());
+        QVERIFY(index.find(u"").desktopId.isEmpty());
+        QVERIFY(DesktopIndex().find(u"foo").desktopId.isEmpty());
+    }
+
+    void DesktopIndexTest::matchesLinearScanOnSyntheticEntries() {
+        QList<DesktopInfo> entries;
+        for (int i = 0; i < 500; ++i) {
+            entries << syntheticEntry(i);
+        }
+        const DesktopIndex index(entries);
+
+        for (const auto& query : benchmarkQueries()) {
+            QCOMPARE(index.find(query).desktopId, linearFind(entries, query).desktopId);
+        }
+    }
+
+    void DesktopIndexTest::scanSkipsHiddenAndNamelessEntries() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QVERIFY(QDir(dir.path()).mkdir("nested"));
+        QVERIFY(writeDesktopFile(dir.filePath("shown.desktop"), "Name=Shown\nExec=\"/usr/bin/shown\" %U\nIcon=shown\n"));
+        QVERIFY(writeDesktopFile(dir.filePath("nested/deep.desktop"), "Name=Deep\nTryExec=/usr/bin/deep\n"));
+        QVERIFY(writeDesktopFile(dir.filePath("hidden.desktop"), "Name=Hidden\nNoDisplay=true\n"));
+        QVERIFY(writeDesktopFile(dir.filePath("nameless.desktop"), "Exec=nameless\n"));
+        QVERIFY(writeDesktopFile(dir.filePath("ignored.txt"), "Name=Ignored\n"));
+
+        const DesktopIndex index = DesktopIndex::scan({dir.path()});
+
+        QCOMPARE(index.size(), 2);
+        QCOMPARE(index.find(u"/usr/bin/shown").iconName, QStringLiteral("shown"));
+        QCOMPARE(index.find(u"/usr/bin/shown").exec, QStringLiteral("/usr/bin/shown"));
+        QCOMPARE(index.find(u"deep").desktopId, QStringLiteral("deep.desktop"));
+        QVERIFY(index.find(u"hidden").desktopId.isEmpty());
+        QVERIFY(index.find(u"nameless").desktopId.isEmpty());
+    }
+
+    void DesktopIndexTest::snapshotRoundTripsEntriesAndStamps() {
+        QTemporaryDir apps;
+        QTemporaryDir state;
+        QVERIFY(apps.isValid() && state.isValid());
+        QVERIFY(writeDesktopFile(apps.filePath("first.desktop"), "Name=First\nExec=/usr/bin/shared\nTryExec=/usr/bin/first\n"));
+        QVERIFY(writeDesktopFile(apps.filePath("second.desktop"), "Name=Second\nExec=shared\n"));
+        QVERIFY(writeDesktopFile(apps.filePath("hidden.desktop"), "Name=Hidden\nNoDisplay=true\n"));
+
+        const DesktopIndex                  index = DesktopIndex::scan({apps.path()});
+        const DesktopIndex::DirectoryStamps stamps{{"/usr/share/applications", 1234567890123456789}, {"/missing", -1}};
+        const QString                       path = state.filePath("desktop-index.bin");
+        QVERIFY(index.saveSnapshot(path, stamps));
+
+        DesktopIndex::DirectoryStamps loadedStamps;
+        const auto                    loaded = DesktopIndex::loadSnapshot(path, &loadedStamps);
+        QVERIFY(loaded.has_value());
+        QVERIFY(loadedStamps == stamps);
+        QCOMPARE(loaded->size(), 2);
+        QCOMPARE(loaded->find(u"shared").desktopId, QStringLiteral("first.desktop"));
+        QCOMPARE(loaded->find(u"first").tryExec, QStringLiteral("/usr/bin/first"));
+
+        // Source files survive the round trip, so a loaded snapshot can be updated in place
+        QVERIFY(writeDesktopFile(apps.filePath("third.desktop"), "Name=Third\n"));
+        const DesktopIndex updated = loaded->updated({apps.path()});
+        QCOMPARE(updated.size(), 3);
+        QCOMPARE(updated.find(u"third").name, QStringLiteral("Third"));
+    }
+
+    void DesktopIndexTest::snapshotRejectsCorruptFiles() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        const QString path = dir.filePath("desktop-index.bin");
+        QVERIFY(DesktopIndex({entry("foo.desktop", "Foo")}).saveSnapshot(path, {}));
+
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        const QByteArray valid = file.readAll();
+        file.close();
+
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(valid.left(valid.size() - 3));
+        file.close();
+        QVERIFY(!DesktopIndex::loadSnapshot(path).has_value());
+
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(valid + "trailing");
+        file.close();
+        QVERIFY(!DesktopIndex::loadSnapshot(path).has_value());
+
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write("not a snapshot");
+        file.close();
+        QVERIFY(!DesktopIndex::loadSnapshot(path).has_value());
+
+        QVERIFY(!DesktopIndex::loadSnapshot(dir.filePath("missing.bin")).has_value());
+    }
+
+    void DesktopIndexTest::stampsTrackNewDirectories() {
+        QTemporaryDir dir;
+        QTemporaryDir other;
+        QVERIFY(dir.isValid() && other.isValid());
+        const QString missing = other.filePath("later");
+
+        const auto    before = DesktopIndex::directoryStamps({dir.path(), missing});
+        QCOMPARE(before.size(), 2);
+        QVERIFY(before.at(0).second >= 0);
+        QCOMPARE(before.at(1).second, qint64(-1));
+        QVERIFY(DesktopIndex::directoryStamps({dir.path(), missing}) == before);
+
+        QVERIFY(QDir().mkpath(missing));
+        QVERIFY(QDir(dir.path()).mkdir("nested"));
+        const auto after = DesktopIndex::directoryStamps({dir.path(), missing});
+        QCOMPARE(after.size(), 3);
+        QCOMPARE(after.at(1).first, dir.filePath("nested"));
+        QVERIFY(after.at(2).second >= 0);
+        QVERIFY(after != before);
+    }
+
+    void DesktopIndexTest::updateRereadsOnlyChangedFiles() {
+        QTemporaryDir apps;
+        QVERIFY(apps.isValid());
+        QVERIFY(QDir(apps.path()).mkdir("nested"));
+
+        const QDateTime past = QDateTime::currentDateTime().addSecs(-3600);
+        QVERIFY(writeDesktopFile(apps.filePath("kept.desktop"), "Name=Kept\n"));
+        QVERIFY(setModificationTime(apps.filePath("kept.desktop"), past));
+        QVERIFY(writeDesktopFile(apps.filePath("edited.desktop"), "Name=Before\n"));
+        QVERIFY(setModificationTime(apps.filePath("edited.desktop"), past));
+        QVERIFY(writeDesktopFile(apps.filePath("removed.desktop"), "Name=Removed\n"));
+
+        const DesktopIndex before = DesktopIndex::scan({apps.path()});
+        QCOMPARE(before.size(), 3);
+
+        // Same modification time: the parsed entry is reused without reading the file
+        QVERIFY(writeDesktopFile(apps.filePath("kept.desktop"), "Name=Rewritten\n"));
+        QVERIFY(setModificationTime(apps.filePath("kept.desktop"), past));
+        QVERIFY(writeDesktopFile(apps.filePath("edited.desktop"), "Name=After\n"));
+        QVERIFY(setModificationTime(apps.filePath("edited.desktop"), past.addSecs(60)));
+        QVERIFY(QFile::remove(apps.filePath("removed.desktop")));
+        QVERIFY(writeDesktopFile(apps.filePath("nested/added.desktop"), "Name=Added\n"));
+
+        const DesktopIndex after = before.updated({apps.path()});
+        QCOMPARE(after.size(), 3);
+        QCOMPARE(after.find(u"kept").name, QStringLiteral("Kept"));
+        QCOMPARE(after.find(u"edited").name, QStringLiteral("After"));
+        QVERIFY(!after.find(u"removed").isValid());
+        QCOMPARE(after.find(u"added").name, QStringLiteral("Added"));
+    }
+
+    void DesktopIndexTest::updateLeavesOtherDirectoriesAlone() {
+        QTemporaryDir user;
+        QTemporaryDir system;
+        QVERIFY(user.isValid() && system.isValid());
+        QVERIFY(writeDesktopFile(user.filePath("editor.desktop"), "Name=User Editor\n"));
+        QVERIFY(writeDesktopFile(system.filePath("editor.desktop"), "Name=System Editor\n"));
+        QVERIFY(writeDesktopFile(system.filePath("viewer.desktop"), "Name=Viewer\n"));
+
+        const DesktopIndex before = DesktopIndex::scan({user.path(), system.path()});
+        QCOMPARE(before.find(u"editor").name, QStringLiteral("User Editor"));
+
+        QVERIFY(QFile::remove(user.filePath("editor.desktop")));
+        QVERIFY(QFile::remove(system.filePath("viewer.desktop")));
+
+        // Only the user directory was reported; the system one keeps its (stale) entries
+        const DesktopIndex after = before.updated({user.path()});
+        QCOMPARE(after.find(u"editor").name, QStringLiteral("System Editor"));
+        QCOMPARE(after.find(u"viewer").name, QStringLiteral("Viewer"));
+        QCOMPARE(after.size(), 2);
+    }
+
+    void DesktopIndexTest::watcherCoalescesBurst() {
+        QTemporaryDir apps;
+        QVERIFY(apps.isValid());
+
+        DesktopIndexWatcher watcher({apps.path()});
+        watcher.setDebounceInterval(200);
+        QSignalSpy spy(&watcher, &DesktopIndexWatcher::directoriesChanged);
+
+        for (int i = 0; i < 20; ++i) {
+            QVERIFY(writeDesktopFile(apps.filePath(QString("burst-%1.desktop").arg(i)), "Name=Burst\n"));
+        }
+
+        QVERIFY(spy.wait(5000));
+        QTest::qWait(400);
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(spy.at(0).at(0).value<QSet<QString>>(), QSet<QString>{apps.path()});
+    }
+
+    void DesktopIndexTest::watcherPicksUpLateRootAndSubdirectories() {
+        QTemporaryDir data;
+        QVERIFY(data.isValid());
+        const QString root = data.filePath("applications");
+
+        DesktopIndexWatcher watcher({root});
+        watcher.setDebounceInterval(50);
+        QSignalSpy spy(&watcher, &DesktopIndexWatcher::directoriesChanged);
+
+        // Unrelated changes next to a missing root are ignored
+        QVERIFY(writeDesktopFile(data.filePath("unrelated.desktop"), "Name=Unrelated\n"));
+        QVERIFY(!spy.wait(300));
+
+        QVERIFY(QDir().mkpath(root));
+        QVERIFY(spy.wait(5000));
+        QCOMPARE(spy.takeFirst().at(0).value<QSet<QString>>(), QSet<QString>{root});
+
+        QVERIFY(QDir(root).mkdir("vendor"));
+        QVERIFY(spy.wait(5000));
+        spy.clear();
+
+        // The new subdirectory is watched after the flush that reported it
+        QVERIFY(writeDesktopFile(root + "/vendor/tool.desktop", "Name=Tool\n"));
+        QVERIFY(spy.wait(5000));
+        QVERIFY(spy.takeFirst().at(0).value<QSet<QString>>().contains(root + "/vendor"));
+    }
+
+    void DesktopIndexTest::benchmark_lookupFiveThousandEntries() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        for (int i = 0; i < SYNTHETIC_ENTRY_COUNT; ++i) {
+            const DesktopInfo d = syntheticEntry(i);
+            QVERIFY(writeDesktopFile(dir.filePath(d.desktopId), "Name=" + d.name.toUtf8() + "\nExec=" + d.exec.toUtf8() + " %F\nTryExec=" + d.tryExec.toUtf8() + "\n"));
+        }
+
+        const DesktopIndex index = DesktopIndex::scan({dir.path()});
+        QCOMPARE(index.size(), SYNTHETIC_ENTRY_COUNT);
+
+        const QStringList queries = benchmarkQueries();
+        int               matched = 0;
+        QBENCHMARK {
+            matched = 0;
+            for (const auto& query : queries) {
+                matched += index.find(query).desktopId.isEmpty() ? 0 : 1;
+            }
+        }
+
+        QCOMPARE(matched, queries.size() / 6 * 5);
+    }
+
+    void DesktopIndexTest::benchmark_linearScanFiveThousandEntries() {
+        QList<DesktopInfo> entries;
+        for (int i = 0; i < SYNTHETIC_ENTRY_COUNT; ++i) {
+            entries << syntheticEntry(i);
+        }
+
+        const QStringList queries = benchmarkQueries();
+        int               matched = 0;
+        QBENCHMARK {
+            matched = 0;
+            for (const auto& query : queries) {
+                matched += linearFind(entries, query).desktopId.isEmpty() ? 0 : 1;
+            }
+        }
+
+        QCOMPARE(matched, queries.size() / 6 * 5);
+    }
+
+} // namespace bb
+
+int runDesktopIndexTests(int argc, char** argv) {
+    bb::DesktopIndexTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "test_desktop_index.moc"
@@ -0,0 +1,235 @@
+#include "../src/core/providers/FallbackStandby.hpp"
+
+#include <QtTest/QtTest>
+
+#include <unistd.h>
+
+namespace bb {
+
+    class FallbackStandbyTest : public QObject {
+        Q_OBJECT
+
+      private slots:
+        void staysIdleUnlessEnabled();
+        void startsOneStandbyAndReplacesItWhenGone();
+        void backsOffWhenStandbyDiesBeforeRegistering();
+        void declinesStandbyOverMemoryBudget();
+        void measuresPromotionOnce();
+        void measuresRealProcessMemory();
+        void pollsOnlyWhatItCannotWatch();
+    };
+
+    namespace {
+
+        // Shared by every test: alive maps pid to KiB in use, and exit() reports a process gone the way its pidfd would
+        struct FakeProcesses {
+            QHash<qint64, qint64>                alive;
+            QList<QStringList>                   started;
+            qint64                               nextPid   = 100;
+            bool                                 watchable = true;
+            QHash<qint64, std::function<void()>> watches;
+
+            void exit(qint64 pid) {
+                alive.remove(pid);
+                if (const auto onExit = watches.take(pid)) {
+                    onExit();
+                }
+            }
+
+            providers::FallbackStandby::StartFn startFn() {
+                return [this](const QString&, const QStringList& args) {
+                    started << args;
+                    alive.insert(nextPid, 40000);
+                    return nextPid++;
+                };
+            }
+
+            providers::FallbackStandby::MemoryFn memoryFn() {
+                return [this](qint64 pid) -> std::optional<qint64> {
+                    const auto it = alive.constFind(pid);
+                    if (it == alive.cend()) {
+                        return std::nullopt;
+                    }
+                    return *it;
+                };
+            }
+
+            providers::FallbackStandby::WatchFn watchFn() {
+                return [this](qint64 pid, std::function<void()> onExit) {
+                    if (!watchable) {
+                        return false;
+                    }
+                    watches.insert(pid, std::move(onExit));
+                    return true;
+                };
+            }
+        };
+
+    } // namespace
+
+    void FallbackStandbyTest::staysIdleUnlessEnabled() {
+        qint64                     nowMs = 1000;
+        FakeProcesses              procs;
+        providers::FallbackStandby standby([&nowMs] { return nowMs; }, procs.startFn(), procs.memoryFn(), procs.watchFn());
+
+        QVERIFY(!standby.ensureRunning("/usr/bin/bb-auth-fallback", "/tmp/bb-auth.sock"));
+        QVERIFY(procs.started.isEmpty());
+        QVERIFY(!standby.admit(4242).accepted);
+    }
+
+    void FallbackStandbyTest::startsOneStandbyAndReplacesItWhenGone() {
+        qint64                     nowMs = 1000;
+        FakeProcesses              procs;
+        providers::FallbackStandby standby([&nowMs] { return nowMs; }, procs.startFn(), procs.memoryFn(), procs.watchFn());
+        standby.configure(true, 0);
+
+        QVERIFY(standby.ensureRunning("/usr/bin/bb-auth-fallback", "/tmp/bb-auth.sock"));
+        QCOMPARE(procs.started.size(), 1);
+        QCOMPARE(procs.started.first(), QStringList({"--standby", "--socket", "/tmp/bb-auth.sock"}));
+
+        // Still starting: no second copy
+        QVERIFY(!standby.ensureRunning("/usr/bin/bb-auth-fallback", "/tmp/bb-auth.sock"));
+
+        nowMs += 350;
+        const auto admission = standby.admit(100);
+        QVERIFY(admission.accepted);
+        QCOMPARE(admission.startupMs, qint64(350));
+        QCOMPARE(admission.memoryKb, qint64(40000));
+        QVERIFY(standby.isStandingBy());
+
+        // Promoted, then idle-exited after the prompt: replaced straight away
+        standby.promoted();
+        QVERIFY(!standby.isStandingBy());
+        QVERIFY(!standby.ensureRunning("/usr/bin/bb-auth-fallback", "/tmp/bb-auth.sock"));
+        procs.exit(100);
+        QCOMPARE(standby.pid(), qint64(0));
+        QCOMPARE(standby.nextCheckMs(), std::optional<qint64>(0));
+        QVERIFY(standby.ensureRunning("/usr/bin/bb-auth-fallback", "/tmp/bb-auth.sock"));
+        QCOMPARE(standby.pid(), qint64(101));
+    }
+
+    void FallbackStandbyTest::backsOffWhenStandbyDiesBeforeRegistering() {
+        qint64                     nowMs = 1000;
+        FakeProcesses              procs;
+        providers::FallbackStandby standby([&nowMs] { return nowMs; }, procs.startFn(), procs.memoryFn(), procs.watchFn());
+        standby.configure(true, 0);
+
+        QVERIFY(standby.ensureRunning("/usr/bin/bb-auth-fallback", QString()));
+        QCOMPARE(procs.started.first(), QStringList({"--standby"}));
+        procs.exit(100);
+        QCOMPARE(standby.nextCheckMs(), std::optional<qint64>(31000));
+
+        QVERIFY(!standby.ensureRunning("/usr/bin/bb-auth-fallback", QString()));
+        nowMs += 29999;
+        QVERIFY(!standby.ensureRunning("/usr/bin/bb-auth-fallback", QString()));
+        nowMs += 1;
+        QVERIFY(standby.ensureRunning("/usr/bin/bb-auth-fallback", QString()));
+        QCOMPARE(procs.started.size(), 2);
+    }
+
+    void FallbackStandbyTest::declinesStandbyOverMemoryBudget() {
+        qint64                     nowMs = 1000;
+        FakeProcesses              procs;
+        providers::FallbackStandby standby([&nowMs] { return nowMs; }, procs.startFn(), procs.memoryFn(), procs.watchFn());
+        standby.configure(true, 50000);
+
+        QVERIFY(standby.ensureRunning("/usr/bin/bb-auth-fallback", QString()));
+        QVERIFY(standby.admit(100).accepted);
+        QCOMPARE(standby.nextCheckMs(), std::optional<qint64>(601000));
+        QVERIFY(standby.withinBudget());
+
+        // Grew while waiting: only noticed once the check is due, then dropped, and not replaced
+        // by another copy that would cost the same
+        procs.alive[100] = 60000;
+        QVERIFY(standby.withinBudget());
+        nowMs += 600000;
+        QVERIFY(!standby.withinBudget());
+        QVERIFY(!standby.isEnabled());
+        procs.exit(100);
+        QVERIFY(!standby.nextCheckMs());
+        nowMs += 60000;
+        QVERIFY(!standby.ensureRunning("/usr/bin/bb-auth-fallback", QString()));
+
+        providers::FallbackStandby heavy([&nowMs] { return nowMs; }, procs.startFn(), procs.memoryFn(), procs.watchFn());
+        heavy.configure(true, 50000);
+        QVERIFY(heavy.ensureRunning("/usr/bin/bb-auth-fallback", QString()));
+        procs.alive[101] = 70000;
+        const auto admission = heavy.admit(101);
+        QVERIFY(!admission.accepted);
+        QCOMPARE(admission.memoryKb, qint64(70000));
+        QVERIFY(!heavy.isEnabled());
+    }
+
+    void FallbackStandbyTest::measuresPromotionOnce() {
+        qint64                     nowMs = 1000;
+        FakeProcesses              procs;
+        providers::FallbackStandby standby([&nowMs] { return nowMs; }, procs.startFn(), procs.memoryFn(), procs.watchFn());
+        standby.configure(true, 0);
+
+        QVERIFY(standby.ensureRunning("/usr/bin/bb-auth-fallback", QString()));
+        QVERIFY(standby.admit(100).accepted);
+        QVERIFY(!standby.promotionAcknowledged());
+
+        standby.promoted();
+        nowMs += 12;
+        QCOMPARE(standby.promotionAcknowledged(), std::optional<qint64>(12));
+        QVERIFY(!standby.promotionAcknowledged());
+    }
+
+    void FallbackStandbyTest::measuresRealProcessMemory() {
+        providers::FallbackStandby standby;
+        standby.configure(true, 0);
+
+        const auto admission = standby.admit(::getpid());
+        QVERIFY(admission.accepted);
+        QVERIFY(admission.memoryKb > 0);
+        QCOMPARE(admission.startupMs, qint64(-1));
+    }
+
+    void FallbackStandbyTest::pollsOnlyWhatItCannotWatch() {
+        qint64                     nowMs = 1000;
+        FakeProcesses              procs;
+        providers::FallbackStandby standby([&nowMs] { return nowMs; }, procs.startFn(), procs.memoryFn(), procs.watchFn());
+        standby.configure(true, 50000);
+        int exits = 0;
+        standby.setExitHandler([&exits] { ++exits; });
+
+        // Watched processes are never polled; a registered standby only has its rare memory check
+        QVERIFY(standby.ensureRunning("/usr/bin/bb-auth-fallback", QString()));
+        QVERIFY(!standby.needsPolling());
+        QVERIFY(!standby.nextCheckMs());
+        QVERIFY(standby.admit(100).accepted);
+        QVERIFY(!standby.needsPolling());
+        QVERIFY(standby.nextCheckMs() >= nowMs + 60000);
+        standby.promoted();
+        QVERIFY(!standby.needsPolling());
+        QVERIFY(!standby.nextCheckMs());
+
+        // Its pid handed to another process: the exit is what counts, not /proc
+        procs.exit(100);
+        procs.alive.insert(100, 1000);
+        QCOMPARE(exits, 1);
+        QVERIFY(standby.ensureRunning("/usr/bin/bb-auth-fallback", QString()));
+        QCOMPARE(standby.pid(), qint64(101));
+
+        // Without a watch, liveness is polled as before
+        procs.watchable = false;
+        providers::FallbackStandby unwatched([&nowMs] { return nowMs; }, procs.startFn(), procs.memoryFn(), procs.watchFn());
+        unwatched.configure(true, 0);
+        QVERIFY(unwatched.ensureRunning("/usr/bin/bb-auth-fallback", QString()));
+        QVERIFY(unwatched.needsPolling());
+        QVERIFY(!unwatched.ensureRunning("/usr/bin/bb-auth-fallback", QString()));
+        procs.alive.remove(102);
+        QVERIFY(!unwatched.ensureRunning("/usr/bin/bb-auth-fallback", QString()));
+        nowMs += 30000;
+        QVERIFY(unwatched.ensureRunning("/usr/bin/bb-auth-fallback", QString()));
+    }
+
+} // namespace bb
+
+int runFallbackStandbyTests(int argc, char** argv) {
+    bb::FallbackStandbyTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "test_fallback_standby.moc"
@@ -92,6 +92,8 @@ namespace bb {
         void submitTimeout_releasesBusyAndShowsRetry();
         void cancelTimeout_releasesBusyAndShowsError();
         void closedError_autoDismissesToAvoidDeadEnd();
+        void requestorUpdate_relabelsWithoutResettingInput();
+        void requestorUpdate_keepsSubmitInFlight();
     };
 
     void FallbackWindowTouchModelTest::background_isOpaqueToAvoidBlurBleed() {
@@ -324,6 +326,52 @@ namespace bb {
         QVERIFY(!window.isVisible());
     }
 
+    void FallbackWindowTouchModelTest::requestorUpdate_relabelsWithoutResettingInput() {
+        FallbackClient client("/tmp/non-existent-bb-auth.sock");
+        FallbackWindow window(&client);
+
+        // Announced before the daemon resolved who is asking
+        const QJsonObject context{{"message", "Authentication is required"}, {"requestor", QJsonObject{{"pid", 101}}}};
+        const QJsonObject created{{"type", "session.created"}, {"id", "late-requestor"}, {"source", "polkit"}, {"context", context}};
+        QVERIFY(QMetaObject::invokeMethod(&client, "sessionCreated", Qt::DirectConnection, Q_ARG(QJsonObject, created)));
+        QVERIFY(window.m_requestorLabel->text().contains("process 101"));
+
+        window.m_input->setText("secr");
+
+        const QJsonObject requestor{{"name", "Firefox"}, {"icon", "firefox"}, {"fallbackLetter", "F"}, {"pid", 101}};
+        const QJsonObject updated{{"type", "session.updated"}, {"id", "late-requestor"}, {"state", "prompting"}, {"prompt", "Password:"}, {"echo", false}, {"requestor", requestor}};
+        QVERIFY(QMetaObject::invokeMethod(&client, "sessionUpdated", Qt::DirectConnection, Q_ARG(QJsonObject, updated)));
+
+        QVERIFY(window.m_requestorLabel->text().contains("Firefox"));
+        QCOMPARE(window.m_currentContext.value("requestor").toObject().value("name").toString(), QString("Firefox"));
+        QCOMPARE(window.m_input->text(), QString("secr"));
+    }
+
+    void FallbackWindowTouchModelTest::requestorUpdate_keepsSubmitInFlight() {
+        EnvVarGuard    timeoutGuard("BB_AUTH_FALLBACK_ACTION_TIMEOUT_MS", "5000");
+        FallbackClient client("/tmp/non-existent-bb-auth.sock");
+        FallbackWindow window(&client);
+
+        const QJsonObject context{{"message", "Authentication is required"}, {"requestor", QJsonObject{{"pid", 101}}}};
+        const QJsonObject created{{"type", "session.created"}, {"id", "resolved-late"}, {"source", "polkit"}, {"context", context}};
+        QVERIFY(QMetaObject::invokeMethod(&client, "sessionCreated", Qt::DirectConnection, Q_ARG(QJsonObject, created)));
+
+        window.m_input->setText("secret");
+        QTest::keyClick(window.m_input, Qt::Key_Return);
+        QTRY_VERIFY_WITH_TIMEOUT(window.m_busy, 1000);
+
+        // Resolution finishing while the daemon verifies must not hand the prompt back
+        const QJsonObject requestor{{"name", "Firefox"}, {"icon", "firefox"}, {"fallbackLetter", "F"}, {"pid", 101}};
+        const QJsonObject updated{{"type", "session.updated"}, {"id", "resolved-late"}, {"state", "prompting"}, {"prompt", "Password:"}, {"echo", false}, {"requestor", requestor}};
+        QVERIFY(QMetaObject::invokeMethod(&client, "sessionUpdated", Qt::DirectConnection, Q_ARG(QJsonObject, updated)));
+
+        QVERIFY(window.m_busy);
+        QCOMPARE(window.m_pendingAction, FallbackWindow::PendingAction::Submit);
+        QVERIFY(window.m_requestorLabel->text().contains("Firefox"));
+        const QJsonObject named{{"source", "polkit"}, {"context", window.m_currentContext}, {"prompt", "Password:"}};
+        QCOMPARE(window.m_summaryLabel->text(), window.buildDisplayModel(named).summary);
+    }
+
 } // namespace bb
 
 int runFallbackWindowStateTests(int argc, char** argv) {
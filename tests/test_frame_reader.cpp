@@ -0,0 +1,228 @@
+#include "../src/common/Constants.hpp"
+#include "../src/common/FrameCodec.hpp"
+#include "../src/common/FrameReader.hpp"
+
+#include <QtTest/QtTest>
+
+#include <QBuffer>
+
+namespace bb {
+
+    namespace {
+
+        inline constexpr int BURST_MESSAGE_COUNT = 10000;
+
+        QByteArray           makeBurst(int count) {
+            QByteArray burst;
+            for (int i = 0; i < count; ++i) {
+                burst += "{\"type\":\"ui.heartbeat\",\"id\":\"provider-" + QByteArray::number(i) + "\"}\n";
+            }
+            return burst;
+        }
+
+    } // namespace
+
+    class FrameReaderTest : public QObject {
+        Q_OBJECT
+
+      private slots:
+        void splitsPipelinedLinesInOrder();
+        void keepsPartialLineAcrossReads();
+        void trimsAndSkipsBlankLines();
+        void lineAtLimitIsAccepted();
+        void unterminatedLineOverLimitOverflows();
+        void terminatedLineOverLimitOverflows();
+        void readFromBoundsEachChunk();
+        void mixesJsonAndCborFrames();
+        void partialCborFrameWaitsForPayload();
+        void cborLengthOverLimitOverflows();
+        void benchmark_tenThousandMessagesInOneRead();
+        void benchmark_legacyLeftRemoveFraming();
+    };
+
+    void FrameReaderTest::splitsPipelinedLinesInOrder() {
+        FrameReader reader(static_cast<qsizetype>(MAX_MESSAGE_SIZE));
+        reader.append("{\"type\":\"a\"}\n{\"type\":\"b\"}\n{\"type\":\"c\"}\n");
+
+        QList<QByteArray> lines;
+        while (const auto line = reader.nextFrame()) {
+            lines.append(line->payload.toByteArray());
+        }
+
+        QCOMPARE(lines, (QList<QByteArray>{"{\"type\":\"a\"}", "{\"type\":\"b\"}", "{\"type\":\"c\"}"}));
+        QCOMPARE(reader.bufferedBytes(), 0);
+        QVERIFY(!reader.overflowed());
+    }
+
+    void FrameReaderTest::keepsPartialLineAcrossReads() {
+        FrameReader reader(static_cast<qsizetype>(MAX_MESSAGE_SIZE));
+        reader.append("{\"type\":\"a\"}\n{\"ty");
+
+        auto line = reader.nextFrame();
+        QVERIFY(line.has_value());
+        QCOMPARE(line->payload.toByteArray(), QByteArray("{\"type\":\"a\"}"));
+        QVERIFY(!reader.nextFrame().has_value());
+        QCOMPARE(reader.bufferedBytes(), 4);
+
+        reader.append("pe\":\"b\"}\n");
+        line = reader.nextFrame();
+        QVERIFY(line.has_value());
+        QCOMPARE(line->payload.toByteArray(), QByteArray("{\"type\":\"b\"}"));
+        QVERIFY(!reader.nextFrame().has_value());
+    }
+
+    void FrameReaderTest::trimsAndSkipsBlankLines() {
+        FrameReader reader(static_cast<qsizetype>(MAX_MESSAGE_SIZE));
+        reader.append("\n   \n  {\"type\":\"a\"}\r\n\n");
+
+        const auto line = reader.nextFrame();
+        QVERIFY(line.has_value());
+        QCOMPARE(line->payload.toByteArray(), QByteArray("{\"type\":\"a\"}"));
+        QVERIFY(!reader.nextFrame().has_value());
+        QCOMPARE(reader.bufferedBytes(), 0);
+    }
+
+    void FrameReaderTest::lineAtLimitIsAccepted() {
+        FrameReader      reader(16);
+        const QByteArray payload(16, 'x');
+        reader.append(payload + '\n');
+
+        const auto line = reader.nextFrame();
+        QVERIFY(line.has_value());
+        QCOMPARE(line->payload.size(), 16);
+        QVERIFY(!reader.overflowed());
+    }
+
+    void FrameReaderTest::unterminatedLineOverLimitOverflows() {
+        FrameReader reader(16);
+        reader.append(QByteArray(16, 'x'));
+        QVERIFY(!reader.nextFrame().has_value());
+        QVERIFY(!reader.overflowed());
+
+        reader.append("x");
+        QVERIFY(!reader.nextFrame().has_value());
+        QVERIFY(reader.overflowed());
+
+        reader.clear();
+        QVERIFY(!reader.overflowed());
+        QCOMPARE(reader.bufferedBytes(), 0);
+    }
+
+    void FrameReaderTest::terminatedLineOverLimitOverflows() {
+        FrameReader reader(16);
+        reader.append("{\"type\":\"a\"}\n" + QByteArray(17, 'x') + "\n{\"type\":\"b\"}\n");
+
+        QVERIFY(reader.nextFrame().has_value());
+        QVERIFY(!reader.nextFrame().has_value());
+        QVERIFY(reader.overflowed());
+        QVERIFY(!reader.nextFrame().has_value());
+    }
+
+    void FrameReaderTest::readFromBoundsEachChunk() {
+        QByteArray burst = makeBurst(64);
+        QBuffer    device(&burst);
+        QVERIFY(device.open(QIODevice::ReadOnly));
+
+        FrameReader reader(64);
+        int         lines = 0;
+        while (device.bytesAvailable() > 0) {
+            const qint64 got = reader.readFrom(device);
+            QVERIFY(got > 0);
+            QVERIFY(got <= 64);
+
+            while (reader.nextFrame()) {
+                ++lines;
+            }
+            QVERIFY(!reader.overflowed());
+        }
+
+        QCOMPARE(lines, 64);
+        QCOMPARE(reader.bufferedBytes(), 0);
+    }
+
+    void FrameReaderTest::mixesJsonAndCborFrames() {
+        const QJsonObject message{{"type", "ui.heartbeat"}, {"id", "provider-1"}};
+
+        FrameReader       reader(static_cast<qsizetype>(MAX_MESSAGE_SIZE));
+        reader.append(encodeFrame(message, FrameEncoding::Cbor) + encodeFrame(message, FrameEncoding::Json) + encodeFrame(message, FrameEncoding::Cbor));
+
+        QList<FrameEncoding> encodings;
+        while (const auto frame = reader.nextFrame()) {
+            encodings.append(frame->encoding);
+            QCOMPARE(decodeFrame(frame->payload, frame->encoding).value_or(QJsonObject{}), message);
+        }
+
+        QCOMPARE(encodings, (QList<FrameEncoding>{FrameEncoding::Cbor, FrameEncoding::Json, FrameEncoding::Cbor}));
+        QCOMPARE(reader.bufferedBytes(), 0);
+    }
+
+    void FrameReaderTest::partialCborFrameWaitsForPayload() {
+        const QByteArray frame = encodeFrame(QJsonObject{{"type", "ping"}}, FrameEncoding::Cbor);
+
+        FrameReader      reader(static_cast<qsizetype>(MAX_MESSAGE_SIZE));
+        reader.append(QByteArrayView(frame).first(2));
+        QVERIFY(!reader.nextFrame().has_value());
+        reader.append(QByteArrayView(frame).sliced(2, frame.size() - 3));
+        QVERIFY(!reader.nextFrame().has_value());
+        reader.append(QByteArrayView(frame).last(1));
+
+        const auto decoded = reader.nextFrame();
+        QVERIFY(decoded.has_value());
+        QCOMPARE(decoded->encoding, FrameEncoding::Cbor);
+        QCOMPARE(decoded->payload.size(), frame.size() - CBOR_FRAME_HEADER_SIZE);
+        QVERIFY(!reader.overflowed());
+    }
+
+    void FrameReaderTest::cborLengthOverLimitOverflows() {
+        FrameReader reader(16);
+        reader.append(QByteArrayView("\x00\x00\x00\x11", 4));
+
+        QVERIFY(!reader.nextFrame().has_value());
+        QVERIFY(reader.overflowed());
+    }
+
+    void FrameReaderTest::benchmark_tenThousandMessagesInOneRead() {
+        const QByteArray burst = makeBurst(BURST_MESSAGE_COUNT);
+
+        int              lines = 0;
+        QBENCHMARK {
+            FrameReader reader(static_cast<qsizetype>(MAX_MESSAGE_SIZE));
+            reader.append(burst);
+
+            lines = 0;
+            while (const auto line = reader.nextFrame()) {
+                lines += line->payload.isEmpty() ? 0 : 1;
+            }
+        }
+
+        QCOMPARE(lines, BURST_MESSAGE_COUNT);
+    }
+
+    void FrameReaderTest::benchmark_legacyLeftRemoveFraming() {
+        const QByteArray burst = makeBurst(BURST_MESSAGE_COUNT);
+
+        int              lines = 0;
+        QBENCHMARK {
+            // Previous IpcServer::onReadyRead loop, kept as the comparison baseline
+            QByteArray buffer = burst;
+            qsizetype  idx;
+
+            lines = 0;
+            while ((idx = buffer.indexOf('\n')) != -1) {
+                QByteArray line = buffer.left(idx).trimmed();
+                buffer.remove(0, static_cast<qsizetype>(idx + 1));
+                lines += line.isEmpty() ? 0 : 1;
+            }
+        }
+
+        QCOMPARE(lines, BURST_MESSAGE_COUNT);
+    }
+
+} // namespace bb
+
+int runFrameReaderTests(int argc, char** argv) {
+    bb::FrameReaderTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "test_frame_reader.moc"
@@ -0,0 +1,349 @@
+#include "../src/common/Constants.hpp"
+#include "../src/core/agent/ProviderRegistry.hpp"
+#include "../src/core/agent/ProviderTimers.hpp"
+#include "../src/core/ipc/IpcServer.hpp"
+#include "../src/core/providers/FallbackStandby.hpp"
+#include "../src/core/providers/ProviderLauncher.hpp"
+#include "../src/fallback/FallbackClient.hpp"
+
+#include <QtTest/QtTest>
+
+#include <QAbstractEventDispatcher>
+#include <QDateTime>
+#include <QEventLoop>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTemporaryDir>
+#include <QTimer>
+
+namespace bb {
+
+    class IdleWakeupTest : public QObject {
+        Q_OBJECT
+
+      private slots:
+        void initTestCase();
+        void daemonServerSleepsWithIdleClient();
+        void quiescentFallbackClientSleeps();
+        void fallbackClientHeartbeatsForOlderDaemons();
+        void quiescentFallbackClientAnswersProbe();
+        void agentBookkeepingSleepsWithoutProviders();
+        void agentBookkeepingSleepsWithQuiescentProvider();
+        void providerTimersArmOnlyForDeadlines();
+
+      private:
+        int m_floor = 0;
+    };
+
+    namespace {
+
+        // The client's and the agent's periodic timers, shortened so a window of a second catches each a few times
+        inline constexpr int HEARTBEAT_MS   = 300;
+        inline constexpr int WATCHDOG_MS    = 150;
+        inline constexpr int MAINTENANCE_MS = 300;
+        inline constexpr int IDLE_WINDOW_MS = 1000;
+        // Allowance for wakeups the platform causes on its own; a timer firing in the window costs more than this
+        inline constexpr int WAKEUP_SLACK = 2;
+
+        // Event-loop wakeups over an otherwise idle window, counted as the times the loop went back to sleep;
+        // aboutToBlock is emitted the same way by the glib and the plain unix dispatcher
+        int wakeupsOver(int windowMs) {
+            int        wakeups = 0;
+            const auto counter = QObject::connect(QAbstractEventDispatcher::instance(), &QAbstractEventDispatcher::aboutToBlock, [&wakeups] { ++wakeups; });
+
+            QEventLoop loop;
+            QTimer::singleShot(windowMs, &loop, &QEventLoop::quit);
+            loop.exec();
+
+            QObject::disconnect(counter);
+            return wakeups;
+        }
+
+        // Enough of the daemon for a provider to register, subscribe and stay connected
+        class FakeDaemon {
+          public:
+            explicit FakeDaemon(bool acceptQuiescent) : m_acceptQuiescent(acceptQuiescent) {}
+
+            bool start() {
+                if (!m_tempDir.isValid()) {
+                    return false;
+                }
+
+                m_socketPath = m_tempDir.path() + "/idle-wakeups.sock";
+                QLocalServer::removeServer(m_socketPath);
+
+                m_server.setMessageHandler([this](QLocalSocket* socket, const QString& type, const QJsonObject& msg) {
+                    if (type == "ui.register") {
+                        QJsonObject reply{{"type", "ui.registered"}, {"id", "provider-1"}, {"active", true}, {"priority", 10}};
+                        if (m_acceptQuiescent && msg.value(json::KEY_CAPABILITIES).toArray().contains(QLatin1String(json::VAL_QUIESCENT))) {
+                            reply[json::KEY_QUIESCENT] = true;
+                        }
+                        m_server.sendJson(socket, reply);
+                        m_provider = socket;
+                        ++registrations;
+                    } else if (type == "subscribe") {
+                        m_server.sendJson(socket, QJsonObject{{"type", "subscribed"}, {"active", true}});
+                        ++subscriptions;
+                    } else if (type == "ui.heartbeat") {
+                        m_server.sendJson(socket, QJsonObject{{"type", "ok"}, {"active", true}});
+                        ++heartbeats;
+                    }
+                });
+                return m_server.start(m_socketPath);
+            }
+
+            QString socketPath() const {
+                return m_socketPath;
+            }
+
+            void probe() {
+                m_server.sendEvent(m_provider, EncodedEvent(QJsonObject{{"type", json::VAL_UI_PING}}));
+            }
+
+            int registrations = 0;
+            int subscriptions = 0;
+            int heartbeats    = 0;
+
+          private:
+            bool          m_acceptQuiescent = false;
+            QTemporaryDir m_tempDir;
+            QString       m_socketPath;
+            IpcServer     m_server;
+            QLocalSocket* m_provider = nullptr;
+        };
+
+        // The agent's provider bookkeeping on CAgent's own timers; CAgent itself needs a polkit agent to
+        // construct, so the handlers here only keep the books
+        class IdleAgent {
+          public:
+            IdleAgent() : m_timers(MAINTENANCE_MS) {
+                agent::ProviderTimers::Handlers handlers;
+                handlers.maintenance = [this] {
+                    if (!m_standby.needsPolling()) {
+                        m_timers.stopMaintenance();
+                    }
+                };
+                handlers.expiry = [this] {
+                    m_registry.pruneStale();
+                    m_timers.armExpiry(m_registry.nextExpiryMs());
+                };
+                handlers.registrationDeadline = [this] {
+                    while (m_launcher.expireRegistration()) {}
+                    m_timers.armRegistrationDeadline(m_launcher.nextDeadlineMs());
+                };
+                m_timers.setHandlers(std::move(handlers));
+                m_standby.configure(false, 0);
+            }
+
+            bool start() {
+                if (!m_tempDir.isValid()) {
+                    return false;
+                }
+
+                m_socketPath = m_tempDir.path() + "/idle-agent.sock";
+                QLocalServer::removeServer(m_socketPath);
+
+                m_server.setMessageHandler([this](QLocalSocket* socket, const QString& type, const QJsonObject& msg) {
+                    if (type == "ui.register") {
+                        const auto provider = m_registry.registerProvider(socket, msg);
+                        m_registry.recomputeActiveProvider();
+                        QJsonObject reply{{"type", "ui.registered"}, {"id", provider.id}, {"active", socket == m_registry.activeProvider()}, {"priority", provider.priority}};
+                        if (provider.quiescent) {
+                            reply[json::KEY_QUIESCENT] = true;
+                        }
+                        m_server.sendJson(socket, reply);
+                        m_timers.armExpiry(m_registry.nextExpiryMs());
+                    } else if (type == "subscribe") {
+                        m_server.sendJson(socket, QJsonObject{{"type", "subscribed"}, {"active", m_registry.hasActiveProvider()}});
+                    } else if (type == "ui.heartbeat") {
+                        m_registry.heartbeat(socket);
+                        m_server.sendJson(socket, QJsonObject{{"type", "ok"}, {"active", m_registry.hasActiveProvider()}});
+                    }
+                });
+                QObject::connect(&m_server, &IpcServer::clientDisconnected, [this](QLocalSocket* socket) {
+                    if (m_registry.removeSocket(socket)) {
+                        m_registry.recomputeActiveProvider();
+                    }
+                });
+                if (!m_server.start(m_socketPath)) {
+                    return false;
+                }
+
+                // As CAgent::start() leaves things once it is listening
+                if (m_standby.needsPolling()) {
+                    m_timers.startMaintenance();
+                }
+                m_timers.armStandbyCheck(m_standby.nextCheckMs());
+                m_timers.armRegistrationDeadline(m_launcher.nextDeadlineMs());
+                m_timers.armExpiry(m_registry.nextExpiryMs());
+                return true;
+            }
+
+            QString socketPath() const {
+                return m_socketPath;
+            }
+
+            bool hasActiveProvider() const {
+                return m_registry.hasActiveProvider();
+            }
+
+            bool timersIdle() const {
+                return m_timers.idle();
+            }
+
+          private:
+            QTemporaryDir               m_tempDir;
+            QString                     m_socketPath;
+            IpcServer                   m_server;
+            agent::ProviderRegistry     m_registry;
+            providers::ProviderLauncher m_launcher;
+            providers::FallbackStandby  m_standby;
+            agent::ProviderTimers       m_timers;
+        };
+
+    } // namespace
+
+    void IdleWakeupTest::initTestCase() {
+        // What the event loop costs with nothing else going on: sleeping until the window ends
+        m_floor = wakeupsOver(100);
+        QVERIFY(m_floor >= 1);
+    }
+
+    void IdleWakeupTest::daemonServerSleepsWithIdleClient() {
+        FakeDaemon daemon(true);
+        if (!daemon.start()) {
+            QSKIP("Skipping local-socket-dependent test: cannot listen");
+        }
+
+        QLocalSocket client;
+        client.connectToServer(daemon.socketPath());
+        QVERIFY(client.waitForConnected(1000));
+        QTest::qWait(50);
+
+        QVERIFY(wakeupsOver(1000) <= m_floor + WAKEUP_SLACK);
+    }
+
+    void IdleWakeupTest::quiescentFallbackClientSleeps() {
+        FakeDaemon daemon(true);
+        if (!daemon.start()) {
+            QSKIP("Skipping local-socket-dependent test: cannot listen");
+        }
+
+        FallbackClient client(daemon.socketPath());
+        client.setTimerIntervals(HEARTBEAT_MS, WATCHDOG_MS);
+        client.start();
+        QTRY_VERIFY_WITH_TIMEOUT(client.isActiveProvider() && daemon.subscriptions > 0, 2000);
+        QTest::qWait(50);
+
+        // No watchdog left armed and no heartbeats: nothing runs until the daemon has something to say
+        QVERIFY(wakeupsOver(IDLE_WINDOW_MS) <= m_floor + WAKEUP_SLACK);
+        QCOMPARE(daemon.registrations, 1);
+        QCOMPARE(daemon.heartbeats, 0);
+    }
+
+    void IdleWakeupTest::fallbackClientHeartbeatsForOlderDaemons() {
+        FakeDaemon daemon(false);
+        if (!daemon.start()) {
+            QSKIP("Skipping local-socket-dependent test: cannot listen");
+        }
+
+        FallbackClient client(daemon.socketPath());
+        client.setTimerIntervals(HEARTBEAT_MS, WATCHDOG_MS);
+        client.start();
+        QTRY_VERIFY_WITH_TIMEOUT(client.isActiveProvider() && daemon.subscriptions > 0, 2000);
+        QTest::qWait(50);
+
+        // Also shows the count notices a periodic timer
+        QVERIFY(wakeupsOver(IDLE_WINDOW_MS) > m_floor);
+        QVERIFY(daemon.heartbeats >= 1);
+    }
+
+    void IdleWakeupTest::quiescentFallbackClientAnswersProbe() {
+        FakeDaemon daemon(true);
+        if (!daemon.start()) {
+            QSKIP("Skipping local-socket-dependent test: cannot listen");
+        }
+
+        FallbackClient client(daemon.socketPath());
+        client.setTimerIntervals(HEARTBEAT_MS, WATCHDOG_MS);
+        client.start();
+        QTRY_VERIFY_WITH_TIMEOUT(client.isActiveProvider() && daemon.subscriptions > 0, 2000);
+
+        // What the daemon sends before handing it a prompt; a hung client would miss the deadline
+        daemon.probe();
+        QTRY_COMPARE_WITH_TIMEOUT(daemon.heartbeats, 1, 2000);
+    }
+
+    void IdleWakeupTest::agentBookkeepingSleepsWithoutProviders() {
+        IdleAgent agent;
+        if (!agent.start()) {
+            QSKIP("Skipping local-socket-dependent test: cannot listen");
+        }
+
+        // Nothing registered, launching or on standby: no timer is left armed
+        QVERIFY(agent.timersIdle());
+        QVERIFY(wakeupsOver(IDLE_WINDOW_MS) <= m_floor + WAKEUP_SLACK);
+        QVERIFY(agent.timersIdle());
+    }
+
+    void IdleWakeupTest::agentBookkeepingSleepsWithQuiescentProvider() {
+        IdleAgent agent;
+        if (!agent.start()) {
+            QSKIP("Skipping local-socket-dependent test: cannot listen");
+        }
+
+        FallbackClient client(agent.socketPath());
+        client.setTimerIntervals(HEARTBEAT_MS, WATCHDOG_MS);
+        client.start();
+        QTRY_VERIFY_WITH_TIMEOUT(client.isActiveProvider() && agent.hasActiveProvider(), 2000);
+        QTest::qWait(50);
+
+        // A quiescent provider has no expiry until it is probed, so the daemon sleeps as well as the client
+        QVERIFY(agent.timersIdle());
+        QVERIFY(wakeupsOver(IDLE_WINDOW_MS) <= m_floor + WAKEUP_SLACK);
+        QVERIFY(agent.timersIdle());
+        QVERIFY(agent.hasActiveProvider());
+    }
+
+    void IdleWakeupTest::providerTimersArmOnlyForDeadlines() {
+        agent::ProviderTimers timers(MAINTENANCE_MS);
+        int                   maintenance = 0;
+        int                   expiries    = 0;
+        timers.setHandlers({.maintenance = [&maintenance] { ++maintenance; }, .standbyCheck = {}, .expiry = [&expiries] { ++expiries; }, .registrationDeadline = {}});
+
+        // Nothing to wait for leaves every timer stopped
+        timers.armExpiry(std::nullopt);
+        timers.armRegistrationDeadline(std::nullopt);
+        timers.armStandbyCheck(std::nullopt);
+        QVERIFY(timers.idle());
+
+        // A deadline already passed fires once, then nothing is left armed
+        timers.armExpiry(QDateTime::currentMSecsSinceEpoch() - 1000);
+        QTRY_COMPARE_WITH_TIMEOUT(expiries, 1, 1000);
+        QVERIFY(timers.idle());
+
+        // A later deadline replaces an earlier one rather than adding to it
+        timers.armRegistrationDeadline(QDateTime::currentMSecsSinceEpoch() + 60000);
+        QVERIFY(!timers.idle());
+        timers.armRegistrationDeadline(std::nullopt);
+        QVERIFY(timers.idle());
+
+        // The tick repeats until it is stopped
+        timers.startMaintenance();
+        QTRY_VERIFY_WITH_TIMEOUT(maintenance >= 2, 4 * MAINTENANCE_MS);
+        QVERIFY(timers.maintenanceActive());
+        timers.stopMaintenance();
+        QVERIFY(timers.idle());
+        QCOMPARE(expiries, 1);
+    }
+
+} // namespace bb
+
+int runIdleWakeupTests(int argc, char** argv) {
+    bb::IdleWakeupTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "test_idle_wakeups.moc"
@@ -1,18 +1,39 @@
 #include "../src/common/Constants.hpp"
+#include "../src/common/FrameCodec.hpp"
+#include "../src/common/FrameReader.hpp"
+#include "../src/common/IpcClient.hpp"
 #include "../src/core/agent/MessageRouter.hpp"
+#include "../src/core/ipc/EncodedEvent.hpp"
 #include "../src/core/ipc/IpcServer.hpp"
+#include "../src/core/ipc/SocketActivation.hpp"
 
 #include <QtTest/QtTest>
 
 #include <QCoreApplication>
 #include <QDir>
 #include <QElapsedTimer>
+#include <QFile>
 #include <QEventLoop>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QLocalServer>
 #include <QLocalSocket>
 #include <QTemporaryDir>
+#include <QtEndian>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 namespace bb {
 
@@ -49,7 +70,17 @@ namespace bb {
                         m_server.sendJson(socket, QJsonObject{{"type", "error"}, {"message", "Unknown type"}});
                     }
                 });
-                m_router.registerHandler("ping", [this](QLocalSocket* socket, const QJsonObject&) { m_server.sendJson(socket, QJsonObject{{"type", "pong"}}); });
+                m_router.registerHandler("ping", [this](QLocalSocket* socket, const QJsonObject& msg) {
+                    const FrameEncoding encoding = requestedEncoding(msg);
+                    QJsonObject         pong{{"type", "pong"}};
+                    if (encoding == FrameEncoding::Cbor) {
+                        pong["encoding"] = encodingName(encoding);
+                    }
+                    m_server.sendJson(socket, pong);
+                    m_server.setEncoding(socket, encoding);
+                });
+                QObject::connect(&m_server, &IpcServer::clientConnected, [this](QLocalSocket* socket) { m_peer = socket; });
+                m_router.registerHandler("echo", [this](QLocalSocket* socket, const QJsonObject& msg) { m_server.sendJson(socket, msg); });
 
                 if (!m_server.start(m_socketPath)) {
                     m_error = "failed to start ipc server";
@@ -73,6 +104,19 @@ namespace bb {
                 return m_client;
             }
 
+            IpcServer& server() {
+                return m_server;
+            }
+
+            agent::MessageRouter& router() {
+                return m_router;
+            }
+
+            // Server-side socket of client(), once accepted
+            QLocalSocket* peer() const {
+                return m_peer;
+            }
+
             QJsonObject readJsonLine(int timeoutMs = 1000) {
                 QByteArray   line;
                 QElapsedTimer timer;
@@ -97,6 +141,28 @@ namespace bb {
                 return json.isObject() ? json.object() : QJsonObject{};
             }
 
+            // Next frame of either encoding, decoded
+            std::optional<std::pair<FrameEncoding, QJsonObject>> readFrame(int timeoutMs = 1000) {
+                QElapsedTimer timer;
+                timer.start();
+
+                while (timer.elapsed() < timeoutMs) {
+                    m_reader.readFrom(m_client);
+                    if (const auto frame = m_reader.nextFrame()) {
+                        const auto decoded = decodeFrame(frame->payload, frame->encoding);
+                        if (!decoded) {
+                            return std::nullopt;
+                        }
+                        return std::make_pair(frame->encoding, *decoded);
+                    }
+
+                    QCoreApplication::processEvents(QEventLoop::AllEvents, 20);
+                    m_client.waitForReadyRead(20);
+                }
+
+                return std::nullopt;
+            }
+
           private:
             bb::IpcServer         m_server;
             bb::agent::MessageRouter m_router;
@@ -104,8 +170,67 @@ namespace bb {
             QString               m_socketPath;
             QString               m_error;
             QLocalSocket          m_client;
+            FrameReader           m_reader{static_cast<qsizetype>(MAX_MESSAGE_SIZE)};
+            QLocalSocket*         m_peer = nullptr;
         };
 
+        EncodedEvent sequencedEvent(int seq) {
+            return EncodedEvent(QJsonObject{{"type", "ui.active"}, {"active", false}, {"seq", seq}});
+        }
+
+        // Blocking stand-in for the daemon; IpcClient blocks its own thread, so this runs on another
+        QList<QJsonObject> readRequests(QLocalSocket& socket, int count) {
+            FrameReader        reader(static_cast<qsizetype>(MAX_MESSAGE_SIZE));
+            QList<QJsonObject> requests;
+            while (requests.size() < count && (socket.bytesAvailable() > 0 || socket.waitForReadyRead(5000))) {
+                reader.readFrom(socket);
+                while (const auto frame = reader.nextFrame()) {
+                    if (const auto decoded = decodeFrame(frame->payload, frame->encoding)) {
+                        requests.append(*decoded);
+                    }
+                }
+            }
+            return requests;
+        }
+
+        void answer(QLocalSocket& socket, const QJsonObject& request) {
+            const QJsonObject reply{{"type", request.value("type").toString() + ".reply"}, {"requestId", request.value("requestId")}};
+            socket.write(encodeFrame(reply, FrameEncoding::Json));
+            socket.waitForBytesWritten(1000);
+        }
+
+        // What a service manager would pass: a bound, listening socket; -1 if that is not possible here
+        int listeningSocket(const QString& path) {
+            const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                return -1;
+            }
+
+            sockaddr_un      address{};
+            const QByteArray encoded = path.toLocal8Bit();
+            address.sun_family       = AF_UNIX;
+            std::memcpy(address.sun_path, encoded.constData(), std::min<std::size_t>(encoded.size(), sizeof(address.sun_path) - 1));
+            if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, 8) != 0) {
+                ::close(fd);
+                return -1;
+            }
+            return fd;
+        }
+
+        QList<QJsonObject> parityMessages() {
+            return {
+                QJsonObject{{"type", "ui.heartbeat"}, {"id", "provider-1"}},
+                QJsonObject{{"type", "session.updated"},
+                            {"id", "3f1c"},
+                            {"state", "prompting"},
+                            {"prompt", QString::fromUtf8("Contraseña para «root»:")},
+                            {"echo", false},
+                            {"retry", QJsonObject{{"current", 1}, {"max", 3}}},
+                            {"tags", QJsonArray{"a", 2, 3.5, true, QJsonValue::Null}}},
+                QJsonObject{{"type", "session.closed"}, {"id", ""}, {"result", "cancelled"}, {"context", QJsonObject{}}},
+            };
+        }
+
     } // namespace
 
     class IpcContractTest : public QObject {
@@ -116,6 +241,26 @@ namespace bb {
         void missingType_returnsError();
         void unknownType_returnsError();
         void oversizedBufferedInput_disconnectsClient();
+        void cborFrames_roundTripAndMatchJson();
+        void encodedEvent_cachesCborFrameAcrossCopies();
+        void cborRequest_isAcceptedWithoutNegotiation();
+        void negotiatedCbor_switchesReplies();
+        void pipelinedMixedFrames_repliesInOrder();
+        void invalidCbor_returnsError();
+        void oversizedCborLength_disconnectsClient();
+        void writesWithinIteration_areMerged();
+        void slowReader_dropsOldestEventsButKeepsReplies();
+        void slowReader_keepsSessionEventsOrDisconnects();
+        void slowReader_disconnectPolicy_closesClient();
+        void exemptClient_isNeverThrottled();
+        void peerCredentials_capturedAtAccept();
+        void requestId_isEchoedOnReplies();
+        void deferredReply_keepsOriginalRequestId();
+        void ipcClient_pipelinesOutOfOrderReplies();
+        void ipcClient_reconnectsAfterDaemonHangup();
+        void ipcClient_asyncDeadlineAndCancel();
+        void activationSocket_takenOnlyWhenMeantForThisPath();
+        void activationSocket_servesClientsQueuedBeforeStart();
     };
 
     void IpcContractTest::invalidJson_returnsError() {
@@ -172,6 +317,581 @@ namespace bb {
         QTRY_COMPARE(socket.state(), QLocalSocket::UnconnectedState);
     }
 
+    void IpcContractTest::cborFrames_roundTripAndMatchJson() {
+        for (const QJsonObject& message : parityMessages()) {
+            const QByteArray cbor = encodeFrame(message, FrameEncoding::Cbor);
+            const QByteArray json = encodeFrame(message, FrameEncoding::Json);
+            QCOMPARE(cbor.at(0), '\0');
+            QVERIFY(json.endsWith('\n'));
+
+            const auto fromCbor = decodeFrame(QByteArrayView(cbor).sliced(CBOR_FRAME_HEADER_SIZE), FrameEncoding::Cbor);
+            const auto fromJson = decodeFrame(QByteArrayView(json).chopped(1), FrameEncoding::Json);
+            QVERIFY(fromCbor.has_value());
+            QVERIFY(fromJson.has_value());
+            QCOMPARE(*fromCbor, message);
+            QCOMPARE(*fromCbor, *fromJson);
+        }
+    }
+
+    void IpcContractTest::encodedEvent_cachesCborFrameAcrossCopies() {
+        const EncodedEvent event(parityMessages().at(1));
+        const EncodedEvent copy = event;
+
+        const QByteArray&  cbor = event.frame(FrameEncoding::Cbor);
+        QVERIFY(copy.frame(FrameEncoding::Cbor).isSharedWith(cbor));
+        QCOMPARE(decodeFrame(QByteArrayView(cbor).sliced(CBOR_FRAME_HEADER_SIZE), FrameEncoding::Cbor).value_or(QJsonObject{}), event.json());
+    }
+
+    void IpcContractTest::cborRequest_isAcceptedWithoutNegotiation() {
+        IpcContractFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+
+        auto& socket = fixture.client();
+        QVERIFY(socket.write(encodeFrame(QJsonObject{{"type", "ping"}}, FrameEncoding::Cbor)) > 0);
+        QVERIFY(socket.waitForBytesWritten(1000));
+
+        // Replies stay JSON until the client opts in
+        const auto reply = fixture.readFrame();
+        QVERIFY(reply.has_value());
+        QCOMPARE(reply->first, FrameEncoding::Json);
+        QCOMPARE(reply->second.value("type").toString(), QString("pong"));
+        QVERIFY(!reply->second.contains("encoding"));
+    }
+
+    void IpcContractTest::negotiatedCbor_switchesReplies() {
+        IpcContractFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+
+        auto& socket = fixture.client();
+        QVERIFY(socket.write(encodeFrame(QJsonObject{{"type", "ping"}, {"capabilities", QJsonArray{"cbor"}}}, FrameEncoding::Json)) > 0);
+        QVERIFY(socket.waitForBytesWritten(1000));
+
+        const auto pong = fixture.readFrame();
+        QVERIFY(pong.has_value());
+        QCOMPARE(pong->first, FrameEncoding::Json);
+        QCOMPARE(pong->second.value("encoding").toString(), QString("cbor"));
+
+        QJsonObject request = parityMessages().at(1);
+        request["type"]     = "echo";
+        QVERIFY(socket.write(encodeFrame(request, FrameEncoding::Cbor)) > 0);
+        QVERIFY(socket.waitForBytesWritten(1000));
+
+        const auto reply = fixture.readFrame();
+        QVERIFY(reply.has_value());
+        QCOMPARE(reply->first, FrameEncoding::Cbor);
+        QCOMPARE(reply->second, request);
+    }
+
+    void IpcContractTest::pipelinedMixedFrames_repliesInOrder() {
+        IpcContractFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+
+        auto&      socket = fixture.client();
+        QByteArray burst;
+        for (int i = 0; i < 6; ++i) {
+            burst += encodeFrame(QJsonObject{{"type", "echo"}, {"seq", i}}, (i % 2) ? FrameEncoding::Cbor : FrameEncoding::Json);
+        }
+        QVERIFY(socket.write(burst) == burst.size());
+        QVERIFY(socket.waitForBytesWritten(1000));
+
+        for (int i = 0; i < 6; ++i) {
+            const auto reply = fixture.readFrame();
+            QVERIFY(reply.has_value());
+            QCOMPARE(reply->second.value("seq").toInt(), i);
+        }
+    }
+
+    void IpcContractTest::invalidCbor_returnsError() {
+        IpcContractFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+
+        // Length 1, payload is a bare unsigned integer rather than a map
+        auto&            socket = fixture.client();
+        const QByteArray frame("\x00\x00\x00\x01\x01", 5);
+        QVERIFY(socket.write(frame) == frame.size());
+        QVERIFY(socket.waitForBytesWritten(1000));
+
+        const auto reply = fixture.readJsonLine();
+        QVERIFY(!reply.isEmpty());
+        QCOMPARE(reply.value("type").toString(), QString("error"));
+        QCOMPARE(reply.value("message").toString(), QString("Invalid CBOR"));
+    }
+
+    void IpcContractTest::oversizedCborLength_disconnectsClient() {
+        IpcContractFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+
+        auto&      socket = fixture.client();
+        QByteArray header(CBOR_FRAME_HEADER_SIZE, '\0');
+        qToBigEndian<quint32>(static_cast<quint32>(MAX_MESSAGE_SIZE + 1), header.data());
+        QVERIFY(socket.write(header) == header.size());
+        QVERIFY(socket.waitForBytesWritten(1000));
+
+        QTRY_COMPARE(socket.state(), QLocalSocket::UnconnectedState);
+    }
+
+    void IpcContractTest::writesWithinIteration_areMerged() {
+        IpcContractFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+        QTRY_VERIFY(fixture.peer() != nullptr);
+
+        auto&         server = fixture.server();
+        const quint64 before = server.writeStats().writeCalls;
+        for (int i = 0; i < 5; ++i) {
+            server.sendJson(fixture.peer(), QJsonObject{{"type", "ok"}, {"seq", i}});
+        }
+        QCOMPARE(server.writeStats().writeCalls, before);
+
+        for (int i = 0; i < 5; ++i) {
+            const auto reply = fixture.readFrame();
+            QVERIFY(reply.has_value());
+            QCOMPARE(reply->second.value("seq").toInt(), i);
+        }
+        QCOMPARE(server.writeStats().writeCalls, before + 1);
+    }
+
+    void IpcContractTest::slowReader_dropsOldestEventsButKeepsReplies() {
+        IpcContractFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+        QTRY_VERIFY(fixture.peer() != nullptr);
+
+        auto& server = fixture.server();
+        server.setWatermarks(128, 512);
+
+        // One iteration's worth of output, well past the high watermark
+        server.sendJson(fixture.peer(), QJsonObject{{"type", "ok"}, {"seq", -1}});
+        for (int i = 0; i < 40; ++i) {
+            server.sendEvent(fixture.peer(), sequencedEvent(i), true);
+        }
+        QVERIFY(server.writeStats().droppedFrames > 0);
+        QVERIFY(server.queuedBytes(fixture.peer()) <= 512);
+
+        const auto reply = fixture.readFrame();
+        QVERIFY(reply.has_value());
+        QCOMPARE(reply->second.value("type").toString(), QString("ok"));
+
+        QList<int> received;
+        while (const auto event = fixture.readFrame(200)) {
+            received.append(event->second.value("seq").toInt());
+        }
+        QVERIFY(!received.isEmpty());
+        QVERIFY(received.first() > 0);
+        QCOMPARE(received.last(), 39);
+        QVERIFY(std::is_sorted(received.begin(), received.end()));
+        QCOMPARE(static_cast<quint64>(received.size()) + server.writeStats().droppedFrames, quint64(40));
+    }
+
+    void IpcContractTest::slowReader_keepsSessionEventsOrDisconnects() {
+        IpcContractFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+        QTRY_VERIFY(fixture.peer() != nullptr);
+
+        auto& server = fixture.server();
+        server.setWatermarks(128, 512);
+
+        // Status gives way; the session ending does not
+        server.sendEvent(fixture.peer(), EncodedEvent(QJsonObject{{"type", "session.closed"}, {"id", "s1"}, {"result", "cancelled"}}));
+        for (int i = 0; i < 40; ++i) {
+            server.sendEvent(fixture.peer(), sequencedEvent(i), true);
+        }
+        QVERIFY(server.writeStats().droppedFrames > 0);
+        QCOMPARE(server.writeStats().overflowDisconnects, quint64(0));
+
+        const auto closed = fixture.readFrame();
+        QVERIFY(closed.has_value());
+        QCOMPARE(closed->second.value("type").toString(), QString("session.closed"));
+        while (fixture.readFrame(200)) {
+        }
+
+        // Nothing left to shed: losing any of these would leave the client out of step
+        for (int i = 0; i < 40; ++i) {
+            server.sendEvent(fixture.peer(), EncodedEvent(QJsonObject{{"type", "session.updated"}, {"id", "s1"}, {"seq", i}}));
+        }
+        QCOMPARE(server.writeStats().overflowDisconnects, quint64(1));
+        QTRY_COMPARE(fixture.client().state(), QLocalSocket::UnconnectedState);
+    }
+
+    void IpcContractTest::slowReader_disconnectPolicy_closesClient() {
+        IpcContractFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+        QTRY_VERIFY(fixture.peer() != nullptr);
+
+        auto& server = fixture.server();
+        server.setWatermarks(128, 512);
+        server.setOverflowPolicy(IpcServer::OverflowPolicy::Disconnect);
+
+        for (int i = 0; i < 40; ++i) {
+            server.sendEvent(fixture.peer(), sequencedEvent(i));
+        }
+        QCOMPARE(server.writeStats().overflowDisconnects, quint64(1));
+
+        QTRY_COMPARE(fixture.client().state(), QLocalSocket::UnconnectedState);
+    }
+
+    void IpcContractTest::exemptClient_isNeverThrottled() {
+        IpcContractFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+        QTRY_VERIFY(fixture.peer() != nullptr);
+
+        auto&         server = fixture.server();
+        QLocalSocket* peer   = fixture.peer();
+        server.setWatermarks(128, 512);
+        server.setOverflowPolicy(IpcServer::OverflowPolicy::Disconnect);
+        server.setExemptionCheck([peer](QLocalSocket* socket) { return socket == peer; });
+
+        for (int i = 0; i < 40; ++i) {
+            server.sendEvent(peer, sequencedEvent(i));
+        }
+        QCOMPARE(server.writeStats().droppedFrames, quint64(0));
+        QCOMPARE(server.writeStats().overflowDisconnects, quint64(0));
+
+        for (int i = 0; i < 40; ++i) {
+            const auto event = fixture.readFrame();
+            QVERIFY(event.has_value());
+            QCOMPARE(event->second.value("seq").toInt(), i);
+        }
+    }
+
+    void IpcContractTest::peerCredentials_capturedAtAccept() {
+        IpcContractFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+        QTRY_VERIFY(fixture.peer() != nullptr);
+
+        QLocalSocket*          first = fixture.peer();
+        const PeerCredentials& creds = fixture.server().peerCredentials(first);
+        QVERIFY(creds.isValid());
+        QCOMPARE(creds.pid, getpid());
+        QCOMPARE(creds.uid, getuid());
+        QCOMPARE(creds.gid, getgid());
+        QVERIFY(creds.isAlive());
+
+        // A second connection from this process is the same peer
+        QLocalSocket second;
+        second.connectToServer(fixture.client().fullServerName());
+        QVERIFY(second.waitForConnected(1000));
+        QTRY_VERIFY(fixture.peer() != first);
+        QVERIFY(fixture.server().peerCredentials(fixture.peer()).sameProcess(creds));
+
+        QVERIFY(!fixture.server().peerCredentials(nullptr).isValid());
+    }
+
+    void IpcContractTest::requestId_isEchoedOnReplies() {
+        IpcContractFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+
+        auto& socket = fixture.client();
+        QVERIFY(socket.write(encodeFrame(QJsonObject{{"type", "ping"}, {"requestId", 7}}, FrameEncoding::Json)) > 0);
+        QVERIFY(socket.write(encodeFrame(QJsonObject{{"type", "unknown.event"}, {"requestId", "abc"}}, FrameEncoding::Json)) > 0);
+        QVERIFY(socket.write(encodeFrame(QJsonObject{{"type", "ping"}}, FrameEncoding::Json)) > 0);
+        QVERIFY(socket.waitForBytesWritten(1000));
+
+        const auto pong = fixture.readFrame();
+        QVERIFY(pong.has_value());
+        QCOMPARE(pong->second.value("type").toString(), QString("pong"));
+        QCOMPARE(pong->second.value("requestId").toInteger(), 7);
+
+        const auto error = fixture.readFrame();
+        QVERIFY(error.has_value());
+        QCOMPARE(error->second.value("message").toString(), QString("Unknown type"));
+        QCOMPARE(error->second.value("requestId").toString(), QString("abc"));
+
+        // Untagged requests get untagged replies
+        const auto plain = fixture.readFrame();
+        QVERIFY(plain.has_value());
+        QCOMPARE(plain->second.value("type").toString(), QString("pong"));
+        QVERIFY(!plain->second.contains("requestId"));
+    }
+
+    void IpcContractTest::deferredReply_keepsOriginalRequestId() {
+        IpcContractFixture fixture;
+        REQUIRE_LOCAL_SOCKET_LISTENING(fixture);
+
+        QLocalSocket* requester = nullptr;
+        QJsonValue    pendingId;
+        fixture.router().registerHandler("defer", [&](QLocalSocket* socket, const QJsonObject& msg) {
+            requester = socket;
+            pendingId = msg.value("requestId");
+            // Events sent while a request is handled are not its reply
+            fixture.server().sendEvent(socket, sequencedEvent(0));
+        });
+        fixture.router().registerHandler("release", [&](QLocalSocket* socket, const QJsonObject&) {
+            fixture.server().sendReply(requester, QJsonObject{{"type", "deferred"}, {"requestId", pendingId}});
+            fixture.server().sendJson(socket, QJsonObject{{"type", "ok"}});
+        });
+
+        auto& socket = fixture.client();
+        QVERIFY(socket.write(encodeFrame(QJsonObject{{"type", "defer"}, {"requestId", 1}}, FrameEncoding::Json)) > 0);
+        QVERIFY(socket.write(encodeFrame(QJsonObject{{"type", "release"}, {"requestId", 2}}, FrameEncoding::Json)) > 0);
+        QVERIFY(socket.waitForBytesWritten(1000));
+
+        const auto event = fixture.readFrame();
+        QVERIFY(event.has_value());
+        QCOMPARE(event->second.value("type").toString(), QString("ui.active"));
+        QVERIFY(!event->second.contains("requestId"));
+
+        const auto deferred = fixture.readFrame();
+        QVERIFY(deferred.has_value());
+        QCOMPARE(deferred->second.value("type").toString(), QString("deferred"));
+        QCOMPARE(deferred->second.value("requestId").toInteger(), 1);
+
+        const auto ok = fixture.readFrame();
+        QVERIFY(ok.has_value());
+        QCOMPARE(ok->second.value("type").toString(), QString("ok"));
+        QCOMPARE(ok->second.value("requestId").toInteger(), 2);
+    }
+
+    void IpcContractTest::ipcClient_pipelinesOutOfOrderReplies() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString     path = dir.path() + "/pipelined.sock";
+
+        std::atomic<bool> listening{false};
+        std::atomic<bool> failed{false};
+        std::thread       daemon([&]() {
+            QLocalServer server;
+            if (!server.listen(path)) {
+                failed = true;
+                return;
+            }
+            listening = true;
+            if (!server.waitForNewConnection(5000))
+                return;
+
+            std::unique_ptr<QLocalSocket> socket(server.nextPendingConnection());
+            const auto                    requests = readRequests(*socket, 2);
+            for (auto it = requests.crbegin(); it != requests.crend(); ++it) {
+                answer(*socket, *it);
+            }
+            socket->waitForDisconnected(5000);
+        });
+
+        // No QVERIFY until the thread is joined; an early return would leave it joinable
+        if (!QTest::qWaitFor([&]() { return listening || failed; }, 5000) || failed) {
+            daemon.join();
+            QSKIP("Skipping local-socket-dependent test: listen failed");
+        }
+
+        // Both requests share one connection and are matched by id, not arrival order
+        IpcClient                  client(path);
+        std::optional<QJsonObject> firstReply;
+        std::optional<QJsonObject> secondReply;
+        int                        completions = 0;
+        const qint64               first       = client.sendRequestAsync(QJsonObject{{"type", "first"}}, 2000, [&](std::optional<QJsonObject> reply) {
+            firstReply = std::move(reply);
+            ++completions;
+        });
+        const qint64               second      = client.sendRequestAsync(QJsonObject{{"type", "second"}}, 2000, [&](std::optional<QJsonObject> reply) {
+            secondReply = std::move(reply);
+            ++completions;
+        });
+        QTest::qWaitFor([&]() { return completions == 2; }, 5000);
+        client.disconnectFromServer();
+        daemon.join();
+
+        QVERIFY(first != 0);
+        QVERIFY(second != 0);
+        QVERIFY(first != second);
+        QCOMPARE(completions, 2);
+        QVERIFY(secondReply.has_value());
+        QVERIFY(firstReply.has_value());
+        QCOMPARE(secondReply->value("type").toString(), QString("second.reply"));
+        QCOMPARE(firstReply->value("type").toString(), QString("first.reply"));
+        QVERIFY(!firstReply->contains("requestId"));
+    }
+
+    void IpcContractTest::ipcClient_reconnectsAfterDaemonHangup() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString     path = dir.path() + "/reconnect.sock";
+
+        std::atomic<bool> listening{false};
+        std::atomic<bool> failed{false};
+        std::atomic<bool> firstClosed{false};
+        std::atomic<int>  connections{0};
+        std::thread       daemon([&]() {
+            QLocalServer server;
+            if (!server.listen(path)) {
+                failed = true;
+                return;
+            }
+            listening = true;
+
+            for (int i = 0; i < 2; ++i) {
+                if (!server.waitForNewConnection(5000))
+                    return;
+
+                std::unique_ptr<QLocalSocket> socket(server.nextPendingConnection());
+                ++connections;
+                for (const auto& request : readRequests(*socket, 1)) {
+                    answer(*socket, request);
+                }
+
+                if (i == 0) {
+                    // Daemon restart: drop the client after one reply
+                    socket->disconnectFromServer();
+                    firstClosed = true;
+                } else {
+                    socket->waitForDisconnected(5000);
+                }
+            }
+        });
+
+        // No QVERIFY until the thread is joined; an early return would leave it joinable
+        if (!QTest::qWaitFor([&]() { return listening || failed; }, 5000) || failed) {
+            daemon.join();
+            QSKIP("Skipping local-socket-dependent test: listen failed");
+        }
+
+        IpcClient  client(path);
+        const auto before = client.sendRequest(QJsonObject{{"type", "before"}}, 2000);
+        QTest::qWaitFor([&]() { return firstClosed.load(); }, 5000);
+        const auto after = client.sendRequest(QJsonObject{{"type", "after"}}, 2000);
+        client.disconnectFromServer();
+        daemon.join();
+
+        QVERIFY(before.has_value());
+        QVERIFY(after.has_value());
+        QCOMPARE(after->value("type").toString(), QString("after.reply"));
+        QCOMPARE(connections.load(), 2);
+    }
+
+    void IpcContractTest::ipcClient_asyncDeadlineAndCancel() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString     path = dir.path() + "/silent.sock";
+
+        // Reads requests but never answers them
+        std::atomic<bool> listening{false};
+        std::atomic<bool> failed{false};
+        std::thread       daemon([&]() {
+            QLocalServer server;
+            if (!server.listen(path)) {
+                failed = true;
+                return;
+            }
+            listening = true;
+            if (!server.waitForNewConnection(5000))
+                return;
+
+            std::unique_ptr<QLocalSocket> socket(server.nextPendingConnection());
+            readRequests(*socket, 2);
+            socket->waitForDisconnected(5000);
+        });
+
+        if (!QTest::qWaitFor([&]() { return listening || failed; }, 5000) || failed) {
+            daemon.join();
+            QSKIP("Skipping local-socket-dependent test: listen failed");
+        }
+
+        IpcClient     client(path);
+        int           expiredCalls   = 0;
+        int           cancelledCalls = 0;
+        bool          expiredEmpty   = false;
+        bool          cancelledEmpty = false;
+        QElapsedTimer timer;
+        timer.start();
+        client.sendRequestAsync(QJsonObject{{"type", "slow"}}, 50, [&](std::optional<QJsonObject> reply) {
+            expiredEmpty = !reply.has_value();
+            ++expiredCalls;
+        });
+        const qint64 cancelled = client.sendRequestAsync(QJsonObject{{"type", "abandoned"}}, -1, [&](std::optional<QJsonObject> reply) {
+            cancelledEmpty = !reply.has_value();
+            ++cancelledCalls;
+        });
+
+        // The caller is never blocked; cancel completes at once, the deadline from the event loop
+        client.cancel(cancelled);
+        const int cancelledBeforeLoop = cancelledCalls;
+        const int expiredBeforeLoop   = expiredCalls;
+        QTest::qWaitFor([&]() { return expiredCalls > 0; }, 2000);
+        const qint64 elapsed   = timer.elapsed();
+        const bool   connected = client.isConnected();
+        client.cancel(cancelled);
+        client.disconnectFromServer();
+        daemon.join();
+
+        QCOMPARE(cancelledBeforeLoop, 1);
+        QCOMPARE(expiredBeforeLoop, 0);
+        QCOMPARE(cancelledCalls, 1);
+        QCOMPARE(expiredCalls, 1);
+        QVERIFY(cancelledEmpty);
+        QVERIFY(expiredEmpty);
+        QVERIFY(elapsed >= 50);
+        QVERIFY(connected);
+    }
+
+    void IpcContractTest::activationSocket_takenOnlyWhenMeantForThisPath() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.path() + "/activated.sock";
+        const int     fd   = listeningSocket(path);
+        if (fd < 0) {
+            QSKIP("Skipping local-socket-dependent test: bind failed");
+        }
+
+        // For another process: left alone
+        qputenv("LISTEN_PID", QByteArray::number(::getpid() + 1));
+        qputenv("LISTEN_FDS", "1");
+        QCOMPARE(takeActivationSocket(path, fd), -1);
+        QVERIFY(::fcntl(fd, F_GETFD) >= 0);
+
+        // Variables are consumed either way
+        QVERIFY(qEnvironmentVariableIsEmpty("LISTEN_PID"));
+        QCOMPARE(takeActivationSocket(path, fd), -1);
+
+        // Bound elsewhere: closed rather than served on the wrong path
+        qputenv("LISTEN_PID", QByteArray::number(::getpid()));
+        qputenv("LISTEN_FDS", "1");
+        QCOMPARE(takeActivationSocket(dir.path() + "/other.sock", fd), -1);
+        QCOMPARE(::fcntl(fd, F_GETFD), -1);
+    }
+
+    void IpcContractTest::activationSocket_servesClientsQueuedBeforeStart() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.path() + "/activated.sock";
+        const int     fd   = listeningSocket(path);
+        if (fd < 0) {
+            QSKIP("Skipping local-socket-dependent test: bind failed");
+        }
+
+        // Connects and sends while the daemon is still starting
+        QLocalSocket client;
+        client.connectToServer(path);
+        QVERIFY(client.waitForConnected(1000));
+        client.write(encodeFrame(QJsonObject{{"type", "ping"}}, FrameEncoding::Json));
+        QVERIFY(client.waitForBytesWritten(1000));
+
+        qputenv("LISTEN_PID", QByteArray::number(::getpid()));
+        qputenv("LISTEN_FDS", "1");
+        QCOMPARE(takeActivationSocket(path, fd), fd);
+
+        IpcServer server;
+        server.setMessageHandler([&server](QLocalSocket* socket, const QString& type, const QJsonObject&) { server.sendJson(socket, QJsonObject{{"type", type + ".reply"}}); });
+        QVERIFY(server.adopt(fd));
+        QVERIFY(server.isSocketActivated());
+
+        FrameReader                reader(static_cast<qsizetype>(MAX_MESSAGE_SIZE));
+        std::optional<QJsonObject> reply;
+        QTest::qWaitFor(
+            [&]() {
+                reader.readFrom(client);
+                if (const auto frame = reader.nextFrame()) {
+                    reply = decodeFrame(frame->payload, frame->encoding);
+                }
+                return reply.has_value();
+            },
+            2000);
+        QVERIFY(reply.has_value());
+        QCOMPARE(reply->value("type").toString(), QString("ping.reply"));
+
+        // The service manager keeps listening on the same file across restarts
+        client.disconnectFromServer();
+        server.stop();
+        QVERIFY(QFile::exists(path));
+        QVERIFY(!server.isSocketActivated());
+    }
+
 } // namespace bb
 
 int runIpcContractTests(int argc, char** argv) {
@@ -0,0 +1,279 @@
+#include "../src/core/ProcessCache.hpp"
+
+#include <QtTest/QtTest>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace bb {
+
+    namespace {
+
+        inline constexpr qint64 AGENT_UID = 1000;
+
+        ProcInfo                process(qint64 pid, qint64 ppid, const QString& name, quint64 startTime) {
+            ProcInfo info;
+            info.pid       = pid;
+            info.ppid      = ppid;
+            info.uid       = AGENT_UID;
+            info.euid      = AGENT_UID;
+            info.name      = name;
+            info.exe       = "/usr/libexec/bb-test-" + name;
+            info.startTime = startTime;
+            return info;
+        }
+
+        // Every test here reads through this table; fullReads counts what would have been a full /proc parse
+        struct FakeProc {
+            QHash<qint64, ProcInfo> processes;
+            int                     fullReads = 0;
+
+            ProcessCache            makeCache(qsizetype procCapacity = 256, qsizetype actorCapacity = 64) {
+                return ProcessCache(
+                    [this](qint64 pid) -> std::optional<ProcInfo> {
+                        ++fullReads;
+                        const auto it = processes.constFind(pid);
+                        return it != processes.cend() ? std::optional(*it) : std::nullopt;
+                    },
+                    [this](qint64 pid) -> std::optional<ProcStamp> {
+                        const auto it = processes.constFind(pid);
+                        return it != processes.cend() ? std::optional(ProcStamp{.startTime = it->startTime, .ppid = it->ppid, .uid = it->uid, .euid = it->euid, .name = it->name}) : std::nullopt;
+                    },
+                    procCapacity, actorCapacity);
+            }
+        };
+
+    } // namespace
+
+    class ProcessCacheTest : public QObject {
+        Q_OBJECT
+
+      private slots:
+        void repeatedReadHitsCache();
+        void recycledPidMisses();
+        void execInvalidatesEntry();
+        void reparentingInvalidatesEntry();
+        void credentialsAreReadEveryTime();
+        void exitedProcessIsNotReturned();
+        void evictsLeastRecentlyUsed();
+        void repeatedResolutionSkipsWalk();
+        void newSubjectReusesAncestors();
+        void indexGenerationInvalidatesActors();
+        void sharedBetweenThreads();
+    };
+
+    void ProcessCacheTest::repeatedReadHitsCache() {
+        FakeProc fake;
+        fake.processes.insert(200, process(200, 1, "gpg-agent", 5000));
+        ProcessCache cache = fake.makeCache();
+
+        QCOMPARE(cache.readProc(200)->name, QStringLiteral("gpg-agent"));
+        QCOMPARE(cache.readProc(200)->name, QStringLiteral("gpg-agent"));
+        QCOMPARE(fake.fullReads, 1);
+        QCOMPARE(cache.stats().procHits, 1u);
+        QCOMPARE(cache.stats().procMisses, 1u);
+    }
+
+    void ProcessCacheTest::recycledPidMisses() {
+        FakeProc fake;
+        fake.processes.insert(300, process(300, 1, "gpg-agent", 5000));
+        ProcessCache cache = fake.makeCache();
+        QVERIFY(cache.readProc(300).has_value());
+
+        // Same pid and same name, but a later start time: a different process
+        fake.processes.insert(300, process(300, 42, "gpg-agent", 9000));
+        const auto info = cache.readProc(300);
+        QVERIFY(info.has_value());
+        QCOMPARE(info->ppid, 42);
+        QCOMPARE(info->startTime, 9000u);
+        QCOMPARE(fake.fullReads, 2);
+        QCOMPARE(cache.stats().procHits, 0u);
+    }
+
+    void ProcessCacheTest::execInvalidatesEntry() {
+        FakeProc fake;
+        fake.processes.insert(400, process(400, 1, "bash", 5000));
+        ProcessCache cache = fake.makeCache();
+        QVERIFY(cache.readProc(400).has_value());
+
+        // exec() keeps pid and start time but replaces comm
+        fake.processes.insert(400, process(400, 1, "git", 5000));
+        QCOMPARE(cache.readProc(400)->name, QStringLiteral("git"));
+        QCOMPARE(cache.readProc(400)->name, QStringLiteral("git"));
+        QCOMPARE(fake.fullReads, 2);
+    }
+
+    void ProcessCacheTest::reparentingInvalidatesEntry() {
+        FakeProc fake;
+        fake.processes.insert(410, process(410, 411, "pinentry", 5000));
+        fake.processes.insert(411, process(411, 1, "gpg-agent", 4000));
+        ProcessCache cache = fake.makeCache();
+        const ActorInfo before = cache.resolveRequestor(fake.processes.value(410), AGENT_UID, 1);
+        QCOMPARE(before.proc.pid, 411);
+
+        // The parent exited and a subreaper took over: a stale ppid would lead the walk to whatever reuses 411
+        fake.processes.remove(411);
+        fake.processes.insert(410, process(410, 1, "pinentry", 5000));
+        const int reads = fake.fullReads;
+        QCOMPARE(cache.readProc(410)->ppid, 1);
+        QCOMPARE(fake.fullReads, reads + 1);
+
+        const ActorInfo after = cache.resolveRequestor(*cache.readProc(410), AGENT_UID, 1);
+        QVERIFY(after.proc.pid != 411);
+        QCOMPARE(cache.stats().actorHits, 0u);
+    }
+
+    void ProcessCacheTest::credentialsAreReadEveryTime() {
+        FakeProc fake;
+        fake.processes.insert(420, process(420, 1, "helper", 5000));
+        ProcessCache cache = fake.makeCache();
+        QVERIFY(cache.readProc(420).has_value());
+        cache.resolveRequestor(*cache.readProc(420), AGENT_UID, 1);
+
+        // setuid() keeps pid, start time and comm; the hit still reports the new credentials
+        fake.processes[420].euid = 0;
+        const auto info = cache.readProc(420);
+        QCOMPARE(info->euid, 0);
+        QCOMPARE(fake.fullReads, 1);
+
+        // and a requestor resolved under the old ones is not reused
+        cache.resolveRequestor(*info, AGENT_UID, 1);
+        QCOMPARE(cache.stats().actorHits, 0u);
+    }
+
+    void ProcessCacheTest::exitedProcessIsNotReturned() {
+        FakeProc fake;
+        fake.processes.insert(500, process(500, 1, "pinentry", 5000));
+        ProcessCache cache = fake.makeCache();
+        QVERIFY(cache.readProc(500).has_value());
+
+        fake.processes.remove(500);
+        QVERIFY(!cache.readProc(500).has_value());
+    }
+
+    void ProcessCacheTest::evictsLeastRecentlyUsed() {
+        FakeProc fake;
+        for (qint64 pid = 600; pid < 603; ++pid) {
+            fake.processes.insert(pid, process(pid, 1, "proc", 5000));
+        }
+        ProcessCache cache = fake.makeCache(2);
+
+        QVERIFY(cache.readProc(600).has_value());
+        QVERIFY(cache.readProc(601).has_value());
+        QVERIFY(cache.readProc(600).has_value()); // 601 is now the oldest
+        QVERIFY(cache.readProc(602).has_value());
+        QCOMPARE(fake.fullReads, 3);
+
+        QVERIFY(cache.readProc(600).has_value());
+        QCOMPARE(fake.fullReads, 3);
+        QVERIFY(cache.readProc(601).has_value());
+        QCOMPARE(fake.fullReads, 4);
+    }
+
+    void ProcessCacheTest::repeatedResolutionSkipsWalk() {
+        FakeProc fake;
+        fake.processes.insert(700, process(700, 701, "prompter", 5000));
+        fake.processes.insert(701, process(701, 702, "gnome-keyring", 4000));
+        fake.processes.insert(702, process(702, 1, "systemd", 100));
+        ProcessCache cache = fake.makeCache();
+
+        const ActorInfo first = cache.resolveRequestor(fake.processes.value(700), AGENT_UID, 1);
+        const int       reads = fake.fullReads;
+        QVERIFY(reads >= 3);
+
+        const ActorInfo second = cache.resolveRequestor(fake.processes.value(700), AGENT_UID, 1);
+        QCOMPARE(fake.fullReads, reads);
+        QCOMPARE(second.displayName, first.displayName);
+        QCOMPARE(second.proc.pid, first.proc.pid);
+        QCOMPARE(cache.stats().actorHits, 1u);
+        QCOMPARE(cache.stats().actorMisses, 1u);
+
+        // Without a start time the subject can't be told apart from a recycled pid
+        ProcInfo unstamped = fake.processes.value(700);
+        unstamped.startTime = 0;
+        cache.resolveRequestor(unstamped, AGENT_UID, 1);
+        cache.resolveRequestor(unstamped, AGENT_UID, 1);
+        QCOMPARE(cache.stats().actorHits, 1u);
+    }
+
+    void ProcessCacheTest::newSubjectReusesAncestors() {
+        FakeProc fake;
+        fake.processes.insert(801, process(801, 802, "gpg-agent", 4000));
+        fake.processes.insert(802, process(802, 1, "systemd", 100));
+        ProcessCache cache = fake.makeCache();
+
+        // gpg-agent starts a fresh pinentry for every prompt
+        fake.processes.insert(800, process(800, 801, "pinentry", 5000));
+        cache.resolveRequestor(fake.processes.value(800), AGENT_UID, 1);
+        const int reads = fake.fullReads;
+
+        fake.processes.remove(800);
+        fake.processes.insert(810, process(810, 801, "pinentry", 6000));
+        cache.resolveRequestor(fake.processes.value(810), AGENT_UID, 1);
+
+        QCOMPARE(fake.fullReads, reads + 1);
+        QCOMPARE(cache.stats().actorMisses, 2u);
+        QVERIFY(cache.stats().procHits >= 2);
+    }
+
+    void ProcessCacheTest::indexGenerationInvalidatesActors() {
+        FakeProc fake;
+        fake.processes.insert(900, process(900, 1, "prompter", 5000));
+        ProcessCache cache = fake.makeCache();
+
+        cache.resolveRequestor(fake.processes.value(900), AGENT_UID, 1);
+        cache.resolveRequestor(fake.processes.value(900), AGENT_UID, 2);
+        QCOMPARE(cache.stats().actorHits, 0u);
+        QCOMPARE(cache.stats().actorMisses, 2u);
+
+        cache.clear();
+        cache.resolveRequestor(fake.processes.value(900), AGENT_UID, 2);
+        QCOMPARE(cache.stats().actorMisses, 3u);
+    }
+
+    void ProcessCacheTest::sharedBetweenThreads() {
+        constexpr int THREADS = 4;
+        constexpr int READS   = 500;
+
+        const ProcInfo       info = process(950, 1, "prompter", 5000);
+        std::atomic<int>     fullReads{0};
+        ProcessCache         cache(
+            [&](qint64) -> std::optional<ProcInfo> {
+                ++fullReads;
+                return info;
+            },
+            [&](qint64) -> std::optional<ProcStamp> { return ProcStamp{.startTime = info.startTime, .ppid = info.ppid, .uid = info.uid, .euid = info.euid, .name = info.name}; });
+
+        // Requestor resolution runs on a worker pool that shares this cache
+        std::atomic<int>         mismatches{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&] {
+                for (int i = 0; i < READS; ++i) {
+                    const auto read = cache.readProc(info.pid);
+                    if (!read || read->name != info.name) {
+                        ++mismatches;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        const ProcessCacheStats stats = cache.stats();
+        QCOMPARE(mismatches.load(), 0);
+        QCOMPARE(stats.procHits + stats.procMisses, quint64(THREADS * READS));
+        QCOMPARE(stats.procMisses, quint64(fullReads.load()));
+        QVERIFY(fullReads.load() <= THREADS);
+    }
+
+} // namespace bb
+
+int runProcessCacheTests(int argc, char** argv) {
+    bb::ProcessCacheTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "test_process_cache.moc"
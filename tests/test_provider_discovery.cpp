@@ -1,4 +1,5 @@
 #include "../src/core/providers/ProviderDiscovery.hpp"
+#include "../src/core/providers/ProviderDiscoveryCache.hpp"
 
 #include <QtTest/QtTest>
 
@@ -15,6 +16,10 @@ namespace bb {
         void discoverRespectsDirectoryPrecedenceAndDedupesById();
         void discoverUsesLexicalOrderWithinDirectory();
         void discoverSkipsInvalidManifestsWithWarnings();
+        void cacheParsesOnlyChangedManifests();
+        void cacheKeepsWarnings();
+        void cacheNoticesSearchDirCreatedLater();
+        void cacheInvalidateRereadsEverything();
     };
 
     namespace {
@@ -83,6 +88,102 @@ namespace bb {
                             [](const QString& warning) { return warning.contains("Skipping manifest") && warning.contains("exec is required"); }));
     }
 
+    void ProviderDiscoveryTest::cacheParsesOnlyChangedManifests() {
+        QTemporaryDir temp;
+        QVERIFY(temp.isValid());
+
+        const QString dir = temp.path() + "/providers";
+        QVERIFY(QDir().mkpath(dir));
+        writeFile(dir + "/a.json", R"({"id":"a","name":"A","kind":"fallback","priority":1,"exec":"/bin/true"})");
+        writeFile(dir + "/b.json", R"({"id":"b","name":"B","kind":"fallback","priority":1,"exec":"/bin/true"})");
+
+        providers::ProviderDiscoveryCache cache;
+        cache.setSearchDirs({dir});
+        QCOMPARE(cache.result().manifests.size(), 2);
+        QCOMPARE(cache.manifestReads(), 2);
+
+        // Nothing changed: served without reading
+        QVERIFY(!cache.isStale());
+        QCOMPARE(cache.result().manifests.size(), 2);
+        QCOMPARE(cache.manifestReads(), 2);
+
+        writeFile(dir + "/b.json", R"({"id":"b","name":"B renamed","kind":"fallback","priority":1,"exec":"/bin/true"})");
+        QTRY_VERIFY(cache.isStale());
+
+        const auto& result = cache.result();
+        QCOMPARE(cache.manifestReads(), 3);
+        QCOMPARE(result.manifests.size(), 2);
+        QCOMPARE(result.manifests[1].name, QString("B renamed"));
+
+        writeFile(dir + "/c.json", R"({"id":"c","name":"C","kind":"fallback","priority":1,"exec":"/bin/true"})");
+        QTRY_VERIFY(cache.isStale());
+        QCOMPARE(cache.result().manifests.size(), 3);
+        QCOMPARE(cache.manifestReads(), 4);
+    }
+
+    void ProviderDiscoveryTest::cacheKeepsWarnings() {
+        QTemporaryDir temp;
+        QVERIFY(temp.isValid());
+
+        const QString dir = temp.path() + "/providers";
+        QVERIFY(QDir().mkpath(dir));
+        writeFile(dir + "/bad.json", R"({"id":"bad","name":"Bad","kind":"fallback"})");
+
+        providers::ProviderDiscoveryCache cache;
+        cache.setSearchDirs({dir});
+        const QStringList warnings = cache.result().warnings;
+        QCOMPARE(warnings, providers::ProviderDiscovery::discover({dir}).warnings);
+
+        // A relist reuses the failed parse and reports it again
+        writeFile(dir + "/good.json", R"({"id":"good","name":"Good","kind":"fallback","priority":0,"exec":"/bin/true"})");
+        QTRY_VERIFY(cache.isStale());
+        QCOMPARE(cache.result().warnings, warnings);
+        QCOMPARE(cache.manifestReads(), 2);
+    }
+
+    void ProviderDiscoveryTest::cacheNoticesSearchDirCreatedLater() {
+        QTemporaryDir temp;
+        QVERIFY(temp.isValid());
+
+        // Neither the directory nor its parent exist yet, as with a fresh ~/.config/bb-auth
+        const QString dir = temp.path() + "/bb-auth/providers.d";
+
+        providers::ProviderDiscoveryCache cache;
+        cache.setSearchDirs({dir});
+        QVERIFY(cache.result().manifests.isEmpty());
+
+        QVERIFY(QDir().mkpath(temp.path() + "/unrelated"));
+        QTest::qWait(100);
+        QVERIFY(!cache.isStale());
+
+        QVERIFY(QDir().mkpath(dir));
+        QTRY_VERIFY(cache.isStale());
+        QVERIFY(cache.result().manifests.isEmpty());
+
+        writeFile(dir + "/qt.json", R"({"id":"qt","name":"Qt","kind":"fallback","priority":10,"exec":"/bin/true"})");
+        QTRY_VERIFY(cache.isStale());
+        QCOMPARE(cache.result().manifests.size(), 1);
+    }
+
+    void ProviderDiscoveryTest::cacheInvalidateRereadsEverything() {
+        QTemporaryDir temp;
+        QVERIFY(temp.isValid());
+
+        const QString dir = temp.path() + "/providers";
+        QVERIFY(QDir().mkpath(dir));
+        writeFile(dir + "/a.json", R"({"id":"a","name":"A","kind":"fallback","priority":1,"exec":"/bin/true"})");
+
+        providers::ProviderDiscoveryCache cache;
+        cache.setSearchDirs({dir});
+        cache.result();
+        QCOMPARE(cache.manifestReads(), 1);
+
+        cache.invalidate();
+        QVERIFY(cache.isStale());
+        QCOMPARE(cache.result().manifests.size(), 1);
+        QCOMPARE(cache.manifestReads(), 2);
+    }
+
 } // namespace bb
 
 int runProviderDiscoveryTests(int argc, char** argv) {
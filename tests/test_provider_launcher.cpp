@@ -1,7 +1,15 @@
+#include "../src/common/Constants.hpp"
 #include "../src/core/providers/ProviderLauncher.hpp"
 
 #include <QtTest/QtTest>
 
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include <csignal>
+#include <poll.h>
+#include <unistd.h>
+
 namespace bb {
 
     class ProviderLauncherTest : public QObject {
@@ -9,12 +17,52 @@ namespace bb {
 
       private slots:
         void usesLegacyEnvOverrideWhenSet();
+        void legacyCandidatesLaunchResolvedPath();
         void choosesHighestPriorityAutostartProvider();
         void fallsBackToLegacyBinaryWhenNoManifestCandidate();
         void appliesBackoffAfterFailedLaunch();
         void skipsLaunchWhenActiveProviderOrNoSessions();
+        void warmLaunchTouchesNoFiles();
+        void revalidatesResolutionWhenExecutableChanges();
+        void noticesInstalledExecutableThroughInotify();
+        void failedLaunchResolvesAgain();
+        void throttledCandidateYieldsToNext();
+        void supervisedEarlyExitMovesToNextCandidate();
+        void supervisedExitAfterRegistrationIsNotAFailure();
+        void missedRegistrationDeadlineFailsOver();
+        void registrationDeadlineAdaptsToStartupTime();
+        void supervisedProviderStoppedAtDeadline();
+        void supervisedProviderKilledAfterGrace();
+        void hedgedFallbackWinsWhenPreferredIsSlow();
+        void preferredWinningStopsHedgeThatNeverRegisters();
+        void preconnectedProviderInheritsConnection();
     };
 
+    namespace {
+
+        QString writeScript(const QTemporaryDir& dir, const QString& name, const QByteArray& body) {
+            const QString path = dir.filePath(name);
+            QFile         file(path);
+            if (!file.open(QIODevice::WriteOnly) || file.write("#!/bin/sh\n" + body) < 0) {
+                return QString();
+            }
+            file.setPermissions(file.permissions() | QFileDevice::ExeOwner);
+            return path;
+        }
+
+        providers::ProviderManifest autostartManifest(const QString& id, const QString& exec, int priority) {
+            providers::ProviderManifest manifest;
+            manifest.id        = id;
+            manifest.name      = id;
+            manifest.kind      = "fallback";
+            manifest.priority  = priority;
+            manifest.exec      = exec;
+            manifest.autostart = true;
+            return manifest;
+        }
+
+    } // namespace
+
     void ProviderLauncherTest::usesLegacyEnvOverrideWhenSet() {
         qint64                             nowMs = 1000;
         QString                            launchedProgram;
@@ -49,6 +97,33 @@ namespace bb {
         QVERIFY(launchedEnv.contains("PATH"));
     }
 
+    void ProviderLauncherTest::legacyCandidatesLaunchResolvedPath() {
+        qint64                      nowMs = 1000;
+        QString                     launchedProgram;
+
+        providers::ProviderLauncher launcher([&nowMs] { return nowMs; },
+                                             [&launchedProgram](const QString& program, const QStringList&, const QProcessEnvironment&) {
+                                                 launchedProgram = program;
+                                                 return true;
+                                             },
+                                             [](const QString& path) {
+                                                 return providers::ProviderLauncher::FileProbe{.mtimeMs = 1, .executable = path.startsWith("/opt/bb/")};
+                                             },
+                                             [](const QString& name) { return "/opt/bb/" + name; });
+
+        // Bare names, as BB_AUTH_FALLBACK_PATH or the configured default may be given, are spawned by their full path
+        auto result = launcher.tryLaunch({}, "/tmp/bb-auth.sock", "session-created", false, true, "my-fallback", QString());
+        QVERIFY(result.launched);
+        QCOMPARE(result.providerId, QString("__legacy_env__"));
+        QCOMPARE(launchedProgram, QString("/opt/bb/my-fallback"));
+
+        nowMs += 60000;
+        result = launcher.tryLaunch({}, "/tmp/bb-auth.sock", "session-created", false, true, QString(), "bb-auth-fallback");
+        QVERIFY(result.launched);
+        QCOMPARE(result.providerId, QString("__legacy_default__"));
+        QCOMPARE(launchedProgram, QString("/opt/bb/bb-auth-fallback"));
+    }
+
     void ProviderLauncherTest::choosesHighestPriorityAutostartProvider() {
         qint64                             nowMs = 1000;
         QString                            launchedProgram;
@@ -134,10 +209,16 @@ namespace bb {
         QVERIFY(!first.launched);
         QCOMPARE(attempts, 1);
 
+        // With the manifest provider throttled, the built-in fallback is next
         const auto second = launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), "/bin/false");
-        QVERIFY(!second.attempted);
-        QVERIFY(second.detail.contains("throttled"));
-        QCOMPARE(attempts, 1);
+        QVERIFY(second.attempted);
+        QCOMPARE(second.providerId, QString("__legacy_default__"));
+        QCOMPARE(attempts, 2);
+
+        const auto third = launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), "/bin/false");
+        QVERIFY(!third.attempted);
+        QVERIFY(third.detail.contains("throttled"));
+        QCOMPARE(attempts, 2);
     }
 
     void ProviderLauncherTest::skipsLaunchWhenActiveProviderOrNoSessions() {
@@ -161,6 +242,553 @@ namespace bb {
         QCOMPARE(attempts, 0);
     }
 
+    void ProviderLauncherTest::warmLaunchTouchesNoFiles() {
+        qint64                                                 nowMs = 1000;
+        QString                                                launchedProgram;
+        QProcessEnvironment                                    launchedEnv;
+        QHash<QString, providers::ProviderLauncher::FileProbe> files{{"/usr/bin/bb-auth-ui", {100, true}}};
+        int                                                    probes  = 0;
+        int                                                    lookups = 0;
+
+        providers::ProviderLauncher launcher([&nowMs] { return nowMs; },
+                                             [&](const QString& program, const QStringList&, const QProcessEnvironment& env) {
+                                                 launchedProgram = program;
+                                                 launchedEnv     = env;
+                                                 return true;
+                                             },
+                                             [&](const QString& path) {
+                                                 ++probes;
+                                                 return files.value(path);
+                                             },
+                                             [&](const QString& name) {
+                                                 ++lookups;
+                                                 return name == "bb-auth-ui" ? QString("/usr/bin/bb-auth-ui") : QString();
+                                             });
+
+        // Higher-priority candidates that can't launch are what used to cost a PATH scan each time
+        auto ui = autostartManifest("ui", "bb-auth-ui", 10);
+        ui.env  = QJsonObject{{"BB_AUTH_UI_MODE", "compact"}};
+        const QList<providers::ProviderManifest> manifests{autostartManifest("missing-name", "bb-auth-missing", 30),
+                                                           autostartManifest("missing-path", "/opt/missing/bb-auth-ui", 20), ui};
+
+        const auto first = launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), "/bin/false");
+        QVERIFY(first.launched);
+        QVERIFY(probes > 0);
+        QVERIFY(lookups > 0);
+
+        probes  = 0;
+        lookups = 0;
+        nowMs += 1000;
+        launchedProgram.clear();
+
+        const auto second = launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), "/bin/false");
+        QVERIFY(second.launched);
+        QCOMPARE(second.providerId, QString("ui"));
+        QCOMPARE(launchedProgram, QString("/usr/bin/bb-auth-ui"));
+        QCOMPARE(launchedEnv.value("BB_AUTH_UI_MODE"), QString("compact"));
+        QVERIFY(launchedEnv.contains("PATH"));
+        QCOMPARE(probes, 0);
+        QCOMPARE(lookups, 0);
+    }
+
+    void ProviderLauncherTest::revalidatesResolutionWhenExecutableChanges() {
+        qint64                                                 nowMs = 1000;
+        QString                                                launchedProgram;
+        QHash<QString, providers::ProviderLauncher::FileProbe> files{{"/usr/bin/bb-auth-ui", {100, true}}};
+        int                                                    probes = 0;
+
+        providers::ProviderLauncher launcher([&nowMs] { return nowMs; },
+                                             [&](const QString& program, const QStringList&, const QProcessEnvironment&) {
+                                                 launchedProgram = program;
+                                                 return true;
+                                             },
+                                             [&](const QString& path) {
+                                                 ++probes;
+                                                 return files.value(path);
+                                             },
+                                             [](const QString& name) { return name == "bb-auth-ui" ? QString("/usr/bin/bb-auth-ui") : QString(); });
+
+        const QList<providers::ProviderManifest> manifests{autostartManifest("absent", "/opt/bb-auth/ui", 20), autostartManifest("ui", "bb-auth-ui", 10)};
+        QCOMPARE(launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), "/bin/false").providerId, QString("ui"));
+
+        // Installed later; however long it has been, nothing is checked until a change is reported
+        files.insert("/opt/bb-auth/ui", {200, true});
+        probes = 0;
+        nowMs += 60000;
+        QCOMPARE(launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), "/bin/false").providerId, QString("ui"));
+        QCOMPARE(probes, 0);
+
+        launcher.invalidateExecutables();
+        QCOMPARE(launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), "/bin/false").providerId, QString("absent"));
+        QCOMPARE(launchedProgram, QString("/opt/bb-auth/ui"));
+    }
+
+    void ProviderLauncherTest::noticesInstalledExecutableThroughInotify() {
+        QTemporaryDir temp;
+        QVERIFY(temp.isValid());
+        const QString waiting = writeScript(temp, "waiting-ui", "exit 0\n");
+        QVERIFY(!waiting.isEmpty());
+
+        QString                     launchedProgram;
+        providers::ProviderLauncher launcher({}, [&](const QString& program, const QStringList&, const QProcessEnvironment&) {
+            launchedProgram = program;
+            return true;
+        });
+
+        const QString                            later = temp.filePath("later-ui");
+        const QList<providers::ProviderManifest> manifests{autostartManifest("later", later, 20), autostartManifest("waiting", waiting, 10)};
+        QCOMPARE(launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), "/bin/false").providerId, QString("waiting"));
+
+        // The directory it is installed into is watched, so the next launch finds it
+        QVERIFY(!writeScript(temp, "later-ui", "exit 0\n").isEmpty());
+        QTRY_COMPARE_WITH_TIMEOUT(launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), "/bin/false").providerId, QString("later"), 2000);
+        QCOMPARE(launchedProgram, later);
+    }
+
+    void ProviderLauncherTest::failedLaunchResolvesAgain() {
+        qint64                      nowMs   = 1000;
+        bool                        starts  = false;
+        int                         lookups = 0;
+
+        providers::ProviderLauncher launcher([&nowMs] { return nowMs; }, [&](const QString&, const QStringList&, const QProcessEnvironment&) { return starts; },
+                                             [](const QString& path) { return path == "/usr/bin/bb-auth-ui" ? providers::ProviderLauncher::FileProbe{100, true} : providers::ProviderLauncher::FileProbe{}; },
+                                             [&](const QString& name) {
+                                                 ++lookups;
+                                                 return name == "bb-auth-ui" ? QString("/usr/bin/bb-auth-ui") : QString();
+                                             });
+
+        const QList<providers::ProviderManifest> manifests{autostartManifest("ui", "bb-auth-ui", 10)};
+        QVERIFY(!launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), "/bin/false").launched);
+        QCOMPARE(lookups, 1);
+
+        // Past the backoff, the failed binary is looked up again rather than trusted
+        starts = true;
+        nowMs += 10000;
+        QVERIFY(launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), "/bin/false").launched);
+        QCOMPARE(lookups, 2);
+    }
+
+    void ProviderLauncherTest::throttledCandidateYieldsToNext() {
+        qint64                      nowMs = 1000;
+        QStringList                 started;
+
+        providers::ProviderLauncher launcher([&nowMs] { return nowMs; },
+                                             [&started](const QString& program, const QStringList&, const QProcessEnvironment&) {
+                                                 started << program;
+                                                 return program != "/bin/false";
+                                             });
+
+        const QList<providers::ProviderManifest> manifests{autostartManifest("broken", "/bin/false", 20), autostartManifest("working", "/bin/true", 10)};
+
+        const auto first = launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), QString());
+        QVERIFY(!first.launched);
+        QCOMPARE(first.providerId, QString("broken"));
+
+        const auto second = launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), QString());
+        QVERIFY(second.launched);
+        QCOMPARE(second.providerId, QString("working"));
+        QCOMPARE(started, QStringList({"/bin/false", "/bin/true"}));
+    }
+
+    void ProviderLauncherTest::supervisedEarlyExitMovesToNextCandidate() {
+        QTemporaryDir temp;
+        QVERIFY(temp.isValid());
+        const QString crashing = writeScript(temp, "crashing-ui", "exit 3\n");
+        const QString waiting  = writeScript(temp, "waiting-ui", "exec sleep 30\n");
+        QVERIFY(!crashing.isEmpty() && !waiting.isEmpty());
+
+        qint64                                   nowMs = 1000;
+        providers::ProviderLauncher              launcher([&nowMs] { return nowMs; });
+        const QList<providers::ProviderManifest> manifests{autostartManifest("crashing", crashing, 20), autostartManifest("waiting", waiting, 10)};
+
+        QList<providers::ProviderExit>           exits;
+        providers::LaunchAttemptResult           relaunch;
+        launcher.setExitHandler([&](const providers::ProviderExit& exit) {
+            exits << exit;
+            if (exit.beforeRegistration && exits.size() == 1) {
+                relaunch = launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "provider-exited", false, true, QString(), QString());
+            }
+        });
+
+        const auto first = launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), QString());
+        QVERIFY(first.launched);
+        if (first.pid == 0) {
+            QSKIP("pidfd is not available on this kernel");
+        }
+        QCOMPARE(first.providerId, QString("crashing"));
+
+        // Noticed through the pidfd as soon as it happens, not on a maintenance tick
+        QTRY_COMPARE_WITH_TIMEOUT(exits.size(), 1, 2000);
+        QCOMPARE(exits.first().providerId, QString("crashing"));
+        QCOMPARE(exits.first().pid, first.pid);
+        QCOMPARE(exits.first().status, QString("exited with status 3"));
+        QVERIFY(exits.first().beforeRegistration);
+
+        QVERIFY(relaunch.launched);
+        QCOMPARE(relaunch.providerId, QString("waiting"));
+        QVERIFY(relaunch.pid > 0);
+
+        ::kill(static_cast<pid_t>(relaunch.pid), SIGTERM);
+        QTRY_COMPARE_WITH_TIMEOUT(exits.size(), 2, 2000);
+        QCOMPARE(exits.last().status, QString("killed by signal %1").arg(SIGTERM));
+    }
+
+    void ProviderLauncherTest::supervisedExitAfterRegistrationIsNotAFailure() {
+        QTemporaryDir temp;
+        QVERIFY(temp.isValid());
+        const QString waiting = writeScript(temp, "waiting-ui", "exec sleep 30\n");
+        QVERIFY(!waiting.isEmpty());
+
+        qint64                                   nowMs = 1000;
+        providers::ProviderLauncher              launcher([&nowMs] { return nowMs; });
+        const QList<providers::ProviderManifest> manifests{autostartManifest("waiting", waiting, 10)};
+
+        QList<providers::ProviderExit>           exits;
+        launcher.setExitHandler([&](const providers::ProviderExit& exit) { exits << exit; });
+
+        const auto first = launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), QString());
+        QVERIFY(first.launched);
+        if (first.pid == 0) {
+            QSKIP("pidfd is not available on this kernel");
+        }
+
+        // A provider it did not start registering leaves the launch and its deadline alone
+        const auto deadlineMs = launcher.nextDeadlineMs();
+        QVERIFY(launcher.providerRegistered(::getpid()).providerId.isEmpty());
+        QVERIFY(launcher.providerRegistered().providerId.isEmpty());
+        QVERIFY(launcher.awaitingRegistration());
+        QCOMPARE(launcher.nextDeadlineMs(), deadlineMs);
+        QVERIFY(!launcher.registerLatencyMs("waiting"));
+
+        QCOMPARE(launcher.providerRegistered(first.pid).providerId, QString("waiting"));
+        ::kill(static_cast<pid_t>(first.pid), SIGTERM);
+        QTRY_COMPARE_WITH_TIMEOUT(exits.size(), 1, 2000);
+        QVERIFY(!exits.first().beforeRegistration);
+
+        // Not throttled: the same provider can be started again right away
+        const auto again = launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "provider-disconnect", false, true, QString(), QString());
+        QVERIFY(again.launched);
+        QCOMPARE(again.providerId, QString("waiting"));
+        ::kill(static_cast<pid_t>(again.pid), SIGTERM);
+        QTRY_COMPARE_WITH_TIMEOUT(exits.size(), 2, 2000);
+    }
+
+    void ProviderLauncherTest::missedRegistrationDeadlineFailsOver() {
+        qint64                      nowMs = 1000;
+        QStringList                 started;
+
+        providers::ProviderLauncher launcher([&nowMs] { return nowMs; }, [&started](const QString& program, const QStringList&, const QProcessEnvironment&) {
+            started << program;
+            return true;
+        });
+
+        auto hanging              = autostartManifest("hanging", "/bin/sleep", 20);
+        hanging.registerTimeoutMs = 2000;
+        const QList<providers::ProviderManifest> manifests{hanging, autostartManifest("slow", "/bin/cat", 10)};
+
+        const auto first = launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), "/bin/true");
+        QCOMPARE(first.providerId, QString("hanging"));
+        QCOMPARE(first.registerDeadlineMs, nowMs + 2000);
+        QVERIFY(launcher.awaitingRegistration());
+
+        nowMs += 1999;
+        QVERIFY(!launcher.expireRegistration());
+
+        nowMs += 1;
+        const auto timeout = launcher.expireRegistration();
+        QVERIFY(timeout);
+        QCOMPARE(timeout->providerId, QString("hanging"));
+        QCOMPARE(timeout->waitedMs, qint64(2000));
+        QVERIFY(!timeout->terminated);
+        QVERIFY(!launcher.awaitingRegistration());
+
+        const auto second = launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "register-timeout", false, true, QString(), "/bin/true");
+        QCOMPARE(second.providerId, QString("slow"));
+        QCOMPARE(second.registerDeadlineMs, nowMs + 10000);
+
+        // Both manifest providers missed their deadline; the built-in fallback is last
+        nowMs += 10000;
+        QVERIFY(launcher.expireRegistration());
+        const auto third = launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "register-timeout", false, true, QString(), "/bin/true");
+        QCOMPARE(third.providerId, QString("__legacy_default__"));
+        QCOMPARE(started, QStringList({"/bin/sleep", "/bin/cat", "/bin/true"}));
+    }
+
+    void ProviderLauncherTest::registrationDeadlineAdaptsToStartupTime() {
+        qint64                                   nowMs = 1000;
+        providers::ProviderLauncher              launcher([&nowMs] { return nowMs; }, [](const QString&, const QStringList&, const QProcessEnvironment&) { return true; });
+        const QList<providers::ProviderManifest> manifests{autostartManifest("ui", "/bin/true", 10)};
+
+        QVERIFY(!launcher.providerRegistered().latencyMs);
+        QVERIFY(!launcher.registerLatencyMs("ui"));
+
+        launcher.setDefaultRegisterDeadline(20000);
+        QCOMPARE(launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "session-created", false, true, QString(), QString()).registerDeadlineMs, nowMs + 20000);
+
+        nowMs += 800;
+        QCOMPARE(launcher.providerRegistered().latencyMs, std::optional<qint64>(800));
+        QCOMPARE(launcher.registerLatencyMs("ui"), std::optional<qint64>(800));
+
+        // Four times the startup would be 3200; a learned deadline never drops under 5 s
+        QCOMPARE(launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "provider-disconnect", false, true, QString(), QString()).registerDeadlineMs, nowMs + 5000);
+
+        // A slower start moves the estimate by a quarter of the difference, but sets the deadline in full
+        nowMs += 2400;
+        QCOMPARE(launcher.providerRegistered().latencyMs, std::optional<qint64>(2400));
+        QCOMPARE(launcher.registerLatencyMs("ui"), std::optional<qint64>(1200));
+        const auto slow = launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "provider-disconnect", false, true, QString(), QString());
+        QCOMPARE(slow.registerDeadlineMs, nowMs + 9600);
+
+        // Missing it raises the next deadline instead of tightening it
+        nowMs = slow.registerDeadlineMs;
+        QVERIFY(launcher.expireRegistration());
+        nowMs += 60000;
+        QCOMPARE(launcher.tryLaunch(manifests, "/tmp/bb-auth.sock", "register-timeout", false, true, QString(), QString()).registerDeadlineMs, nowMs + 38400);
+
+        // Without history the configured default applies, never under its own floor
+        launcher.setDefaultRegisterDeadline(100);
+        const QList<providers::ProviderManifest> other{autostartManifest("other", "/bin/true", 10)};
+        launcher.providerRegistered();
+        QCOMPARE(launcher.tryLaunch(other, "/tmp/bb-auth.sock", "session-created", false, true, QString(), QString()).registerDeadlineMs, nowMs + 1000);
+    }
+
+    void ProviderLauncherTest::supervisedProviderStoppedAtDeadline() {
+        QTemporaryDir temp;
+        QVERIFY(temp.isValid());
+        const QString silent = writeScript(temp, "silent-ui", "exec sleep 30\n");
+        QVERIFY(!silent.isEmpty());
+
+        qint64                         nowMs = 1000;
+        providers::ProviderLauncher    launcher([&nowMs] { return nowMs; });
+        auto                           manifest = autostartManifest("silent", silent, 10);
+        manifest.registerTimeoutMs              = 500;
+
+        QList<providers::ProviderExit> exits;
+        launcher.setExitHandler([&](const providers::ProviderExit& exit) { exits << exit; });
+
+        const auto first = launcher.tryLaunch({manifest}, "/tmp/bb-auth.sock", "session-created", false, true, QString(), QString());
+        QVERIFY(first.launched);
+        if (first.pid == 0) {
+            QSKIP("pidfd is not available on this kernel");
+        }
+
+        nowMs += 500;
+        const auto timeout = launcher.expireRegistration();
+        QVERIFY(timeout);
+        QVERIFY(timeout->terminated);
+
+        QTRY_COMPARE_WITH_TIMEOUT(exits.size(), 1, 2000);
+        QVERIFY(exits.first().beforeRegistration);
+        QVERIFY(exits.first().timedOut);
+        QCOMPARE(exits.first().status, QString("killed by signal %1").arg(SIGTERM));
+        QVERIFY(!launcher.nextDeadlineMs());
+
+        // Counted once, at the deadline; the exit must not restart the backoff
+        nowMs += 59999;
+        const auto again = launcher.tryLaunch({manifest}, "/tmp/bb-auth.sock", "register-timeout", false, true, QString(), QString());
+        QVERIFY(!again.attempted);
+        QVERIFY(again.detail.contains("throttled"));
+        nowMs += 1;
+        const auto retried = launcher.tryLaunch({manifest}, "/tmp/bb-auth.sock", "register-timeout", false, true, QString(), QString());
+        QVERIFY(retried.launched);
+        ::kill(static_cast<pid_t>(retried.pid), SIGKILL);
+        QTRY_COMPARE_WITH_TIMEOUT(exits.size(), 2, 2000);
+    }
+
+    void ProviderLauncherTest::supervisedProviderKilledAfterGrace() {
+        QTemporaryDir temp;
+        QVERIFY(temp.isValid());
+        // An ignored signal stays ignored across exec
+        const QString stubborn = writeScript(temp, "stubborn-ui", "trap '' TERM\nexec sleep 30\n");
+        QVERIFY(!stubborn.isEmpty());
+
+        qint64                         nowMs = 1000;
+        providers::ProviderLauncher    launcher([&nowMs] { return nowMs; });
+        auto                           manifest = autostartManifest("stubborn", stubborn, 10);
+        manifest.registerTimeoutMs              = 500;
+
+        QList<providers::ProviderExit> exits;
+        launcher.setExitHandler([&](const providers::ProviderExit& exit) { exits << exit; });
+
+        const auto first = launcher.tryLaunch({manifest}, "/tmp/bb-auth.sock", "session-created", false, true, QString(), QString());
+        QVERIFY(first.launched);
+        if (first.pid == 0) {
+            QSKIP("pidfd is not available on this kernel");
+        }
+
+        nowMs += 500;
+        const auto timeout = launcher.expireRegistration();
+        QVERIFY(timeout);
+        QVERIFY(timeout->terminated);
+        QCOMPARE(launcher.nextDeadlineMs(), std::optional<qint64>(nowMs + 2000));
+
+        // Shrugged off SIGTERM; the grace period ends in SIGKILL
+        QTest::qWait(200);
+        QVERIFY(exits.isEmpty());
+        nowMs += 2000;
+        QVERIFY(!launcher.expireRegistration());
+        QTRY_COMPARE_WITH_TIMEOUT(exits.size(), 1, 2000);
+        QVERIFY(exits.first().timedOut);
+        QCOMPARE(exits.first().status, QString("killed by signal %1").arg(SIGKILL));
+        QVERIFY(!launcher.nextDeadlineMs());
+    }
+
+    void ProviderLauncherTest::hedgedFallbackWinsWhenPreferredIsSlow() {
+        QTemporaryDir temp;
+        QVERIFY(temp.isValid());
+        const QString preferred = writeScript(temp, "preferred-ui", "exec sleep 30\n");
+        const QString fallback  = writeScript(temp, "bb-auth-fallback", "exec sleep 30\n");
+        QVERIFY(!preferred.isEmpty() && !fallback.isEmpty());
+
+        qint64                         nowMs = 1000;
+        providers::ProviderLauncher    launcher([&nowMs] { return nowMs; });
+        QList<providers::ProviderExit> exits;
+        launcher.setExitHandler([&](const providers::ProviderExit& exit) { exits << exit; });
+        launcher.setHedgeDelay(300);
+
+        const auto first = launcher.tryLaunch({autostartManifest("preferred", preferred, 100)}, "/tmp/bb-auth.sock", "session-created", false, true, QString(), fallback);
+        QVERIFY(first.launched);
+        if (first.pid == 0) {
+            QSKIP("pidfd is not available on this kernel");
+        }
+        QCOMPARE(first.hedgeAtMs, nowMs + 300);
+        QCOMPARE(launcher.nextDeadlineMs(), std::optional<qint64>(nowMs + 300));
+
+        nowMs += 299;
+        QVERIFY(!launcher.startHedge());
+
+        nowMs += 1;
+        const auto hedge = launcher.startHedge();
+        QVERIFY(hedge && hedge->launched);
+        QCOMPARE(hedge->providerId, QString("__legacy_default__"));
+        QVERIFY(hedge->pid > 0 && hedge->pid != first.pid);
+        QVERIFY(launcher.awaitingRegistration());
+
+        nowMs += 200;
+        const auto won = launcher.providerRegistered(hedge->pid);
+        QCOMPARE(won.providerId, QString("__legacy_default__"));
+        QCOMPARE(won.latencyMs, std::optional<qint64>(200));
+        QVERIFY(!won.superseded);
+        QCOMPARE(won.supersededPid, first.pid);
+        QVERIFY(!launcher.awaitingRegistration());
+
+        // The preferred provider came up second and is told to go rather than taking over
+        const auto lost = launcher.providerRegistered(first.pid);
+        QVERIFY(lost.superseded);
+        QVERIFY(lost.providerId.isEmpty());
+
+        ::kill(static_cast<pid_t>(first.pid), SIGTERM);
+        QTRY_COMPARE_WITH_TIMEOUT(exits.size(), 1, 2000);
+        QVERIFY(exits.first().superseded);
+
+        // Losing the race is not a failure
+        const auto again = launcher.tryLaunch({autostartManifest("preferred", preferred, 100)}, "/tmp/bb-auth.sock", "provider-disconnect", false, true, QString(), QString());
+        QVERIFY(again.launched);
+        QCOMPARE(again.providerId, QString("preferred"));
+        QCOMPARE(again.hedgeAtMs, qint64(0));
+
+        ::kill(static_cast<pid_t>(hedge->pid), SIGTERM);
+        ::kill(static_cast<pid_t>(again.pid), SIGTERM);
+        QTRY_COMPARE_WITH_TIMEOUT(exits.size(), 3, 2000);
+    }
+
+    void ProviderLauncherTest::preferredWinningStopsHedgeThatNeverRegisters() {
+        QTemporaryDir temp;
+        QVERIFY(temp.isValid());
+        const QString preferred = writeScript(temp, "preferred-ui", "exec sleep 30\n");
+        const QString fallback  = writeScript(temp, "bb-auth-fallback", "exec sleep 30\n");
+        QVERIFY(!preferred.isEmpty() && !fallback.isEmpty());
+
+        qint64                         nowMs = 1000;
+        providers::ProviderLauncher    launcher([&nowMs] { return nowMs; });
+        QList<providers::ProviderExit> exits;
+        launcher.setExitHandler([&](const providers::ProviderExit& exit) { exits << exit; });
+        launcher.setHedgeDelay(300);
+
+        const auto first = launcher.tryLaunch({autostartManifest("preferred", preferred, 100)}, "/tmp/bb-auth.sock", "session-created", false, true, QString(), fallback);
+        if (first.pid == 0) {
+            QSKIP("pidfd is not available on this kernel");
+        }
+
+        nowMs += 300;
+        const auto hedge = launcher.startHedge();
+        QVERIFY(hedge && hedge->launched);
+
+        nowMs += 100;
+        const auto won = launcher.providerRegistered(first.pid);
+        QCOMPARE(won.providerId, QString("preferred"));
+        QCOMPARE(won.supersededPid, hedge->pid);
+        QCOMPARE(launcher.nextDeadlineMs(), std::optional<qint64>(hedge->registerDeadlineMs));
+
+        // Never registered, so it could not be told; it is stopped at its own deadline instead
+        nowMs = hedge->registerDeadlineMs;
+        QVERIFY(!launcher.expireRegistration());
+        QTRY_COMPARE_WITH_TIMEOUT(exits.size(), 1, 2000);
+        QCOMPARE(exits.first().pid, hedge->pid);
+        QVERIFY(exits.first().superseded);
+        QCOMPARE(exits.first().status, QString("killed by signal %1").arg(SIGTERM));
+        QVERIFY(!launcher.nextDeadlineMs());
+
+        ::kill(static_cast<pid_t>(first.pid), SIGTERM);
+        QTRY_COMPARE_WITH_TIMEOUT(exits.size(), 2, 2000);
+    }
+
+    void ProviderLauncherTest::preconnectedProviderInheritsConnection() {
+        QTemporaryDir temp;
+        QVERIFY(temp.isValid());
+        // Reports over the inherited connection which descriptor it was told about
+        const QString provider = writeScript(temp, "preconnected-ui", "printf '%s' \"$BB_AUTH_PROVIDER_FD\" >&3\nexec sleep 30\n");
+        QVERIFY(!provider.isEmpty());
+
+        qint64                         nowMs = 1000;
+        providers::ProviderLauncher    launcher([&nowMs] { return nowMs; });
+        QList<providers::ProviderExit> exits;
+        launcher.setExitHandler([&](const providers::ProviderExit& exit) { exits << exit; });
+
+        providers::ProviderManifest manifest = autostartManifest("preconnected", provider, 60);
+        manifest.capabilities << "preconnected";
+        const auto launch = launcher.tryLaunch({manifest}, "/tmp/bb-auth.sock", "session-created", false, true, QString(), QString());
+        QVERIFY(launch.launched);
+        if (launch.pid == 0) {
+            QSKIP("pidfd is not available on this kernel");
+        }
+
+        QVERIFY(launch.handoffFd >= 0);
+        QCOMPARE(launch.handoffRegistration.value("type").toString(), QString("ui.register"));
+        QCOMPARE(launch.handoffRegistration.value("name").toString(), QString("preconnected"));
+        QCOMPARE(launch.handoffRegistration.value("kind").toString(), QString("fallback"));
+        QCOMPARE(launch.handoffRegistration.value("priority").toInt(), 60);
+
+        pollfd     readable{launch.handoffFd, POLLIN, 0};
+        char       buffer[8] = {};
+        const bool ready     = ::poll(&readable, 1, 2000) == 1;
+        const auto received  = ready ? ::read(launch.handoffFd, buffer, sizeof(buffer) - 1) : -1;
+        ::close(launch.handoffFd);
+        ::kill(static_cast<pid_t>(launch.pid), SIGTERM);
+        QTRY_COMPARE_WITH_TIMEOUT(exits.size(), 1, 2000);
+        QVERIFY(received > 0);
+        QCOMPARE(QByteArray(buffer), QByteArray::number(PROVIDER_HANDOFF_FD));
+
+        // Without the capability the provider connects on its own, as before
+        manifest.capabilities.clear();
+        nowMs += 60000;
+        const auto plain = launcher.tryLaunch({manifest}, "/tmp/bb-auth.sock", "session-created", false, true, QString(), QString());
+        QVERIFY(plain.launched);
+        QCOMPARE(plain.handoffFd, -1);
+        QVERIFY(plain.handoffRegistration.isEmpty());
+        ::kill(static_cast<pid_t>(plain.pid), SIGTERM);
+        QTRY_COMPARE_WITH_TIMEOUT(exits.size(), 2, 2000);
+
+        // Nor does a BB_AUTH_FALLBACK_PATH override, which never opted in
+        nowMs += 60000;
+        const auto overridden = launcher.tryLaunch({}, "/tmp/bb-auth.sock", "session-created", false, true, provider, QString());
+        QVERIFY(overridden.launched);
+        QCOMPARE(overridden.handoffFd, -1);
+        QVERIFY(overridden.handoffRegistration.isEmpty());
+        ::kill(static_cast<pid_t>(overridden.pid), SIGTERM);
+        QTRY_COMPARE_WITH_TIMEOUT(exits.size(), 3, 2000);
+    }
+
 } // namespace bb
 
 int runProviderLauncherTests(int argc, char** argv) {
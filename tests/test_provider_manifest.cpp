@@ -17,6 +17,7 @@ namespace bb {
         void rejectInvalidExecPath();
         void rejectInvalidArgs();
         void rejectInvalidEnv();
+        void rejectOutOfRangeRegisterTimeout();
     };
 
     void ProviderManifestTest::parseValidManifest() {
@@ -29,6 +30,7 @@ namespace bb {
         "args":["--socket","/tmp/socket"],
         "env":{"GTK_THEME":"Adwaita:dark"},
         "autostart":false,
+        "registerTimeoutMs":4000,
         "capabilities":["password","status"]
     })";
 
@@ -42,6 +44,7 @@ namespace bb {
         QCOMPARE(result.manifest.args, QStringList({"--socket", "/tmp/socket"}));
         QCOMPARE(result.manifest.env.value("GTK_THEME").toString(), QString("Adwaita:dark"));
         QCOMPARE(result.manifest.autostart, false);
+        QCOMPARE(result.manifest.registerTimeoutMs, 4000);
         QCOMPARE(result.manifest.capabilities, QStringList({"password", "status"}));
         QCOMPARE(result.manifest.sourcePath, QString("/tmp/gtk-fallback.json"));
         QVERIFY(result.manifest.isValid());
@@ -59,6 +62,7 @@ namespace bb {
         QVERIFY(result.ok);
         QCOMPARE(result.manifest.priority, 0);
         QCOMPARE(result.manifest.autostart, true);
+        QCOMPARE(result.manifest.registerTimeoutMs, 0);
         QVERIFY(result.manifest.args.isEmpty());
         QVERIFY(result.manifest.env.isEmpty());
         QVERIFY(result.manifest.capabilities.isEmpty());
@@ -150,6 +154,20 @@ namespace bb {
         QCOMPARE(result.error, QString("env values must be strings"));
     }
 
+    void ProviderManifestTest::rejectOutOfRangeRegisterTimeout() {
+        const QByteArray json = R"({
+        "id":"bad-timeout",
+        "name":"Bad",
+        "kind":"fallback",
+        "exec":"bb-auth-fallback",
+        "registerTimeoutMs":50
+    })";
+
+        const auto       result = providers::parseProviderManifest(json);
+        QVERIFY(!result.ok);
+        QCOMPARE(result.error, QString("registerTimeoutMs must be an integer within [100, 120000]"));
+    }
+
 } // namespace bb
 
 int runProviderManifestTests(int argc, char** argv) {
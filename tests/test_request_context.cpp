@@ -1,6 +1,101 @@
 #include "../src/core/RequestContext.hpp"
 #include <QtTest/QtTest>
 
+#include <csignal>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int openPidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    Q_UNUSED(pid)
+    return -1;
+#endif
+}
+
+// Previous RequestContextHelper::readProc, kept as the parity reference and benchmark baseline
+static std::optional<ProcInfo> legacyReadProc(qint64 pid) {
+    ProcInfo info;
+    info.pid = pid;
+
+    QFile fStat(QString("/proc/%1/status").arg(pid));
+    if (!fStat.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+    const QStringList lines = QString::fromUtf8(fStat.readAll()).split('\n');
+    for (const auto& line : lines) {
+        if (line.startsWith("Name:")) {
+            info.name = line.section(':', 1).trimmed();
+        } else if (line.startsWith("PPid:")) {
+            info.ppid = line.section(':', 1).trimmed().toLongLong();
+        } else if (line.startsWith("Uid:")) {
+            QStringList parts = line.section(':', 1).simplified().split(' ');
+            if (parts.size() >= 1)
+                info.uid = parts[0].toLongLong();
+            if (parts.size() >= 2)
+                info.euid = parts[1].toLongLong();
+        }
+    }
+
+    info.exe = QFileInfo(QString("/proc/%1/exe").arg(pid)).symLinkTarget();
+
+    QFile fCmd(QString("/proc/%1/cmdline").arg(pid));
+    if (fCmd.open(QIODevice::ReadOnly)) {
+        QStringList cleanArgs;
+        for (const auto& a : fCmd.readAll().split('\0'))
+            if (!a.isEmpty())
+                cleanArgs << QString::fromUtf8(a);
+        info.cmdline = cleanArgs.join(" ");
+    }
+
+    return info;
+}
+
+// Fork a chain of nested processes, each the parent of the next; pids from outermost to innermost
+// The chain is its own process group, so killProcessChain() takes all of it down
+static QList<pid_t> spawnProcessChain(int depth) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return {};
+    }
+
+    const pid_t top = fork();
+    if (top == 0) {
+        setpgid(0, 0);
+        for (int level = 1;; ++level) {
+            const pid_t self = getpid();
+            if (write(fds[1], &self, sizeof(self)) != sizeof(self) || level == depth) {
+                pause();
+                _exit(0);
+            }
+            const pid_t child = fork();
+            if (child != 0) {
+                waitpid(child, nullptr, 0);
+                _exit(0);
+            }
+        }
+    }
+
+    close(fds[1]);
+    QList<pid_t> chain;
+    pid_t        pid = 0;
+    while (top > 0 && chain.size() < depth && read(fds[0], &pid, sizeof(pid)) == sizeof(pid)) {
+        chain << pid;
+    }
+    close(fds[0]);
+    return chain;
+}
+
+static void killProcessChain(const QList<pid_t>& chain) {
+    if (chain.isEmpty()) {
+        return;
+    }
+    killpg(chain.first(), SIGKILL);
+    waitpid(chain.first(), nullptr, 0);
+}
+
 class RequestContextTest : public QObject {
     Q_OBJECT
 
@@ -8,6 +103,15 @@ class RequestContextTest : public QObject {
     void testSpoofedProcessName();
     void testUnreadableExeSpoofingAttempt();
     void testRealPkexecFallback();
+    void testPidfdReadProcReadsLiveProcess();
+    void testPidfdReadProcRejectsExitedProcess();
+    void testReadProcMatchesLegacyReader();
+    void testReadProcStartTimeTellsProcessesApart();
+    void benchmark_resolveDeepProcessTree();
+    void benchmark_resolveDeepProcessTreeLegacy();
+
+  private:
+    void resolveDeepProcessTree(const std::function<std::optional<ProcInfo>(qint64)>& procReader);
 };
 
 void RequestContextTest::testSpoofedProcessName() {
@@ -119,6 +223,106 @@ void RequestContextTest::testRealPkexecFallback() {
     QCOMPARE(result.proc.pid, 101);
 }
 
+void RequestContextTest::testPidfdReadProcReadsLiveProcess() {
+    const int pidfd = openPidfd(getpid());
+    if (pidfd < 0) {
+        QSKIP("pidfd_open not supported by this kernel");
+    }
+
+    const auto info = RequestContextHelper::readProc(getpid(), pidfd);
+    close(pidfd);
+
+    QVERIFY(info.has_value());
+    QCOMPARE(info->pid, static_cast<qint64>(getpid()));
+}
+
+void RequestContextTest::testPidfdReadProcRejectsExitedProcess() {
+    const pid_t child = fork();
+    QVERIFY(child >= 0);
+    if (child == 0) {
+        _exit(0);
+    }
+
+    // The unreaped zombie keeps both the pid and /proc/<pid> around
+    const int pidfd = openPidfd(child);
+    if (pidfd < 0) {
+        waitpid(child, nullptr, 0);
+        QSKIP("pidfd_open not supported by this kernel");
+    }
+
+    siginfo_t info{};
+    QCOMPARE(waitid(P_PID, static_cast<id_t>(child), &info, WEXITED | WNOWAIT), 0);
+
+    const auto proc = RequestContextHelper::readProc(child, pidfd);
+    close(pidfd);
+    waitpid(child, nullptr, 0);
+
+    QVERIFY(!proc.has_value());
+}
+
+void RequestContextTest::testReadProcMatchesLegacyReader() {
+    const QList<pid_t> chain = spawnProcessChain(3);
+    const auto         cleanup = qScopeGuard([&] { killProcessChain(chain); });
+    QCOMPARE(chain.size(), 3);
+
+    for (const qint64 pid : {static_cast<qint64>(getpid()), static_cast<qint64>(getppid()), static_cast<qint64>(chain.last())}) {
+        const auto expected = legacyReadProc(pid);
+        const auto actual   = RequestContextHelper::readProc(pid);
+        QVERIFY(expected.has_value());
+        QVERIFY(actual.has_value());
+        QCOMPARE(actual->pid, expected->pid);
+        QCOMPARE(actual->ppid, expected->ppid);
+        QCOMPARE(actual->uid, expected->uid);
+        QCOMPARE(actual->euid, expected->euid);
+        QCOMPARE(actual->name, expected->name);
+        QCOMPARE(actual->exe, expected->exe);
+        QCOMPARE(actual->cmdline, expected->cmdline);
+    }
+
+    QVERIFY(!RequestContextHelper::readProc(0).has_value());
+}
+
+void RequestContextTest::testReadProcStartTimeTellsProcessesApart() {
+    const auto self = RequestContextHelper::readProc(getpid());
+    QVERIFY(self.has_value());
+    QVERIFY(self->startTime > 0);
+    QCOMPARE(RequestContextHelper::readProc(getpid())->startTime, self->startTime);
+
+    // Started after this process, so its start time can't be earlier
+    const QList<pid_t> chain   = spawnProcessChain(1);
+    const auto         cleanup = qScopeGuard([&] { killProcessChain(chain); });
+    QCOMPARE(chain.size(), 1);
+
+    const auto child = RequestContextHelper::readProc(chain.first());
+    QVERIFY(child.has_value());
+    QVERIFY(child->startTime >= self->startTime);
+    QCOMPARE(child->ppid, static_cast<qint64>(getpid()));
+}
+
+void RequestContextTest::resolveDeepProcessTree(const std::function<std::optional<ProcInfo>(qint64)>& procReader) {
+    // Deeper than the 16 hops resolution walks, so every iteration reads the full limit
+    const QList<pid_t> chain   = spawnProcessChain(16);
+    const auto         cleanup = qScopeGuard([&] { killProcessChain(chain); });
+    QCOMPARE(chain.size(), 16);
+
+    const auto subject = procReader(chain.last());
+    QVERIFY(subject.has_value());
+
+    ActorInfo actor;
+    QBENCHMARK {
+        actor = RequestContextHelper::resolveRequestorFromSubject(*subject, getuid(), procReader);
+    }
+    QVERIFY(actor.proc.pid > 0);
+}
+
+void RequestContextTest::benchmark_resolveDeepProcessTree() {
+    resolveDeepProcessTree([](qint64 pid) { return RequestContextHelper::readProc(pid); });
+}
+
+void RequestContextTest::benchmark_resolveDeepProcessTreeLegacy() {
+    resolveDeepProcessTree(legacyReadProc);
+}
+
 // We need an entry point.
 int runRequestContextTests(int argc, char** argv) {
     RequestContextTest test;
@@ -0,0 +1,108 @@
+#include "../src/core/agent/RequestorResolver.hpp"
+
+#include <QtTest/QtTest>
+
+#include <QMutex>
+#include <QSemaphore>
+#include <QThread>
+
+#include <algorithm>
+#include <memory>
+
+namespace bb {
+
+    namespace {
+
+        struct Delivery {
+            QString   sessionId;
+            qint64    pid = 0;
+            ActorInfo actor;
+            QThread*  thread = nullptr;
+        };
+
+        ActorInfo actorNamed(const QString& name) {
+            ActorInfo actor;
+            actor.displayName    = name;
+            actor.fallbackLetter = name.left(1).toUpper();
+            return actor;
+        }
+
+    } // namespace
+
+    class RequestorResolverTest : public QObject {
+        Q_OBJECT
+
+      private slots:
+        void resolve_returnsBeforeResolutionFinishes();
+        void resolve_passesPidfdToWorker();
+        void destroyedResolver_dropsQueuedResults();
+    };
+
+    void RequestorResolverTest::resolve_returnsBeforeResolutionFinishes() {
+        QSemaphore               release;
+        QThread*                 worker = nullptr;
+        agent::RequestorResolver resolver([&](qint64 pid, int) {
+            worker = QThread::currentThread();
+            release.acquire();
+            return actorNamed("app-" + QString::number(pid));
+        });
+
+        QList<Delivery> deliveries;
+        connect(&resolver, &agent::RequestorResolver::resolved, this,
+                [&](const QString& id, qint64 pid, const ActorInfo& actor) { deliveries.append({id, pid, actor, QThread::currentThread()}); });
+
+        resolver.resolve("session-a", 321);
+        QCoreApplication::processEvents();
+        QVERIFY(deliveries.isEmpty());
+
+        release.release();
+        QTRY_COMPARE(deliveries.size(), 1);
+        QCOMPARE(deliveries.first().sessionId, QStringLiteral("session-a"));
+        QCOMPARE(deliveries.first().pid, 321);
+        QCOMPARE(deliveries.first().actor.displayName, QStringLiteral("app-321"));
+        QVERIFY(worker != nullptr);
+        QVERIFY(worker != QThread::currentThread());
+        QCOMPARE(deliveries.first().thread, QThread::currentThread());
+    }
+
+    void RequestorResolverTest::resolve_passesPidfdToWorker() {
+        QList<int>               pidfds;
+        QMutex                   mutex;
+        agent::RequestorResolver resolver([&](qint64, int pidfd) {
+            QMutexLocker lock(&mutex);
+            pidfds.append(pidfd);
+            return ActorInfo{};
+        });
+
+        int delivered = 0;
+        connect(&resolver, &agent::RequestorResolver::resolved, this, [&] { ++delivered; });
+
+        resolver.resolve("with-pidfd", 10, std::make_shared<const int>(77));
+        resolver.resolve("without-pidfd", 11);
+        QTRY_COMPARE(delivered, 2);
+
+        std::sort(pidfds.begin(), pidfds.end());
+        QCOMPARE(pidfds, (QList<int>{-1, 77}));
+    }
+
+    void RequestorResolverTest::destroyedResolver_dropsQueuedResults() {
+        int  delivered = 0;
+        auto resolver  = std::make_unique<agent::RequestorResolver>([](qint64 pid, int) { return actorNamed(QString::number(pid)); });
+        connect(resolver.get(), &agent::RequestorResolver::resolved, this, [&] { ++delivered; });
+
+        resolver->resolve("closed-session", 5);
+        resolver->waitForIdle();
+        resolver.reset();
+
+        QCoreApplication::processEvents();
+        QCOMPARE(delivered, 0);
+    }
+
+} // namespace bb
+
+int runRequestorResolverTests(int argc, char** argv) {
+    bb::RequestorResolverTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "test_requestor_resolver.moc"
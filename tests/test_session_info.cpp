@@ -2,6 +2,7 @@
 
 #include <QtTest/QtTest>
 #include <QApplication>
+#include <QStandardPaths>
 
 int runFallbackWindowTouchModelTests(int argc, char** argv);
 int runFallbackWindowStateTests(int argc, char** argv);
@@ -10,12 +11,19 @@ int runIpcContractTests(int argc, char** argv);
 int runProviderManifestTests(int argc, char** argv);
 int runProviderDiscoveryTests(int argc, char** argv);
 int runProviderLauncherTests(int argc, char** argv);
+int runFallbackStandbyTests(int argc, char** argv);
 int runProviderConformanceTests(int argc, char** argv);
 int runTextNormalizeTests(int argc, char** argv);
 int runSessionStoreTests(int argc, char** argv);
 int runClassifyRequestTests(int argc, char** argv);
 int runPromptExtractorsTests(int argc, char** argv);
 int runRequestContextTests(int argc, char** argv);
+int runFrameReaderTests(int argc, char** argv);
+int runDesktopIndexTests(int argc, char** argv);
+int runDesktopEntryTests(int argc, char** argv);
+int runProcessCacheTests(int argc, char** argv);
+int runRequestorResolverTests(int argc, char** argv);
+int runIdleWakeupTests(int argc, char** argv);
 
 class SessionInfoTest : public QObject {
     Q_OBJECT
@@ -74,21 +82,30 @@ void SessionInfoTest::updatedEventCanContainErrorAndInfo() {
 
 int main(int argc, char** argv) {
     QApplication    app(argc, argv);
+    // The desktop index snapshot and application directories resolve under ~/.qttest, not the user's own
+    QStandardPaths::setTestModeEnabled(true);
     SessionInfoTest sessionInfoTest;
-    const int       sessionResult        = QTest::qExec(&sessionInfoTest, argc, argv);
-    const int       routingResult        = runAgentRoutingTests(argc, argv);
-    const int       fallbackResult       = runFallbackWindowTouchModelTests(argc, argv);
-    const int       fallbackStateResult  = runFallbackWindowStateTests(argc, argv);
-    const int       storeResult          = runSessionStoreTests(argc, argv);
-    const int       classifyResult       = runClassifyRequestTests(argc, argv);
-    const int       extractorsResult     = runPromptExtractorsTests(argc, argv);
-    const int       requestContextResult = runRequestContextTests(argc, argv);
-    const int       normalizeResult      = runTextNormalizeTests(argc, argv);
-    const int       manifestResult       = runProviderManifestTests(argc, argv);
-    const int       discoveryResult      = runProviderDiscoveryTests(argc, argv);
-    const int       launcherResult       = runProviderLauncherTests(argc, argv);
-    const int       conformanceResult    = runProviderConformanceTests(argc, argv);
-    const int       ipcContractResult    = runIpcContractTests(argc, argv);
+    const int       sessionResult           = QTest::qExec(&sessionInfoTest, argc, argv);
+    const int       routingResult           = runAgentRoutingTests(argc, argv);
+    const int       fallbackResult          = runFallbackWindowTouchModelTests(argc, argv);
+    const int       fallbackStateResult     = runFallbackWindowStateTests(argc, argv);
+    const int       storeResult             = runSessionStoreTests(argc, argv);
+    const int       classifyResult          = runClassifyRequestTests(argc, argv);
+    const int       extractorsResult        = runPromptExtractorsTests(argc, argv);
+    const int       requestContextResult    = runRequestContextTests(argc, argv);
+    const int       normalizeResult         = runTextNormalizeTests(argc, argv);
+    const int       manifestResult          = runProviderManifestTests(argc, argv);
+    const int       discoveryResult         = runProviderDiscoveryTests(argc, argv);
+    const int       launcherResult          = runProviderLauncherTests(argc, argv);
+    const int       standbyResult           = runFallbackStandbyTests(argc, argv);
+    const int       conformanceResult       = runProviderConformanceTests(argc, argv);
+    const int       ipcContractResult       = runIpcContractTests(argc, argv);
+    const int       frameReaderResult       = runFrameReaderTests(argc, argv);
+    const int       desktopIndexResult      = runDesktopIndexTests(argc, argv);
+    const int       desktopEntryResult      = runDesktopEntryTests(argc, argv);
+    const int       processCacheResult      = runProcessCacheTests(argc, argv);
+    const int       requestorResolverResult = runRequestorResolverTests(argc, argv);
+    const int       idleWakeupResult        = runIdleWakeupTests(argc, argv);
     if (sessionResult != 0) {
         return sessionResult;
     }
@@ -125,10 +142,31 @@ int main(int argc, char** argv) {
     if (launcherResult != 0) {
         return launcherResult;
     }
+    if (standbyResult != 0) {
+        return standbyResult;
+    }
     if (conformanceResult != 0) {
         return conformanceResult;
     }
-    return ipcContractResult;
+    if (ipcContractResult != 0) {
+        return ipcContractResult;
+    }
+    if (frameReaderResult != 0) {
+        return frameReaderResult;
+    }
+    if (desktopIndexResult != 0) {
+        return desktopIndexResult;
+    }
+    if (desktopEntryResult != 0) {
+        return desktopEntryResult;
+    }
+    if (processCacheResult != 0) {
+        return processCacheResult;
+    }
+    if (requestorResolverResult != 0) {
+        return requestorResolverResult;
+    }
+    return idleWakeupResult;
 }
 
 #include "test_session_info.moc"
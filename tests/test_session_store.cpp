@@ -9,6 +9,8 @@ class SessionStoreTest : public QObject {
   private slots:
     void createSession_rejectsDuplicateId();
     void createSession_rejectsDuplicateIdAcrossSources();
+    void updateRequestor_replacesProvisionalRequestor();
+    void updateRequestor_ignoresOtherProcess();
 };
 
 void SessionStoreTest::createSession_rejectsDuplicateId() {
@@ -39,6 +41,59 @@ void SessionStoreTest::createSession_rejectsDuplicateIdAcrossSources() {
     QCOMPARE(store.size(), 1);
 }
 
+void SessionStoreTest::updateRequestor_replacesProvisionalRequestor() {
+    agent::SessionStore store;
+    const QString       id = "keyring-session";
+
+    Session::Context ctx;
+    ctx.requestor.pid = 4242;
+    const auto created = store.createSession(id, Session::Source::Keyring, ctx);
+    QVERIFY(created.has_value());
+    const QJsonObject provisional = created->value("context").toObject().value("requestor").toObject();
+    QCOMPARE(provisional.value("pid").toInteger(), 4242);
+    QVERIFY(provisional.value("name").toString().isEmpty());
+
+    store.updatePrompt(id, "Password:", false, true);
+
+    Session::Requestor requestor;
+    requestor.name           = "Firefox";
+    requestor.icon           = "firefox";
+    requestor.fallbackLetter = "F";
+    requestor.fallbackKey    = "firefox.desktop";
+    requestor.pid            = 4242;
+
+    const auto updated = store.updateRequestor(id, requestor);
+    QVERIFY(updated.has_value());
+    QCOMPARE(updated->value("type").toString(), QStringLiteral("session.updated"));
+    QCOMPARE(updated->value("prompt").toString(), QStringLiteral("Password:"));
+
+    const QJsonObject resolved = updated->value("requestor").toObject();
+    QCOMPARE(resolved.value("name").toString(), QStringLiteral("Firefox"));
+    QCOMPARE(resolved.value("icon").toString(), QStringLiteral("firefox"));
+    QCOMPARE(resolved.value("fallbackKey").toString(), QStringLiteral("firefox.desktop"));
+    QCOMPARE(resolved.value("pid").toInteger(), 4242);
+    QCOMPARE(store.getSession(id)->requestor().name, QStringLiteral("Firefox"));
+}
+
+void SessionStoreTest::updateRequestor_ignoresOtherProcess() {
+    agent::SessionStore store;
+    const QString       id = "reused-cookie";
+
+    Session::Context ctx;
+    ctx.requestor.pid = 100;
+    QVERIFY(store.createSession(id, Session::Source::Pinentry, ctx).has_value());
+
+    // A late result for an earlier session that used the same id
+    Session::Requestor stale;
+    stale.name = "Stale";
+    stale.pid  = 99;
+    QVERIFY(!store.updateRequestor(id, stale).has_value());
+    QVERIFY(store.getSession(id)->requestor().name.isEmpty());
+
+    stale.pid = 100;
+    QVERIFY(!store.updateRequestor("missing", stale).has_value());
+}
+
 } // namespace bb
 
 int runSessionStoreTests(int argc, char** argv) {